@@ -2,9 +2,9 @@
 import os
 from jinja2 import Template
 
-# Get list of files from a directory
-def get_files_from_directory(directory):
-    return [f[:f.index('.')] for f in os.listdir(directory) if os.path.isfile(os.path.join(directory, f))]
+# Get list of files from a directory, only files ending in extension if it is given
+def get_files_from_directory(directory, extension=None):
+    return [f[:f.index('.')] for f in os.listdir(directory) if os.path.isfile(os.path.join(directory, f)) and (extension is None or f.endswith(extension))]
 
 # Define the Jinja template
 template_string = """cc_library(
@@ -18,7 +18,7 @@ template_string = """cc_library(
 cc_test(
     name = "{{ test_file }}", 
     size = "small",
-    srcs = ["tests/{{ test_file }}.cc"], 
+    srcs = ["tests/{{ test_file }}.cc"{% for file in test_hdr_files %}, "tests/{{ file }}.h"{% endfor %}], 
     deps = [
         ":source",
         "@googletest//:gtest",
@@ -26,21 +26,32 @@ cc_test(
     ]
 )
 {% endfor %}
+{% for benchmark_file in benchmark_files %}
+cc_binary(
+    name = "{{ benchmark_file }}", 
+    srcs = ["benchmarks/{{ benchmark_file }}.cc"], 
+    deps = [":source"]
+)
+{% endfor %}
 """
 
 # Directories
 src_directory = 'src'
 inc_directory = 'inc'
 tests_directory = 'tests'
+benchmarks_directory = 'benchmarks'
 
 # Get lists of files
 src_files = get_files_from_directory(src_directory)
 hdr_files = get_files_from_directory(inc_directory)
-test_files = get_files_from_directory(tests_directory)
+# Headers in the tests directory are fixtures shared between tests
+test_files = get_files_from_directory(tests_directory, '.cc')
+test_hdr_files = get_files_from_directory(tests_directory, '.h')
+benchmark_files = get_files_from_directory(benchmarks_directory, '.cc')
 
 # Create a Jinja Template object and render the content
 template = Template(template_string)
-output = template.render(src_files=src_files, hdr_files=hdr_files, test_files=test_files)
+output = template.render(src_files=src_files, hdr_files=hdr_files, test_files=test_files, test_hdr_files=test_hdr_files, benchmark_files=benchmark_files)
 
 # Write the generated content to a file
 output_file = 'BUILD'  # You can change the filename as needed
@@ -0,0 +1,193 @@
+// Times building and traversing the bounding volume hierarchy at widths 2, 4 and 8, the numbers BVH_WIDTH is chosen from
+// Each scene is traversed one primitive at a time like groups and the world(leaves of BVH_MIN_LEAF_SIZE) and one leaf at
+// a time like meshes(leaves of TRIANGLE_BLOCK_SIZE). Build with --config=avx to time the 8 wide AVX kernel
+#include "BVH.h"
+#include "Mesh.h"
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <cstdio>
+
+// Quads along each side of the sphere mesh
+const int MESH_RESOLUTION = 300;
+const int RANDOM_TRIANGLES = 200000;
+// Camera rays along each side of the image
+const int IMAGE_SIZE = 400;
+// Each query is timed this many times and the fastest time is kept, the first pass also warms up the caches
+const int REPEATS = 3;
+
+struct TriangleVertices{
+    Point a, b, c;
+};
+
+// Milliseconds since start
+static double millisecondsSince(std::chrono::steady_clock::time_point start){
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Triangles of a unit sphere, resolution quads around and from pole to pole
+static std::vector<TriangleVertices> sphereTriangles(int resolution){
+    auto vertex = [&](int i, int j){
+        float theta = PI*i/resolution;
+        float phi = 2*PI*j/resolution;
+        return Point(std::sin(theta)*std::cos(phi), std::cos(theta), std::sin(theta)*std::sin(phi));
+    };
+
+    std::vector<TriangleVertices> triangles;
+    for(int i = 0; i < resolution; i++){
+        for(int j = 0; j < resolution; j++){
+            triangles.push_back({vertex(i, j), vertex(i, j + 1), vertex(i + 1, j + 1)});
+            triangles.push_back({vertex(i, j), vertex(i + 1, j + 1), vertex(i + 1, j)});
+        }
+    }
+    return triangles;
+}
+
+// Small triangles scattered randomly through the cube from -1 to 1
+static std::vector<TriangleVertices> randomTriangles(int n){
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> position(-1, 1);
+    std::uniform_real_distribution<float> offset(-0.02, 0.02);
+    std::vector<TriangleVertices> triangles;
+    for(int i = 0; i < n; i++){
+        Point p(position(rng), position(rng), position(rng));
+        triangles.push_back({p, Point(p + Vector(offset(rng), offset(rng), offset(rng))),
+                             Point(p + Vector(offset(rng), offset(rng), offset(rng)))});
+    }
+    return triangles;
+}
+
+// Möller-Trumbore, returns the time the ray hits the triangle or INFINITY
+static float intersectTriangle(const TriangleVertices &t, Ray r){
+    Vector e1 = t.b - t.a;
+    Vector e2 = t.c - t.a;
+    Vector p = crossProduct(r.getDirection(), e2);
+    float det = dotProduct(e1, p);
+    if(std::abs(det) < EPSILON){
+        return INFINITY;
+    }
+
+    float inv = 1/det;
+    Vector s = r.getOrigin() - t.a;
+    float u = dotProduct(s, p)*inv;
+    if(u < 0 || u > 1){
+        return INFINITY;
+    }
+    Vector q = crossProduct(s, e1);
+    float v = dotProduct(r.getDirection(), q)*inv;
+    if(v < 0 || u + v > 1){
+        return INFINITY;
+    }
+    return dotProduct(e2, q)*inv;
+}
+
+// Rays from a camera 3 units in front of the scene through a grid slightly larger than it
+static std::vector<Ray> cameraRays(){
+    std::vector<Ray> rays;
+    Point from(0.1, 0.2, -3);
+    for(int y = 0; y < IMAGE_SIZE; y++){
+        for(int x = 0; x < IMAGE_SIZE; x++){
+            Point to(2.4*x/IMAGE_SIZE - 1.2, 2.4*y/IMAGE_SIZE - 1.2, 0);
+            rays.push_back(Ray(from, Vector(to - from).normalize()));
+        }
+    }
+    return rays;
+}
+
+// Fastest of REPEATS runs of query over every ray, hits is set to how many rays hit something
+template<typename Query>
+static double timeQuery(const std::vector<Ray> &rays, int &hits, Query query){
+    double best = INFINITY;
+    for(int repeat = 0; repeat < REPEATS; repeat++){
+        auto start = std::chrono::steady_clock::now();
+        hits = 0;
+        for(Ray r : rays){
+            hits += query(r);
+        }
+        best = std::min(best, millisecondsSince(start));
+    }
+    return best;
+}
+
+static void benchmarkScene(const char* name, const std::vector<TriangleVertices> &triangles, const std::vector<Ray> &rays){
+    std::vector<BoundingBox> boxes;
+    for(const TriangleVertices &t : triangles){
+        BoundingBox b;
+        b.add(t.a);
+        b.add(t.b);
+        b.add(t.c);
+        boxes.push_back(b);
+    }
+
+    printf("%s, %d triangles, %d rays\n", name, (int)triangles.size(), (int)rays.size());
+    printf("%-6s %-6s %10s %12s %12s %8s\n", "width", "leaf", "build(ms)", "closest(ms)", "shadow(ms)", "hits");
+    for(int minLeafSize : {BVH_MIN_LEAF_SIZE, TRIANGLE_BLOCK_SIZE}){
+        for(int width : {2, 4, 8}){
+            BVH bvh;
+            auto start = std::chrono::steady_clock::now();
+            bvh.build(boxes, width, minLeafSize);
+            double buildTime = millisecondsSince(start);
+            const std::vector<int> &order = bvh.getOrder();
+
+            // Per primitive traversal for the small leaves like groups, per leaf traversal for the mesh sized leaves
+            auto closest = [&](Ray r){
+                float nearest = INFINITY;
+                auto hitPrimitive = [&](int p, float tmax){
+                    float t = intersectTriangle(triangles[p], r);
+                    if(t > EPSILON && t < tmax){
+                        nearest = t;
+                        return t;
+                    }
+                    return tmax;
+                };
+                if(minLeafSize == BVH_MIN_LEAF_SIZE){
+                    bvh.traverse(r, 0, INFINITY, hitPrimitive);
+                }else{
+                    bvh.traverseLeaves(r, 0, INFINITY, [&](int first, int count, float tmax){
+                        for(int i = 0; i < count; i++){
+                            tmax = hitPrimitive(order[first + i], tmax);
+                        }
+                        return tmax;
+                    });
+                }
+                return nearest < INFINITY;
+            };
+            // Stops at the first hit like a shadow ray by returning a time below tmin
+            auto occluded = [&](Ray r){
+                bool hit = false;
+                auto hitPrimitive = [&](int p, float tmax){
+                    float t = intersectTriangle(triangles[p], r);
+                    if(t > EPSILON && t < tmax){
+                        hit = true;
+                        return -1.0f;
+                    }
+                    return tmax;
+                };
+                if(minLeafSize == BVH_MIN_LEAF_SIZE){
+                    bvh.traverse(r, 0, INFINITY, hitPrimitive);
+                }else{
+                    bvh.traverseLeaves(r, 0, INFINITY, [&](int first, int count, float tmax){
+                        for(int i = 0; i < count && !hit; i++){
+                            tmax = hitPrimitive(order[first + i], tmax);
+                        }
+                        return tmax;
+                    });
+                }
+                return hit;
+            };
+
+            int hits, shadowHits;
+            double closestTime = timeQuery(rays, hits, closest);
+            double shadowTime = timeQuery(rays, shadowHits, occluded);
+            printf("%-6d %-6d %10.0f %12.0f %12.0f %8d\n", width, minLeafSize, buildTime, closestTime, shadowTime, hits);
+        }
+    }
+    printf("\n");
+}
+
+int main(){
+    std::vector<Ray> rays = cameraRays();
+    benchmarkScene("Sphere mesh", sphereTriangles(MESH_RESOLUTION), rays);
+    benchmarkScene("Random triangles", randomTriangles(RANDOM_TRIANGLES), rays);
+    return 0;
+}
@@ -0,0 +1,99 @@
+// Times colouring the camera rays one at a time and in packets of PACKET_SIZE, the two ways Camera::render can trace them
+// Build with --config=avx to time the AVX kernels instead of the SSE ones
+#include "World.h"
+#include "Camera.h"
+#include "Mesh.h"
+#include "Group.h"
+#include <chrono>
+#include <algorithm>
+#include <cstdio>
+
+const int IMAGE_SIZE = 400;
+// Quads along each side of the sphere mesh
+const int MESH_RESOLUTION = 300;
+// Each way is timed this many times and the fastest time is kept, the first pass also warms up the caches
+const int REPEATS = 5;
+
+// Milliseconds since start
+static double millisecondsSince(std::chrono::steady_clock::time_point start){
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Unit sphere made of triangles, resolution quads around and from pole to pole
+static Mesh* sphereMesh(int resolution){
+    Mesh* m = new Mesh;
+    for(int i = 0; i <= resolution; i++){
+        float theta = PI*i/resolution;
+        for(int j = 0; j <= resolution; j++){
+            float phi = 2*PI*j/resolution;
+            m->addVertex(Point(std::sin(theta)*std::cos(phi), std::cos(theta), std::sin(theta)*std::sin(phi)));
+        }
+    }
+
+    for(int i = 0; i < resolution; i++){
+        for(int j = 0; j < resolution; j++){
+            int v = i*(resolution + 1) + j;
+            m->addTriangle(v, v + 1, v + resolution + 2);
+            m->addTriangle(v, v + resolution + 2, v + resolution + 1);
+        }
+    }
+    return m;
+}
+
+// A mesh, a group of cubes and spheres and a floor
+static void buildScene(World &w){
+    w.setLight(LightSource(Point(-10, 10, -10), Colour(1, 1, 1)));
+
+    Plane* floor = new Plane;
+    floor->setTransform(translationMatrix(0, -1, 0));
+    w.appendObject(floor);
+
+    Mesh* m = sphereMesh(MESH_RESOLUTION);
+    m->setTransform(translationMatrix(-1.5, 0, 0));
+    w.appendObject(m);
+
+    Group* g = new Group;
+    for(int i = 0; i < 10; i++){
+        for(int j = 0; j < 10; j++){
+            Shape* s = (i + j) % 2 == 0 ? (Shape*)new Cube : (Shape*)new Sphere;
+            s->setTransform(translationMatrix(0.5 + 0.3*i, -0.8 + 0.3*j, 1)*scalingMatrix(0.1, 0.1, 0.1));
+            g->appendShape(s);
+        }
+    }
+    w.appendObject(g);
+}
+
+int main(){
+    World w;
+    buildScene(w);
+    w.commit();
+
+    Camera c(IMAGE_SIZE, IMAGE_SIZE, PI/3);
+    c.setTransform(viewTransformationMatrix(Point(0, 1, -6), Point(0, 0, 0), Vector(0, 1, 0)));
+    std::vector<Ray> rays;
+    c.raysForTile(0, 0, IMAGE_SIZE, IMAGE_SIZE, rays);
+    std::vector<Colour> single(rays.size()), packets(rays.size());
+
+    double singleTime = INFINITY, packetTime = INFINITY;
+    for(int repeat = 0; repeat < REPEATS; repeat++){
+        auto start = std::chrono::steady_clock::now();
+        for(int i = 0; i < rays.size(); i++){
+            single[i] = w.colourAtHit(rays[i]);
+        }
+        singleTime = std::min(singleTime, millisecondsSince(start));
+
+        start = std::chrono::steady_clock::now();
+        for(int i = 0; i < rays.size(); i += PACKET_SIZE){
+            w.colourAtHitPacket(&rays[i], &packets[i]);
+        }
+        packetTime = std::min(packetTime, millisecondsSince(start));
+    }
+
+    int different = 0;
+    for(int i = 0; i < rays.size(); i++){
+        different += !single[i].isEqual(packets[i]);
+    }
+    printf("Single rays %.0fms, packets %.0fms, %d pixels differ\n", singleTime, packetTime, different);
+    printf("Packets are %.2fx as fast as single rays\n", singleTime/packetTime);
+    return 0;
+}
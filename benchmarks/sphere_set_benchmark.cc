@@ -0,0 +1,69 @@
+// Times closest hit queries against many small spheres stored as one SphereSet and as a Group of Sphere objects
+// Build with --config=avx to time the AVX block kernel instead of the SSE one
+#include "World.h"
+#include "SphereSet.h"
+#include "Group.h"
+#include <chrono>
+#include <random>
+#include <cstdio>
+
+const int SPHERES = 200000;
+const int RAYS = 200000;
+const float RADIUS = 0.05;
+
+// Milliseconds since start
+static double millisecondsSince(std::chrono::steady_clock::time_point start){
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Traces every ray and prints how long it took and how many rays hit something
+static double traceRays(World &w, const std::vector<Ray> &rays, const char* name){
+    auto start = std::chrono::steady_clock::now();
+    int hits = 0;
+    for(const Ray &r : rays){
+        Intersection hit;
+        hits += w.findClosestHit(r, 0, INFINITY, hit);
+    }
+    double time = millisecondsSince(start);
+    printf("%-10s %d hits in %.0fms\n", name, hits, time);
+    return time;
+}
+
+int main(){
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> position(-10, 10);
+
+    SphereSet* set = new SphereSet;
+    Group* group = new Group;
+    for(int i = 0; i < SPHERES; i++){
+        Point center(position(rng), position(rng), position(rng));
+        set->addSphere(center, RADIUS);
+        Sphere* s = new Sphere;
+        s->setTransform(translationMatrix(center.x, center.y, center.z)*scalingMatrix(RADIUS, RADIUS, RADIUS));
+        group->appendShape(s);
+    }
+
+    World setWorld;
+    setWorld.appendObject(set);
+    World groupWorld;
+    groupWorld.appendObject(group);
+    auto start = std::chrono::steady_clock::now();
+    setWorld.commit();
+    printf("Committed the sphere set in %.0fms\n", millisecondsSince(start));
+    start = std::chrono::steady_clock::now();
+    groupWorld.commit();
+    printf("Committed the group in %.0fms\n", millisecondsSince(start));
+
+    // Rays crossing the whole cube of spheres
+    std::vector<Ray> rays;
+    for(int i = 0; i < RAYS; i++){
+        Point from(position(rng), position(rng), -20);
+        Point to(position(rng), position(rng), 20);
+        rays.push_back(Ray(from, Vector(to - from).normalize()));
+    }
+
+    double setTime = traceRays(setWorld, rays, "SphereSet");
+    double groupTime = traceRays(groupWorld, rays, "Group");
+    printf("SphereSet is %.2fx as fast as the group\n", groupTime/setTime);
+    return 0;
+}
@@ -0,0 +1,593 @@
+#pragma once
+#include "BoundingBox.h"
+#include "Ray.h"
+#include "RayPacket.h"
+#include "Config.h"
+#include <vector>
+#include <stdexcept>
+#ifdef __AVX__
+#include <immintrin.h>
+#endif
+
+// Primitives per leaf that are always accepted without trying to split further
+const int BVH_MIN_LEAF_SIZE = 2;
+// Leaves larger than this are always split even if the surface area heuristic says it is not worth it
+const int BVH_MAX_LEAF_SIZE = 8;
+// Number of buckets the centroids are sorted into when searching for the cheapest split
+const int BVH_BINS = 16;
+// Past this depth nodes are split in half by count, which keeps the traversal stack bounded
+const int BVH_MAX_DEPTH = 64;
+
+// Node with up to N children, made by collapsing the levels of the binary tree. The child boxes are stored as one array per
+// bound(structure of arrays) so the same bound of every child fits in one SIMD register and all of them are tested at once
+template<int N>
+struct WideNode{
+    // minX, minY, minZ, maxX, maxY, maxZ of every child
+    alignas(32) float bounds[6][N];
+    // Leaf children: index of the first primitive in order, interior children: index of the child node
+    int child[N];
+    // Number of primitives in a leaf child, 0 for interior children
+    int count[N];
+    // Number of children in use, the rest are never hit
+    int size;
+};
+
+// Bounding volume hierarchy over a list of boxes, built using the surface area heuristic(SAH). The SAH estimates the
+// cost of a split as the surface area of each side(the probability a ray hits it) times the number of primitives in it
+// The tree is stored as a flat array in depth first order, a node's left child is always the next node in the array
+class BVH{
+public:
+    // 32 byte node, the box is stored as raw floats so two nodes fit in one cache line
+    struct Node{
+        float min[3];
+        float max[3];
+        // Leaves: index of the first primitive in order, interior nodes: index of the right child
+        int offset;
+        // Number of primitives in a leaf, 0 for interior nodes
+        int count;
+    };
+
+    // Builds the hierarchy over the boxes, the primitive indices passed to traverse are indices into boxes
+    // The binary tree is always built first, a width of 4 or 8 then collapses it into wide nodes and frees the binary nodes
+    // Nodes with at most minLeafSize(up to BVH_MAX_LEAF_SIZE) primitives are never split, which suits primitives that are
+    // tested a leaf at a time with SIMD where a leaf of several primitives costs about as much as one
+    void build(const std::vector<BoundingBox> &boxes, int width = BVH_WIDTH, int minLeafSize = BVH_MIN_LEAF_SIZE);
+    void clear();
+    bool isEmpty() const;
+
+    int getWidth() const;
+    const std::vector<Node>& getNodes() const;
+    const std::vector<WideNode<4>>& getWideNodes4() const;
+    const std::vector<WideNode<8>>& getWideNodes8() const;
+    const std::vector<int>& getOrder() const;
+
+    // Visits every primitive whose leaf the ray passes through between tmin and tmax, nearest nodes first
+    // visit(primitive, tmax) returns the new tmax, returning the closest hit found so far lets traverse skip every node
+    // behind that hit. Returning tmax unchanged visits every primitive the ray could hit, returning a time below tmin
+    // stops the traversal(eg. once a shadow ray finds any occluder)
+    template<typename Visit>
+    void traverse(Ray r, float tmin, float tmax, Visit visit) const;
+    // traverse for every ray of the packet in mask, each with its own tmax. visit(primitive, lanes) is called with the lanes
+    // whose rays reach the primitive's leaf and lowers tmax for the lanes that hit something, so nodes behind every lane's
+    // closest hit are skipped. Every node box is tested against the whole packet at once
+    template<typename Visit>
+    void traversePacket(const RayPacket &p, int mask, float tmin, float tmax[PACKET_SIZE], Visit visit) const;
+    // traverse and traversePacket calling visit once per leaf instead of once per primitive, so the leaf's primitives can be
+    // tested together. visit(first, count, tmax) and visit(first, count, lanes) are given the leaf's range in getOrder(),
+    // which never holds more than BVH_MAX_LEAF_SIZE primitives
+    template<typename Visit>
+    void traverseLeaves(Ray r, float tmin, float tmax, Visit visit) const;
+    template<typename Visit>
+    void traversePacketLeaves(const RayPacket &p, int mask, float tmin, float tmax[PACKET_SIZE], Visit visit) const;
+
+private:
+    int width = 2;
+    int minLeafSize = BVH_MIN_LEAF_SIZE;
+    // Only the nodes of the current width are kept
+    std::vector<Node> nodes;
+    std::vector<WideNode<4>> nodes4;
+    std::vector<WideNode<8>> nodes8;
+    // Primitive indices sorted so that every leaf references a contiguous range
+    std::vector<int> order;
+
+    // Origin and inverse direction of the ray being traversed
+    struct RayData{
+        float origin[3];
+        float invDir[3];
+        RayData(Ray r);
+    };
+
+    // Origins and inverse directions of the rays in a packet, one array per component
+    struct alignas(16) PacketData{
+        float origin[3][PACKET_SIZE];
+        float invDir[3][PACKET_SIZE];
+        PacketData(const RayPacket &p);
+    };
+
+    // Recursively builds the node containing order[start, end) and returns its index
+    int buildNode(const std::vector<BoundingBox> &boxes, std::vector<Point> &centroids, int start, int end, int depth);
+
+    // Turns the binary subtree at node into wide nodes and returns the index of the wide node
+    template<int N>
+    int collapseNode(std::vector<WideNode<N>> &wide, int node);
+
+    // Slab test against a node, sets entry to the time the ray enters the node
+    static bool intersectNode(const Node &n, const float origin[3], const float invDir[3], float tmin, float tmax, float &entry);
+    // Slab test against every child of a wide node, writes the time the ray enters each child to entries and returns a bitmask
+    // of the children that are hit
+    static int intersectChildren(const WideNode<4> &n, const RayData &ray, float tmin, float tmax, float entries[4]);
+    static int intersectChildren(const WideNode<8> &n, const RayData &ray, float tmin, float tmax, float entries[8]);
+    // Tests count children starting at first, bounds is the first array of the node's bounds and stride the length of each array
+    static int intersectChildren(const float* bounds, int stride, int first, int count, const RayData &ray, float tmin, float tmax, float* entries);
+
+    // Slab test of child c of a wide node against every ray of the packet, writes the time each ray enters the child to
+    // entries and returns a bitmask of the rays that hit it
+    static int intersectChildPacket(const float* bounds, int stride, int c, const PacketData &packet, float tmin, const float tmax[PACKET_SIZE], float entries[PACKET_SIZE]);
+
+    template<int N, typename Visit>
+    void traverseWide(const std::vector<WideNode<N>> &wide, Ray r, float tmin, float tmax, Visit visit) const;
+    template<int N, typename Visit>
+    void traversePacketWide(const std::vector<WideNode<N>> &wide, const RayPacket &p, int mask, float tmin, float tmax[PACKET_SIZE], Visit visit) const;
+    template<typename Visit>
+    void traversePacketBinary(const RayPacket &p, int mask, float tmin, float tmax[PACKET_SIZE], Visit visit) const;
+};
+
+inline BVH::RayData::RayData(Ray r){
+    Point o = r.getOrigin();
+    Vector d = r.getDirection();
+    origin[0] = o.x;
+    origin[1] = o.y;
+    origin[2] = o.z;
+    invDir[0] = 1.0f/d.x;
+    invDir[1] = 1.0f/d.y;
+    invDir[2] = 1.0f/d.z;
+}
+
+inline BVH::PacketData::PacketData(const RayPacket &p){
+    for(int i = 0; i < PACKET_SIZE; i++){
+        origin[0][i] = p.ox[i];
+        origin[1][i] = p.oy[i];
+        origin[2][i] = p.oz[i];
+        invDir[0][i] = 1.0f/p.dx[i];
+        invDir[1][i] = 1.0f/p.dy[i];
+        invDir[2][i] = 1.0f/p.dz[i];
+    }
+}
+
+inline int BVH::intersectChildPacket(const float* bounds, int stride, int c, const PacketData &packet, float tmin, const float tmax[PACKET_SIZE], float entries[PACKET_SIZE]){
+#ifdef TUPLE_USE_SSE
+    // The same box in every lane and a different ray in every lane, NaNs are handled like intersectChildren
+    const __m128 negInf = _mm_set1_ps(-INFINITY);
+    const __m128 posInf = _mm_set1_ps(INFINITY);
+    __m128 tNear = _mm_set1_ps(tmin);
+    __m128 tFar = _mm_loadu_ps(tmax);
+    for(int axis = 0; axis < 3; axis++){
+        __m128 origin = _mm_load_ps(packet.origin[axis]);
+        __m128 invDir = _mm_load_ps(packet.invDir[axis]);
+        __m128 t0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(bounds[axis*stride + c]), origin), invDir);
+        __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(bounds[(axis + 3)*stride + c]), origin), invDir);
+        __m128 ordered = _mm_cmpord_ps(t0, t1);
+        tNear = _mm_max_ps(_mm_or_ps(_mm_and_ps(ordered, _mm_min_ps(t0, t1)), _mm_andnot_ps(ordered, negInf)), tNear);
+        tFar = _mm_min_ps(_mm_or_ps(_mm_and_ps(ordered, _mm_max_ps(t0, t1)), _mm_andnot_ps(ordered, posInf)), tFar);
+    }
+    _mm_storeu_ps(entries, tNear);
+    return _mm_movemask_ps(_mm_cmple_ps(tNear, _mm_add_ps(tFar, _mm_set1_ps(EPSILON))));
+#else
+    Node n;
+    for(int axis = 0; axis < 3; axis++){
+        n.min[axis] = bounds[axis*stride + c];
+        n.max[axis] = bounds[(axis + 3)*stride + c];
+    }
+    int mask = 0;
+    for(int i = 0; i < PACKET_SIZE; i++){
+        const float origin[3] = {packet.origin[0][i], packet.origin[1][i], packet.origin[2][i]};
+        const float invDir[3] = {packet.invDir[0][i], packet.invDir[1][i], packet.invDir[2][i]};
+        if(intersectNode(n, origin, invDir, tmin, tmax[i], entries[i])){
+            mask |= 1 << i;
+        }
+    }
+    return mask;
+#endif
+}
+
+inline int BVH::intersectChildren(const float* bounds, int stride, int first, int count, const RayData &ray, float tmin, float tmax, float* entries){
+#ifdef TUPLE_USE_SSE
+    // Four children at a time. Lanes where t0 or t1 is NaN are replaced with an unbounded slab like in intersectNode,
+    // _mm_min_ps and _mm_max_ps alone would return the other bound and cull the box
+    const __m128 negInf = _mm_set1_ps(-INFINITY);
+    const __m128 posInf = _mm_set1_ps(INFINITY);
+    int mask = 0;
+    for(int c = 0; c < count; c += 4){
+        __m128 tNear = _mm_set1_ps(tmin);
+        __m128 tFar = _mm_set1_ps(tmax);
+        for(int axis = 0; axis < 3; axis++){
+            __m128 origin = _mm_set1_ps(ray.origin[axis]);
+            __m128 invDir = _mm_set1_ps(ray.invDir[axis]);
+            __m128 t0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(bounds + axis*stride + first + c), origin), invDir);
+            __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(bounds + (axis + 3)*stride + first + c), origin), invDir);
+            __m128 ordered = _mm_cmpord_ps(t0, t1);
+            tNear = _mm_max_ps(_mm_or_ps(_mm_and_ps(ordered, _mm_min_ps(t0, t1)), _mm_andnot_ps(ordered, negInf)), tNear);
+            tFar = _mm_min_ps(_mm_or_ps(_mm_and_ps(ordered, _mm_max_ps(t0, t1)), _mm_andnot_ps(ordered, posInf)), tFar);
+        }
+        _mm_storeu_ps(entries + c, tNear);
+        mask |= _mm_movemask_ps(_mm_cmple_ps(tNear, _mm_add_ps(tFar, _mm_set1_ps(EPSILON)))) << c;
+    }
+    return mask;
+#else
+    int mask = 0;
+    for(int c = 0; c < count; c++){
+        Node n;
+        for(int axis = 0; axis < 3; axis++){
+            n.min[axis] = bounds[axis*stride + first + c];
+            n.max[axis] = bounds[(axis + 3)*stride + first + c];
+        }
+        if(intersectNode(n, ray.origin, ray.invDir, tmin, tmax, entries[c])){
+            mask |= 1 << c;
+        }
+    }
+    return mask;
+#endif
+}
+
+inline int BVH::intersectChildren(const WideNode<4> &n, const RayData &ray, float tmin, float tmax, float entries[4]){
+    return intersectChildren(&n.bounds[0][0], 4, 0, 4, ray, tmin, tmax, entries) & ((1 << n.size) - 1);
+}
+
+inline int BVH::intersectChildren(const WideNode<8> &n, const RayData &ray, float tmin, float tmax, float entries[8]){
+#ifdef __AVX__
+    // All eight children in one pass, NaN lanes are blended to an unbounded slab the same way as the SSE versions
+    const __m256 negInf = _mm256_set1_ps(-INFINITY);
+    const __m256 posInf = _mm256_set1_ps(INFINITY);
+    __m256 tNear = _mm256_set1_ps(tmin);
+    __m256 tFar = _mm256_set1_ps(tmax);
+    for(int axis = 0; axis < 3; axis++){
+        __m256 origin = _mm256_set1_ps(ray.origin[axis]);
+        __m256 invDir = _mm256_set1_ps(ray.invDir[axis]);
+        __m256 t0 = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(n.bounds[axis]), origin), invDir);
+        __m256 t1 = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(n.bounds[axis + 3]), origin), invDir);
+        __m256 ordered = _mm256_cmp_ps(t0, t1, _CMP_ORD_Q);
+        tNear = _mm256_max_ps(_mm256_blendv_ps(negInf, _mm256_min_ps(t0, t1), ordered), tNear);
+        tFar = _mm256_min_ps(_mm256_blendv_ps(posInf, _mm256_max_ps(t0, t1), ordered), tFar);
+    }
+    _mm256_storeu_ps(entries, tNear);
+    int mask = _mm256_movemask_ps(_mm256_cmp_ps(tNear, _mm256_add_ps(tFar, _mm256_set1_ps(EPSILON)), _CMP_LE_OQ));
+#else
+    // Two passes of four without AVX
+    int mask = intersectChildren(&n.bounds[0][0], 8, 0, 8, ray, tmin, tmax, entries);
+#endif
+    return mask & ((1 << n.size) - 1);
+}
+
+inline bool BVH::intersectNode(const Node &n, const float origin[3], const float invDir[3], float tmin, float tmax, float &entry){
+    for(int axis = 0; axis < 3; axis++){
+        float t0 = (n.min[axis] - origin[axis])*invDir[axis];
+        float t1 = (n.max[axis] - origin[axis])*invDir[axis];
+        // A NaN(0*infinity when the ray is parallel to this axis and starts on a face) would otherwise pick the infinite
+        // bound and cull the box, the ray lies inside this slab so the axis is left unconstrained
+        if(t0 != t0 || t1 != t1){
+            continue;
+        }
+        float tNear = t0 < t1 ? t0 : t1;
+        float tFar = t0 < t1 ? t1 : t0;
+        tmin = tNear > tmin ? tNear : tmin;
+        tmax = tFar < tmax ? tFar : tmax;
+    }
+
+    entry = tmin;
+    return tmin <= tmax + EPSILON;
+}
+
+template<int N, typename Visit>
+void BVH::traverseWide(const std::vector<WideNode<N>> &wide, Ray r, float tmin, float tmax, Visit visit) const{
+    if(wide.empty()){
+        return;
+    }
+
+    RayData ray(r);
+
+    // Entries are either a wide node(count 0) or a leaf child waiting to be visited, leaves are pushed like nodes so every
+    // child is visited in order of when the ray enters it. Each level adds at most N - 1 entries to the stack
+    struct Entry{
+        int child;
+        int count;
+        float t;
+    };
+    Entry stack[N*BVH_MAX_DEPTH];
+    int top = 0;
+    stack[top++] = {0, 0, tmin};
+
+    while(top > 0){
+        Entry e = stack[--top];
+        // A closer hit was found after this entry was pushed
+        if(e.t > tmax){
+            continue;
+        }
+
+        if(e.count > 0){
+            tmax = visit(e.child, e.count, tmax);
+            if(tmax < tmin){
+                return;
+            }
+            continue;
+        }
+
+        const WideNode<N> &n = wide[e.child];
+        float entries[N];
+        int mask = intersectChildren(n, ray, tmin, tmax, entries);
+
+        // Sorts the children that were hit from farthest to nearest so the nearest ends up on top of the stack
+        int hits[N];
+        int hitCount = 0;
+        for(int i = 0; i < n.size; i++){
+            if(!(mask & (1 << i))){
+                continue;
+            }
+            int j = hitCount++;
+            while(j > 0 && entries[hits[j - 1]] < entries[i]){
+                hits[j] = hits[j - 1];
+                j--;
+            }
+            hits[j] = i;
+        }
+
+        for(int i = 0; i < hitCount; i++){
+            stack[top++] = {n.child[hits[i]], n.count[hits[i]], entries[hits[i]]};
+        }
+    }
+}
+
+template<typename Visit>
+void BVH::traverse(Ray r, float tmin, float tmax, Visit visit) const{
+    traverseLeaves(r, tmin, tmax, [&](int first, int count, float tmax){
+        for(int i = 0; i < count && tmax >= tmin; i++){
+            tmax = visit(order[first + i], tmax);
+        }
+        return tmax;
+    });
+}
+
+template<typename Visit>
+void BVH::traverseLeaves(Ray r, float tmin, float tmax, Visit visit) const{
+    if(width == 4){
+        traverseWide(nodes4, r, tmin, tmax, visit);
+        return;
+    }else if(width == 8){
+        traverseWide(nodes8, r, tmin, tmax, visit);
+        return;
+    }
+
+    if(nodes.empty()){
+        return;
+    }
+
+    Point o = r.getOrigin();
+    Vector d = r.getDirection();
+    const float origin[3] = {o.x, o.y, o.z};
+    const float invDir[3] = {1.0f/d.x, 1.0f/d.y, 1.0f/d.z};
+
+    // Nodes still to be visited and the time the ray enters them. Each level of the tree adds at most one node to the
+    // stack, and the build limits the depth, so a fixed size array is enough
+    struct Entry{
+        int node;
+        float t;
+    };
+    Entry stack[2*BVH_MAX_DEPTH];
+    int top = 0;
+
+    float entry;
+    if(!intersectNode(nodes[0], origin, invDir, tmin, tmax, entry)){
+        return;
+    }
+    stack[top++] = {0, entry};
+
+    while(top > 0){
+        Entry e = stack[--top];
+        // A closer hit was found after this node was pushed
+        if(e.t > tmax){
+            continue;
+        }
+
+        const Node &n = nodes[e.node];
+        if(n.count > 0){
+            tmax = visit(n.offset, n.count, tmax);
+            if(tmax < tmin){
+                return;
+            }
+            continue;
+        }
+
+        int left = e.node + 1;
+        int right = n.offset;
+        float tLeft, tRight;
+        bool hitLeft = intersectNode(nodes[left], origin, invDir, tmin, tmax, tLeft);
+        bool hitRight = intersectNode(nodes[right], origin, invDir, tmin, tmax, tRight);
+
+        // Pushes the farther child first so the nearer child is visited first
+        if(hitLeft && hitRight){
+            if(tLeft <= tRight){
+                stack[top++] = {right, tRight};
+                stack[top++] = {left, tLeft};
+            }else{
+                stack[top++] = {left, tLeft};
+                stack[top++] = {right, tRight};
+            }
+        }else if(hitLeft){
+            stack[top++] = {left, tLeft};
+        }else if(hitRight){
+            stack[top++] = {right, tRight};
+        }
+    }
+}
+
+template<int N, typename Visit>
+void BVH::traversePacketWide(const std::vector<WideNode<N>> &wide, const RayPacket &p, int mask, float tmin, float tmax[PACKET_SIZE], Visit visit) const{
+    if(wide.empty() || mask == 0){
+        return;
+    }
+
+    PacketData packet(p);
+
+    // Same as traverseWide, every entry also stores which rays hit it and when each of them enters it
+    struct Entry{
+        int child;
+        int count;
+        int mask;
+        float t[PACKET_SIZE];
+    };
+    Entry stack[N*BVH_MAX_DEPTH];
+    int top = 0;
+    stack[top] = {0, 0, mask, {}};
+    for(int i = 0; i < PACKET_SIZE; i++){
+        stack[top].t[i] = tmin;
+    }
+    top++;
+
+    while(top > 0){
+        Entry e = stack[--top];
+        // Drops the rays that found a closer hit after this entry was pushed
+        int active = 0;
+        for(int i = 0; i < PACKET_SIZE; i++){
+            if((e.mask & (1 << i)) && e.t[i] <= tmax[i]){
+                active |= 1 << i;
+            }
+        }
+        if(active == 0){
+            continue;
+        }
+
+        if(e.count > 0){
+            visit(e.child, e.count, active);
+            continue;
+        }
+
+        const WideNode<N> &n = wide[e.child];
+        float entries[N][PACKET_SIZE];
+        int masks[N];
+        // Children are ordered by the earliest time any of the rays enters them
+        float nearest[N];
+        int hits[N];
+        int hitCount = 0;
+        for(int c = 0; c < n.size; c++){
+            masks[c] = intersectChildPacket(&n.bounds[0][0], N, c, packet, tmin, tmax, entries[c]) & active;
+            if(masks[c] == 0){
+                continue;
+            }
+
+            nearest[c] = INFINITY;
+            for(int i = 0; i < PACKET_SIZE; i++){
+                if(masks[c] & (1 << i)){
+                    nearest[c] = std::min(nearest[c], entries[c][i]);
+                }
+            }
+            int j = hitCount++;
+            while(j > 0 && nearest[hits[j - 1]] < nearest[c]){
+                hits[j] = hits[j - 1];
+                j--;
+            }
+            hits[j] = c;
+        }
+
+        for(int i = 0; i < hitCount; i++){
+            int c = hits[i];
+            Entry &child = stack[top++];
+            child.child = n.child[c];
+            child.count = n.count[c];
+            child.mask = masks[c];
+            for(int lane = 0; lane < PACKET_SIZE; lane++){
+                child.t[lane] = entries[c][lane];
+            }
+        }
+    }
+}
+
+template<typename Visit>
+void BVH::traversePacket(const RayPacket &p, int mask, float tmin, float tmax[PACKET_SIZE], Visit visit) const{
+    traversePacketLeaves(p, mask, tmin, tmax, [&](int first, int count, int lanes){
+        for(int i = 0; i < count; i++){
+            visit(order[first + i], lanes);
+        }
+    });
+}
+
+template<typename Visit>
+void BVH::traversePacketLeaves(const RayPacket &p, int mask, float tmin, float tmax[PACKET_SIZE], Visit visit) const{
+    if(width == 4){
+        traversePacketWide(nodes4, p, mask, tmin, tmax, visit);
+        return;
+    }else if(width == 8){
+        traversePacketWide(nodes8, p, mask, tmin, tmax, visit);
+        return;
+    }
+
+    traversePacketBinary(p, mask, tmin, tmax, visit);
+}
+
+template<typename Visit>
+void BVH::traversePacketBinary(const RayPacket &p, int mask, float tmin, float tmax[PACKET_SIZE], Visit visit) const{
+    if(nodes.empty() || mask == 0){
+        return;
+    }
+
+    PacketData packet(p);
+
+    // Same as traverseLeaves, every entry also stores which rays hit the node and when each of them enters it. A node's
+    // min and max are stored next to each other, so it is tested like a wide node child with a stride of 1
+    struct Entry{
+        int node;
+        int mask;
+        float t[PACKET_SIZE];
+    };
+    Entry stack[2*BVH_MAX_DEPTH];
+    int top = 0;
+    Entry &root = stack[top++];
+    root.node = 0;
+    root.mask = intersectChildPacket(nodes[0].min, 1, 0, packet, tmin, tmax, root.t) & mask;
+
+    while(top > 0){
+        Entry e = stack[--top];
+        // Drops the rays that found a closer hit after this node was pushed
+        int active = 0;
+        for(int i = 0; i < PACKET_SIZE; i++){
+            if((e.mask & (1 << i)) && e.t[i] <= tmax[i]){
+                active |= 1 << i;
+            }
+        }
+        if(active == 0){
+            continue;
+        }
+
+        const Node &n = nodes[e.node];
+        if(n.count > 0){
+            visit(n.offset, n.count, active);
+            continue;
+        }
+
+        // Left and right child, ordered by the earliest time any of the rays enters them
+        const int children[2] = {e.node + 1, n.offset};
+        float entries[2][PACKET_SIZE];
+        int masks[2];
+        float nearest[2] = {INFINITY, INFINITY};
+        for(int c = 0; c < 2; c++){
+            masks[c] = intersectChildPacket(nodes[children[c]].min, 1, 0, packet, tmin, tmax, entries[c]) & active;
+            for(int i = 0; i < PACKET_SIZE; i++){
+                if(masks[c] & (1 << i)){
+                    nearest[c] = std::min(nearest[c], entries[c][i]);
+                }
+            }
+        }
+
+        // Pushes the farther child first so the nearer child is visited first
+        int far = nearest[0] <= nearest[1] ? 1 : 0;
+        for(int c : {far, 1 - far}){
+            if(masks[c] == 0){
+                continue;
+            }
+            Entry &child = stack[top++];
+            child.node = children[c];
+            child.mask = masks[c];
+            for(int i = 0; i < PACKET_SIZE; i++){
+                child.t[i] = entries[c][i];
+            }
+        }
+    }
+}
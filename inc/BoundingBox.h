@@ -0,0 +1,33 @@
+#pragma once
+#include "Tuple.h"
+#include "Matrix.h"
+#include "Ray.h"
+
+// Axis aligned box that fully contains a shape, used to skip shapes that a ray cannot possibly hit
+// A default box is empty(contains nothing), boxes with infinite components are unbounded(eg. planes)
+class BoundingBox{
+public:
+    // Corner with the smallest components and corner with the largest components
+    Point min;
+    Point max;
+
+    // Constructors
+    BoundingBox();
+    BoundingBox(Point min, Point max);
+
+    // Grows the box so that it contains the point p or the box b
+    void add(Point p);
+    void add(const BoundingBox &b);
+
+    // An empty box has nothing added to it, an unbounded box extends infinitely in at least one direction
+    bool isEmpty() const;
+    bool isUnbounded() const;
+    bool containsPoint(Point p) const;
+
+    // Returns the box containing this box after it is transformed by the matrix m
+    BoundingBox transform(const Matrix4 &m) const;
+
+    // Checks if the line the ray travels on passes through the box, negative times are also checked since
+    // findIntersections returns intersections behind the ray origin
+    bool intersects(Ray r) const;
+};
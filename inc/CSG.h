@@ -22,6 +22,11 @@ private:
     Shape* left;
     Shape* right;
     SetOperation op;
+    // Range of subtree ids of the shapes in the left subtree(including leftStart, excluding leftEnd)
+    int leftStart = -1;
+    int leftEnd = -1;
+    // Box containing the parent space bounds of the left and right shapes
+    BoundingBox box;
 public:
     // CSG constructor
     CSG(SetOperation op, Shape* l, Shape* r);
@@ -31,12 +36,22 @@ public:
     Shape* getRight();
     SetOperation getOp();
 
+    // Checks if the shape s is in the left subtree using the subtree ids, much faster than includes
+    bool inLeft(Shape* s);
+
     // Determines if the intersection being evaluated is valid(visible to the camera, eg. not inside one of the shapes)
     bool validIntersection(bool hitLeft, bool insideLeft, bool insideRight);
     // Filters out all invalid intersections from a list of intersections that
     std::vector<Intersection> filterIntersections(std::vector<Intersection> intersects);
+    // Filters the intersections in intersects from index start onwards in place
+    void filterIntersections(std::vector<Intersection> &intersects, int start);
 
     // Shape override functions
     bool includes(Shape* s);
-    std::vector<Intersection> childIntersections(Ray r);
+    void assignSubtreeIds(int &next);
+    using Shape::childIntersections;
+    void childIntersections(Ray r, std::vector<Intersection> &intersects);
+    void commit(const Matrix4 &parentWorld, const Matrix4 &parentWorldInverse, CommittedLeaves* leaves);
+    BoundingBox bounds();
+    void childBoundsChanged();
 };
\ No newline at end of file
@@ -3,7 +3,10 @@
 #include "Ray.h"
 #include "Canvas.h"
 #include "World.h"
+#include "Config.h"
+#include "TileScheduler.h"
 #include <stdexcept>
+#include <vector>
 
 // Class representing a virtual camera that you are able to move around the world.
 // Actually, moving the world relative to the camera by multiplying the inverse of
@@ -25,7 +28,19 @@ private:
     // if we wanted to compute the position of the camera, we would
     // multiply inverse(transform)*Point(0, 0, 0) assuming default camera
     // starts at origin
-    Matrix transform;
+    Matrix4 transform;
+    // Inverse of the transform and the camera position in the world, computed in setTransform
+    // so generating a ray does not invert any matrices
+    Matrix4 inverseTransform;
+    Point origin;
+    // World position of the center of pixel (0, 0) and the world offsets from one pixel center
+    // to the next pixel center in the same row(columnStep) and the same column(rowStep)
+    Point firstPixel;
+    Vector columnStep;
+    Vector rowStep;
+
+    // Recomputes firstPixel, columnStep, and rowStep after the transform or pixel size changes
+    void computeRayDeltas();
 public:
     // Camera constructor
     Camera(int h, int v, float fov);
@@ -34,18 +49,23 @@ public:
     int getHSize();
     int getVSize();
     float getFOV();
-    Matrix getTransform();
+    const Matrix4& getTransform();
     float getPixelSize();
 
     // Camera setters
-    void setTransform(Matrix m);
+    void setTransform(const Matrix4 &m);
 
     // Computes pixel size in world units
     void computePixelSize();
 
     // Computes a ray that starts at the camera and goes through the canvas at the specified xy pixel
     Ray rayToPixel(int x, int y);
+    // Computes the rays for every pixel in the w by h tile whose top left pixel is (x, y), rays are stored row by row
+    // The tile is not bounds checked, a scanline is a tile with a height of 1
+    void raysForTile(int x, int y, int w, int h, std::vector<Ray> &rays);
 
     // Produces the rendered canvas for the given world based off of the camera and world properties
-    Canvas render(World w);
+    // The canvas is split into tiles that are rendered by the given number of threads(0 uses every hardware thread)
+    // Every pixel is computed the same way no matter which thread renders it, so the output does not depend on the thread count
+    Canvas render(World &w, int threads = RENDER_THREADS);
 };
\ No newline at end of file
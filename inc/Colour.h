@@ -8,7 +8,7 @@ public:
     float r, g, b;
     Colour();
     Colour(float r, float g, float b);
-    bool isEqual(Colour a);
+    bool isEqual(Colour a) const;
 
     // Colour operations
     Colour operator+(Colour a);
@@ -6,4 +6,23 @@ const bool RENDER_SHADOWS = true;
 
 // TODO: PATTERNS, REFLECTION, TRANSPARENCY, REFRACTION
 
-const int RECURSIVE_REFLECT_LIMIT = 4;
\ No newline at end of file
+const int RECURSIVE_REFLECT_LIMIT = 4;
+
+// Number of threads used by Camera::render, 0 uses one thread for every hardware thread
+// and 1 renders serially on the calling thread
+const int RENDER_THREADS = 0;
+
+// Side length in pixels of the square tiles that the canvas is split into for multi-threaded rendering
+const int RENDER_TILE_SIZE = 16;
+
+// Whether Camera::render traces the camera rays in packets of PACKET_SIZE neighbouring pixels, which share the work of
+// walking the hierarchies. Packets whose rays point in different directions are traced one ray at a time anyway
+// Off by default since benchmarks/packet_benchmark.cc only measured packets at 1.0-1.2x the speed of single rays, only
+// the first hit is traced as a packet and shading, shadows and secondary rays still take most of the time
+const bool RENDER_RAY_PACKETS = false;
+
+// Children per node in the bounding volume hierarchies used by groups, meshes and the world. 2 keeps the binary tree,
+// 4 or 8 collapse it into wide nodes whose child boxes are tested against the ray together with SSE(AVX for 8 when built
+// with --config=avx). In benchmarks/bvh_width_benchmark.cc 4 traced 20-35% faster than 2 with small leaves and 5-20% faster
+// with mesh sized leaves, 8 was no faster than 4 with SSE and slower with AVX
+const int BVH_WIDTH = 4;
@@ -2,14 +2,31 @@
 #include "Shape.h"
 #include "Intersection.h"
 #include "Tuple.h"
+#include "BVH.h"
+#include "PrimitiveList.h"
 #include <vector>
 #include <string>
+#include <atomic>
+#include <mutex>
 
 // Class storing a group of shapes, useful for designing objects at the origin and than transforming them after
 class Group : public Shape{
 private:
     // Stores all shapes contained in the group
     std::vector<Shape*> shapes;
+    // Box containing the parent space bounds of every shape in the group, kept up to date when shapes are
+    // added or changed so it never has to be recomputed while rendering
+    BoundingBox box;
+
+    // Hierarchy over the shapes with finite bounds, unbounded shapes(eg. planes) are always tested. The shapes are stored by
+    // type with their inverse transforms so the common primitives are intersected without virtual calls
+    BVH bvh;
+    PrimitiveList bvhShapes;
+    PrimitiveList unboundedShapes;
+    // The hierarchy is built the first time the group is intersected after it changes, the lock stops
+    // two render threads from building it at the same time
+    std::atomic<bool> bvhBuilt{false};
+    std::mutex bvhLock;
 public:
     // Group name, used for obj parser
     std::string name = "";
@@ -21,7 +38,18 @@ public:
     std::vector<Shape*> getShapes();
     void appendShape(Shape* s);
 
+    // Builds the bounding volume hierarchy over the group's shapes. Called automatically when the group is intersected,
+    // but can be called once the group is populated so the first ray does not pay for it
+    void buildBVH();
+
     // Shape override function
-    std::vector<Intersection> childIntersections(Ray r);
+    using Shape::childIntersections;
+    void childIntersections(Ray r, std::vector<Intersection> &intersects);
+    bool childOccluded(Ray r, float tmax);
+    bool childClosestHit(Ray r, float tmin, float tmax, Intersection &hit);
     bool includes(Shape* s);
+    void assignSubtreeIds(int &next);
+    void commit(const Matrix4 &parentWorld, const Matrix4 &parentWorldInverse, CommittedLeaves* leaves);
+    BoundingBox bounds();
+    void childBoundsChanged();
 };
\ No newline at end of file
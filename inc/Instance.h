@@ -0,0 +1,46 @@
+#pragma once
+#include "Shape.h"
+#include "Intersection.h"
+#include <vector>
+
+// Class that places a shared prototype shape(usually a Group, Mesh or CSG) in the scene with its own transform and optionally
+// its own material. The prototype is not copied and is not made a child of the instance, so any number of instances can
+// share one prototype and the hierarchy it built. Hits through an instance still reference the shape inside the prototype
+// that was hit, and store the instance so normals and materials can be found for that placement of the prototype
+// The prototype should be finished before it is instanced and can not contain other instances
+class Instance : public Shape{
+private:
+    Shape* prototype;
+    // Whether the instance's material is used instead of the materials of the shapes in the prototype
+    bool overridesMaterial = false;
+
+    // Marks the hits from start onwards as hits through this instance
+    void markHits(std::vector<Intersection> &intersects, int start);
+public:
+    // Instance constructor, the prototype can not have a parent or contain instances
+    Instance(Shape* prototype);
+
+    Shape* getPrototype();
+
+    // Material override, every shape in the prototype is shaded with m for this instance
+    void setMaterialOverride(const Material &m);
+    void clearMaterialOverride();
+    bool hasMaterialOverride();
+
+    // Material of a shape hit through instance(nullptr if it was not hit through an instance), solid is the solid of s
+    // that was hit(see Shape::solidOf)
+    static const Material& materialOf(Shape* s, Shape* instance, int solid = -1);
+
+    // Shape override functions
+    bool childEqual(Shape* s);
+    using Shape::childIntersections;
+    void childIntersections(Ray r, std::vector<Intersection> &intersects);
+    bool childOccluded(Ray r, float tmax);
+    bool childClosestHit(Ray r, float tmin, float tmax, Intersection &hit);
+    bool includes(Shape* s);
+    // The prototype is baked relative to itself, so it can not be committed as part of the world as well
+    void commit(const Matrix4 &parentWorld, const Matrix4 &parentWorldInverse, CommittedLeaves* leaves);
+    // The prototype does not tell its instances when it changes, so its version is part of the instance's
+    unsigned int getVersion();
+    BoundingBox bounds();
+};
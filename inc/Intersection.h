@@ -1,6 +1,7 @@
 #pragma once
 #include <vector>
 class Shape; // forward declarations
+class Material;
 
 // Class that stores the time and shape that the intersection occurred at
 class Intersection{
@@ -8,22 +9,33 @@ class Intersection{
         // Stores time and shape that a ray intersected
         float time;
         Shape* s;
-        // Variables used only for SmoothTriangles
+        // Variables used only for SmoothTriangles and Meshes
         float u = -1;
         float v = -1;
+        // Index of the triangle that was hit in a Mesh or the sphere that was hit in a SphereSet, -1 for every other shape
+        int index = -1;
+        // Instance the shape was hit through, nullptr if the shape is not inside an instanced prototype
+        Shape* instance = nullptr;
     public:
-        // Intersection constructor
+        // Intersection constructor, the default is an empty hit(time 0 and no shape) for arrays of hits filled in later
+        Intersection();
         Intersection(float t, Shape* s);
         Intersection(float t, Shape* s, float u, float v);
+        Intersection(float t, Shape* s, float u, float v, int index);
 
         // Getters for Intersection variables
-        float getTime();
-        Shape* getShape();
-        float getU();
-        float getV();
+        float getTime() const;
+        Shape* getShape() const;
+        float getU() const;
+        float getV() const;
+        int getIndex() const;
+        Shape* getInstance() const;
+        void setInstance(Shape* i);
+        // Material the hit is shaded with, the shape's material unless the instance overrides it
+        const Material& getMaterial() const;
 
         // Equality check
-        bool isEqual(Intersection i);
+        bool isEqual(Intersection i) const;
 };
 
 // Function to pack a list of intersections into a vector
@@ -36,3 +48,16 @@ int hit(std::vector<Intersection> vec);
 
 // Intersection comparison function
 bool compareIntersections(Intersection a, Intersection b);
+
+// Merges the sorted intersections in [start, mid) with the sorted intersections in [mid, end) so that everything
+// from start onwards is sorted
+void mergeIntersections(std::vector<Intersection> &intersects, int start, int mid);
+// Merges k sorted runs of intersections in O(n log k), run i starts at runs[i] and ends where the next run starts(the last at
+// the end of the buffer), runs are in increasing order and may be empty. Shapes add their intersections in order, so groups
+// record where each child's list starts and merge all of them once rather than sorting them again. Only the runs from
+// runs[firstRun] onwards are merged
+void mergeRuns(std::vector<Intersection> &intersects, const std::vector<int> &runs, int firstRun = 0);
+// Buffer of run starts reused by every shape on this thread instead of allocating one per ray. A child's runs are recorded
+// while its parent's are being collected, so each caller remembers the size when it starts, pushes its runs after that and
+// resizes the buffer back once they are merged
+std::vector<int>& runBuffer();
@@ -2,6 +2,8 @@
 #include "Tuple.h"
 #include "Colour.h"
 #include <stdexcept>
+#include <deque>
+#include <unordered_map>
 #include "common.h"
 #include "Pattern.h"
 
@@ -53,16 +55,37 @@ public:
     float reflective;
     float transparency;
     float refractiveIndex;
+    // Objects that do not cast shadows are ignored by shadow rays
     bool castsShadow;
 
     // Material constructor
     Material();
 
     // Equality function
-    bool isEqual(Material m);
+    bool isEqual(const Material &m) const;
+};
+
+// Table of materials referenced by index, owned by the shape whose parts use them(eg. the spheres of a SphereSet) so the
+// parts store an int instead of their own copy. Identical materials share an entry, found through a hash of the material
+// Materials are stored in a deque so the references returned by get stay valid when more materials are added
+// The table is not locked, it is only changed while the scene is built or committed and only read while rendering
+class MaterialTable{
+private:
+    std::deque<Material> materials;
+    // Index of every material by its hash
+    std::unordered_multimap<size_t, int> indices;
+
+    static size_t hash(const Material &m);
+public:
+    // Returns the index of the material, only adds it if the table does not already have an identical material
+    int add(const Material &m);
+    const Material& get(int id) const;
+    int size() const;
+    // Removes every material, indices returned before are no longer valid
+    void clear();
 };
 
 // Performs lighting computations. Takes the material, the point that is being lit,
 // the light source, camera vector, and normal vector as input parameters.
 // Also, considers if the point has a shadow casted on it by another object
-Colour computeLighting(Material m, Shape* object, LightSource l, Point p, Vector camera, Vector normal, bool inShadow);
\ No newline at end of file
+Colour computeLighting(const Material &m, Shape* object, LightSource l, Point p, Vector camera, Vector normal, bool inShadow);
\ No newline at end of file
@@ -8,10 +8,15 @@
 #include <vector>
 
 // Class to store computeLighting parameter data
+// Made for every point that is shaded, so it only stores values and a pointer to the object that was hit(which it does not own)
 class LightData{
 public:
     // Object being hit
     Shape* object;
+    // Instance the object was hit through, nullptr if it was hit directly
+    Shape* instance;
+    // Solid of the object that was hit(see Shape::solidOf)
+    int solid;
     // Time at which object is hit
     float time;
     // The point where the ray hits the object
@@ -34,12 +39,19 @@ public:
     float n1, n2;
     
     LightData();
+
+    // Material of the object, or the instance's material if it overrides it
+    const Material& getMaterial() const;
 };
 
 // Takes an intersection and ray and prepares them for computeLighting function
 // The rayIntersects vector stores all the intersections of the ray passed in to prepare refraction data
-LightData prepareLightData(Intersection i, Ray r, std::vector<Intersection> rayIntersects = std::vector<Intersection>());
-void findRefractiveIndices(LightData &data, Intersection i, std::vector<Intersection> rayIntersects = std::vector<Intersection>());
+LightData prepareLightData(Intersection i, Ray r, const std::vector<Intersection> &rayIntersects = std::vector<Intersection>());
+// Same as above but the hit is given by its index in rayIntersects, which avoids searching for it
+LightData prepareLightData(const std::vector<Intersection> &rayIntersects, int hitIndex, Ray r);
+// Computes n1 and n2 for the hit i using every intersection before it, the versions taking an Intersection look up its index first
+void findRefractiveIndices(LightData &data, Intersection i, const std::vector<Intersection> &rayIntersects = std::vector<Intersection>());
+void findRefractiveIndices(LightData &data, int hitIndex, const std::vector<Intersection> &rayIntersects);
 // Approximating Fresnel Effect using Schlick's approximation to find the reflectance which represents the fraction of light 
 // that is reflected, used
-float schlickApproximation(LightData data);
\ No newline at end of file
+float schlickApproximation(const LightData &data);
\ No newline at end of file
@@ -8,6 +8,57 @@
 
 const int DEFAULT_ROWS = 4;
 const int DEFAULT_COLS = 4;
+// A Matrix4 is treated as not invertable when its determinant is this small relative to the product of the lengths of its rows,
+// the largest the determinant could be. Relative so small uniform scales(eg. scaling by 0.04) are still invertable
+const float MATRIX_SINGULAR_TOLERANCE = 1e-6;
+
+class Matrix; // forward declaration, Matrix4 can be converted to and from a generic 4x4 Matrix
+
+// Fixed size 4x4 matrix used for all transforms(shapes, patterns, camera). The 16 elements are stored
+// row by row in one contiguous aligned array, so creating, copying, or multiplying a transform never
+// allocates memory on the heap
+class Matrix4{
+    private:
+        alignas(16) float m[16];
+
+        // Checks if det is too small to invert, size is 3 for the top left 3x3 matrix of affine matrices and 4 for the whole matrix
+        bool isSingular(float det, int size) const;
+    public:
+        // Constructors, the default constructor creates the 4x4 identity matrix
+        Matrix4();
+        Matrix4(Matrix mat);
+
+        // Checks if given coordinates are valid
+        static bool checkCoordValid(int x, int y);
+
+        // Getters and setters for elements, throws if the xy coordinates are invalid
+        float getElement(int x, int y) const;
+        void setElement(int x, int y, float val);
+        // Unchecked element access for code that is run for every ray
+        float operator()(int x, int y) const { return m[x*4 + y]; }
+        float& operator()(int x, int y) { return m[x*4 + y]; }
+
+        std::string toString() const;
+
+        // Equality check function
+        bool isEqual(const Matrix4 &a) const;
+
+        // Matrix operations
+        Matrix4 transpose() const;
+        // Checks if the last row is 0, 0, 0, 1 which is true for every transformation matrix
+        bool isAffine() const;
+        // Closed form determinant
+        float determinant() const;
+        bool isInvertable() const;
+        // Computes the inverse into result using the closed form(or the faster affine form when possible)
+        // Returns false instead of throwing if the matrix is not invertable
+        bool tryInverse(Matrix4 &result) const;
+        // Computes inverse of matrix, throws if the matrix is not invertable
+        Matrix4 inverse() const;
+
+        Matrix4 operator*(const Matrix4 &m2) const;
+        Tuple operator*(const Tuple &t) const;
+};
 
 class Matrix{
     private:
@@ -20,6 +71,7 @@ class Matrix{
         Matrix(int i);
         Matrix(int r, int c);
         Matrix(int r, int c, std::vector<std::vector<float>> vec);
+        Matrix(Matrix4 m);
 
         // Checks if given coordinates are valid
         bool checkCoordValid(int x, int y);
@@ -60,20 +112,20 @@ class Matrix{
 
 // Matrix transformations
 // Generates a translation matrix given x, y, z coordinates
-Matrix translationMatrix(float x, float y, float z);
+Matrix4 translationMatrix(float x, float y, float z);
 // Generates a scaling matrix given x, y, z coordinates
-Matrix scalingMatrix(float x, float y, float z);
+Matrix4 scalingMatrix(float x, float y, float z);
 // Basic Rotations, rotates r radians around the specified axis in the function
-Matrix xRotationMatrix(float r);
-Matrix yRotationMatrix(float r);
-Matrix zRotationMatrix(float r);
+Matrix4 xRotationMatrix(float r);
+Matrix4 yRotationMatrix(float r);
+Matrix4 zRotationMatrix(float r);
 // Shearing matrix, x_y = x moved in proportion to y
-Matrix shearingMatrix(float x_y, float x_z, float y_x, float y_z, float z_x, float z_y);
+Matrix4 shearingMatrix(float x_y, float x_z, float y_x, float y_z, float z_x, float z_y);
 // Chaining transformations, input the matrix transformations as parameters to produce
 // a matrix that performs all transformations at once when multiplied
-Matrix chainTransformationMatrices(std::initializer_list<Matrix> matrices);
+Matrix4 chainTransformationMatrices(std::initializer_list<Matrix4> matrices);
 // View transformation matrix. Moves the world relative to the camera. Intuitively, you can think of it as moving
 //  the "camera" around the world to view it from different positions/directions. The cameraPosition parameter is the 
 // point where the camera is located. The to parameter is where the camera is looking. The up parameter specifies 
 // which direction is pointing upwards from the camera
-Matrix viewTransformationMatrix(Point cameraPosition, Point to, Vector up);
\ No newline at end of file
+Matrix4 viewTransformationMatrix(Point cameraPosition, Point to, Vector up);
\ No newline at end of file
@@ -0,0 +1,86 @@
+#pragma once
+#include "Shape.h"
+#include "Intersection.h"
+#include "Tuple.h"
+#include "BVH.h"
+#include <vector>
+#include <atomic>
+#include <mutex>
+
+// Number of triangles intersected together, one per AVX lane(two SSE passes without AVX). A leaf of the hierarchy fits in one block
+const int TRIANGLE_BLOCK_SIZE = BVH_MAX_LEAF_SIZE;
+
+// Class storing a triangle mesh as one shape. Every triangle is three indices into a shared list of vertices, so a triangle
+// costs 3 ints(6 if it has vertex normals) instead of a whole Triangle object with its own points, matrices and material
+// The triangles all use the mesh's transform and material, hits store the index of the triangle and where it was hit
+// Once the hierarchy is built the corners and edges of the triangles are also copied(40 bytes per triangle) into one array per
+// component in the order of the hierarchy's leaves, so one ray is tested against every triangle of a leaf at once
+class Mesh : public Shape{
+private:
+    // Vertex positions and vertex normals shared by the triangles
+    std::vector<Point> vertices;
+    std::vector<Vector> normals;
+    // Three vertex indices per triangle
+    std::vector<int> indices;
+    // Three normal indices per triangle, -1 for triangles without vertex normals. Stays empty until a triangle
+    // with vertex normals is added so meshes without normals do not pay for it
+    std::vector<int> normalIndices;
+    // Box containing every triangle
+    BoundingBox box;
+
+    // Copy of the triangles in the hierarchy's order, padded at the end with a block of triangles that are never hit so a
+    // block can be loaded from any leaf
+    struct Blocks{
+        // p1 and the edges e1(p1 to p2) and e2(p1 to p3) of every triangle
+        std::vector<float> p1x, p1y, p1z, e1x, e1y, e1z, e2x, e2y, e2z;
+        // Index of the triangle in the mesh, -1 for padding
+        std::vector<int> triangle;
+    };
+    Blocks blocks;
+    // Hierarchy over the triangles, built the first time the mesh is intersected after it changes like Group's
+    BVH bvh;
+    std::atomic<bool> bvhBuilt{false};
+    std::mutex bvhLock;
+
+    // Corner and edges of triangle i for intersectTriangle
+    void triangleEdges(int i, Point &p1, Vector &e1, Vector &e2);
+    void checkIndex(int i, int size, const std::string &function);
+    // Moller-Trumbore for the count(at most TRIANGLE_BLOCK_SIZE) triangles starting at first in blocks, writes the time and u, v
+    // coordinates of each hit and returns a bitmask of the triangles hit between tmin and tmax. The ray is already in the
+    // mesh's space so no triangle transforms it
+    int intersectBlock(int first, int count, const float origin[3], const float direction[3], float tmin, float tmax,
+                       float t[TRIANGLE_BLOCK_SIZE], float u[TRIANGLE_BLOCK_SIZE], float v[TRIANGLE_BLOCK_SIZE]);
+    // Closest of those triangles hit between tmin and tmax, returns its index in the mesh(-1 if none is hit) and sets t, u and v
+    int closestInBlock(int first, int count, const float origin[3], const float direction[3], float tmin, float tmax, float &t, float &u, float &v);
+public:
+    // Adds a vertex or vertex normal and returns its index
+    int addVertex(Point p);
+    int addNormal(Vector n);
+    // Adds a triangle from the vertices at indices v1, v2 and v3, optionally with the vertex normals at n1, n2 and n3
+    // which are interpolated across the triangle like a SmoothTriangle
+    void addTriangle(int v1, int v2, int v3);
+    void addTriangle(int v1, int v2, int v3, int n1, int n2, int n3);
+
+    // getters
+    const std::vector<Point>& getVertices();
+    const std::vector<Vector>& getNormals();
+    const std::vector<int>& getIndices();
+    int triangleCount();
+    bool isSmooth(int triangle);
+
+    // Builds the bounding volume hierarchy over the triangles. Called automatically when the mesh is intersected,
+    // but can be called once the mesh is populated so the first ray does not pay for it
+    void buildBVH();
+
+    // Shape override functions
+    bool childEqual(Shape* s);
+    using Shape::childIntersections;
+    void childIntersections(Ray r, std::vector<Intersection> &intersects);
+    bool childOccluded(Ray r, float tmax);
+    bool childClosestHit(Ray r, float tmin, float tmax, Intersection &hit);
+    int childClosestHitPacket(const RayPacket &p, int mask, float tmin, float tmax[PACKET_SIZE], Intersection hits[PACKET_SIZE]);
+    // Uses the triangle index stored in hit
+    Vector childNormal(Point p, Intersection hit = Intersection(0, nullptr));
+    void commit(const Matrix4 &parentWorld, const Matrix4 &parentWorldInverse, CommittedLeaves* leaves);
+    BoundingBox bounds();
+};
@@ -1,5 +1,6 @@
 #pragma once
 #include "Group.h"
+#include "Mesh.h"
 #include "Tuple.h"
 #include <string>
 #include <iostream>
@@ -17,9 +18,12 @@ public:
     std::vector<Point> vertices;
     // Stores xyz coordinates prefixed by vn in obj files, for smooth triangles
     std::vector<Vector> normals;
+    // When parsing into a mesh every face is added to this mesh instead of making a shape per face, the vertices
+    // and normals are only stored in the mesh and groups are ignored
+    Mesh* mesh = nullptr;
 
-    // Constructor
-    ObjParser(std::string file_path_or_content, bool isFile);
+    // Constructor, asMesh parses the file into one Mesh which uses far less memory for large models
+    ObjParser(std::string file_path_or_content, bool isFile, bool asMesh = false);
 
     // When f prefix in obj file provides more than 3 vertices,
     // uses the list of vertices provided to generate multiple triangles
@@ -27,4 +31,6 @@ public:
 
     // Concatenates all groups generated into one larger group
     Group* objToGroup();
+    // Returns the mesh of every face in the file, the parser has to be constructed with asMesh
+    Mesh* objToMesh();
 };
\ No newline at end of file
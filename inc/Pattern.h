@@ -9,12 +9,16 @@ class Shape; // forward declaration of shape
 // Parent class for patterns. Children will be custom patterns that can be applied to objects
 // The transform is used to manipulate the pattern on objects(eg. make it larger, rotate it)
 class Pattern{
+private:
+    // Only set through setTransform so the inverse is never stale
+    Matrix4 transform;
+    // Inverse of transform, computed once in setTransform
+    Matrix4 inverseTransform;
 public:
     std::vector<Colour> colours = std::vector<Colour>({WHITE, BLACK});
-    Matrix transform = Matrix(4);
 
-    Matrix getTransform();
-    void setTransform(Matrix m);
+    const Matrix4& getTransform();
+    void setTransform(const Matrix4 &m);
 
     Colour applyPattern(Shape* s, Point p);
     virtual Colour ChildApplyPattern(Point p);
@@ -0,0 +1,168 @@
+#pragma once
+#include "Shape.h"
+#include "Intersection.h"
+#include "Ray.h"
+#include "RayPacket.h"
+#include "Matrix.h"
+#include <vector>
+
+// List of the shapes a world or group intersects directly. The shapes are sorted into one contiguous array per primitive type
+// as they are added, and the queries switch on the type and call the primitive's intersection math directly instead of
+// calling virtual functions on Shape objects scattered around the heap. The common primitives(spheres, planes, cubes and
+// triangles) only read their own array until they are hit, any other shape(eg. meshes, CSGs, cylinders) is called through
+// its virtual functions. Shapes are numbered in the order they were added
+class PrimitiveList{
+public:
+    enum Type{SPHERE, PLANE, CUBE, TRIANGLE, SMOOTH_TRIANGLE, OTHER};
+
+    void clear();
+    // Adds the shape s, toObject moves rays from the space of the list's owner into the shape's space
+    void add(Shape* s, const Matrix4 &toObject);
+    int size() const;
+    Shape* getShape(int i) const;
+    Type getType(int i) const;
+
+    // childIntersections, childOccluded, childClosestHit and childClosestHitPacket of shape i with the rays moved into its space
+    void intersections(int i, Ray r, std::vector<Intersection> &intersects) const;
+    bool occluded(int i, Ray r, float tmax) const;
+    bool closestHit(int i, Ray r, float tmin, float tmax, Intersection &hit) const;
+    int closestHitPacket(int i, const RayPacket &p, int mask, float tmin, float tmax[PACKET_SIZE], Intersection hits[PACKET_SIZE]) const;
+
+private:
+    // Type of shape i and its index in the array of that type
+    struct Entry{
+        Type type;
+        int index;
+    };
+    // Spheres, planes, cubes and other shapes only need the matrix
+    struct Placed{
+        Matrix4 toObject;
+        Shape* shape;
+    };
+    // Triangles also store their corner and edges
+    struct PlacedTriangle{
+        Matrix4 toObject;
+        Point p1;
+        Vector e1, e2;
+        Shape* shape;
+    };
+
+    std::vector<Entry> entries;
+    std::vector<Placed> spheres, planes, cubes, others;
+    std::vector<PlacedTriangle> triangles, smoothTriangles;
+
+    // Array storing the shapes of one type
+    const std::vector<Placed>& placed(Type type) const;
+    const std::vector<PlacedTriangle>& placedTriangles(Type type) const;
+    // Stores the hits of the lanes in mask, u and v are only stored for smooth triangles
+    static int storePacketHits(Shape* s, int mask, const float t[PACKET_SIZE], const float u[PACKET_SIZE], const float v[PACKET_SIZE],
+                               bool storeUV, float tmax[PACKET_SIZE], Intersection hits[PACKET_SIZE]);
+};
+
+inline int PrimitiveList::size() const{
+    return entries.size();
+}
+
+inline const std::vector<PrimitiveList::Placed>& PrimitiveList::placed(Type type) const{
+    switch(type){
+        case SPHERE:
+            return spheres;
+        case PLANE:
+            return planes;
+        case CUBE:
+            return cubes;
+        default:
+            return others;
+    }
+}
+
+inline const std::vector<PrimitiveList::PlacedTriangle>& PrimitiveList::placedTriangles(Type type) const{
+    return type == TRIANGLE ? triangles : smoothTriangles;
+}
+
+inline bool PrimitiveList::occluded(int i, Ray r, float tmax) const{
+    const Entry &e = entries[i];
+    float t, u, v;
+    switch(e.type){
+        case SPHERE:
+            return Sphere::hitTime(r.transform(spheres[e.index].toObject), 0, tmax, t) && spheres[e.index].shape->getMaterial().castsShadow;
+        case PLANE:
+            return Plane::hitTime(r.transform(planes[e.index].toObject), 0, tmax, t) && planes[e.index].shape->getMaterial().castsShadow;
+        case CUBE:
+            return Cube::hitTime(r.transform(cubes[e.index].toObject), 0, tmax, t) && cubes[e.index].shape->getMaterial().castsShadow;
+        case TRIANGLE:
+        case SMOOTH_TRIANGLE:{
+            const PlacedTriangle &tri = placedTriangles(e.type)[e.index];
+            return Triangle::intersectTriangle(r.transform(tri.toObject), tri.p1, tri.e1, tri.e2, t, u, v) && t >= 0 && t < tmax &&
+                   tri.shape->getMaterial().castsShadow;
+        }
+        default:
+            return others[e.index].shape->childOccluded(r.transform(others[e.index].toObject), tmax);
+    }
+}
+
+inline bool PrimitiveList::closestHit(int i, Ray r, float tmin, float tmax, Intersection &hit) const{
+    const Entry &e = entries[i];
+    float t, u, v;
+    switch(e.type){
+        case SPHERE:
+        case PLANE:
+        case CUBE:{
+            const Placed &s = placed(e.type)[e.index];
+            Ray local = r.transform(s.toObject);
+            bool found = e.type == SPHERE ? Sphere::hitTime(local, tmin, tmax, t) :
+                         e.type == PLANE ? Plane::hitTime(local, tmin, tmax, t) : Cube::hitTime(local, tmin, tmax, t);
+            if(!found){
+                return false;
+            }
+            hit = Intersection(t, s.shape);
+            return true;
+        }
+        case TRIANGLE:
+        case SMOOTH_TRIANGLE:{
+            const PlacedTriangle &tri = placedTriangles(e.type)[e.index];
+            if(!Triangle::intersectTriangle(r.transform(tri.toObject), tri.p1, tri.e1, tri.e2, t, u, v) || t < tmin || t >= tmax){
+                return false;
+            }
+            hit = e.type == TRIANGLE ? Intersection(t, tri.shape) : Intersection(t, tri.shape, u, v);
+            return true;
+        }
+        default:
+            return others[e.index].shape->childClosestHit(r.transform(others[e.index].toObject), tmin, tmax, hit);
+    }
+}
+
+inline int PrimitiveList::closestHitPacket(int i, const RayPacket &p, int mask, float tmin, float tmax[PACKET_SIZE], Intersection hits[PACKET_SIZE]) const{
+    const Entry &e = entries[i];
+    float t[PACKET_SIZE], u[PACKET_SIZE], v[PACKET_SIZE];
+    switch(e.type){
+        case SPHERE:
+        case PLANE:
+        case CUBE:{
+            const Placed &s = placed(e.type)[e.index];
+            RayPacket local = p.transform(s.toObject);
+            int hit = e.type == SPHERE ? Sphere::hitTimePacket(local, mask, tmin, tmax, t) :
+                      e.type == PLANE ? Plane::hitTimePacket(local, mask, tmin, tmax, t) : Cube::hitTimePacket(local, mask, tmin, tmax, t);
+            return storePacketHits(s.shape, hit, t, u, v, false, tmax, hits);
+        }
+        case TRIANGLE:
+        case SMOOTH_TRIANGLE:{
+            const PlacedTriangle &tri = placedTriangles(e.type)[e.index];
+            int hit = Triangle::intersectTrianglePacket(p.transform(tri.toObject), mask, tri.p1, tri.e1, tri.e2, tmin, tmax, t, u, v);
+            return storePacketHits(tri.shape, hit, t, u, v, e.type == SMOOTH_TRIANGLE, tmax, hits);
+        }
+        default:
+            return others[e.index].shape->childClosestHitPacket(p.transform(others[e.index].toObject), mask, tmin, tmax, hits);
+    }
+}
+
+inline int PrimitiveList::storePacketHits(Shape* s, int mask, const float t[PACKET_SIZE], const float u[PACKET_SIZE], const float v[PACKET_SIZE],
+                                          bool storeUV, float tmax[PACKET_SIZE], Intersection hits[PACKET_SIZE]){
+    for(int i = 0; i < PACKET_SIZE; i++){
+        if(mask & (1 << i)){
+            hits[i] = storeUV ? Intersection(t[i], s, u[i], v[i]) : Intersection(t[i], s);
+            tmax[i] = t[i];
+        }
+    }
+    return mask;
+}
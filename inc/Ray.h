@@ -24,5 +24,5 @@ class Ray{
         Tuple computePosition(float t);
         
         // Returns a ray that is transformed by the matrix m
-        Ray transform(Matrix m);
+        Ray transform(const Matrix4 &m);
 };
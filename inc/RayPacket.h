@@ -0,0 +1,29 @@
+#pragma once
+#include "Ray.h"
+#include "Matrix.h"
+#include "Tuple.h"
+
+// Number of rays traced together in a packet, one per SSE lane
+const int PACKET_SIZE = 4;
+
+// Group of rays traced together through the hierarchies, stored as one array per component(structure of arrays) so the same
+// component of every ray fits in one SSE register and the shape and box tests run on all of them at once
+// Lanes are selected with a bitmask(bit i is ray i), lanes outside the mask are ignored by every packet function
+struct alignas(16) RayPacket{
+    float ox[PACKET_SIZE], oy[PACKET_SIZE], oz[PACKET_SIZE];
+    float dx[PACKET_SIZE], dy[PACKET_SIZE], dz[PACKET_SIZE];
+
+    RayPacket();
+    RayPacket(const Ray rays[PACKET_SIZE]);
+
+    // Ray in lane i
+    Ray getRay(int i) const;
+    // Returns the packet with every ray transformed by the matrix m, the same as transforming each ray
+    RayPacket transform(const Matrix4 &m) const;
+    // Whether the directions of the rays in mask have the same sign on every axis. Only then do the rays visit the boxes of
+    // a hierarchy in roughly the same order, otherwise tracing them one at a time is faster
+    bool isCoherent(int mask) const;
+};
+
+// Mask with every lane of a packet set
+const int PACKET_ALL = (1 << PACKET_SIZE) - 1;
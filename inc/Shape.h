@@ -4,29 +4,112 @@
 #include "Tuple.h"
 #include "Intersection.h"
 #include "Ray.h"
+#include "RayPacket.h"
+#include "BoundingBox.h"
 #include <stdexcept>
 
+class Shape;
+
+// Shapes collected by a commit that are intersected on their own by the world, with their world space bounds
+struct CommittedLeaves{
+    std::vector<Shape*> shapes;
+    std::vector<BoundingBox> boxes;
+    // Prototypes of the instances that were committed, once per instance. The world commits each distinct one afterwards
+    // and a prototype can not also be one of the world's objects
+    std::vector<Shape*> prototypes;
+};
+
 // Parent class for all objects that can be rendered
 class Shape{
 protected:
     // Stores material of shape and the matrix transformation that is applied to the shape
-    Matrix transform = Matrix(4);
+    Matrix4 transform;
+    // Inverse and inverse transpose of transform, computed once in setTransform since every ray
+    // and normal calculation needs them
+    Matrix4 inverseTransform;
+    Matrix4 inverseTranspose;
+    // Every shape keeps its own material rather than an index into a table owned by the world, since a shape can be in
+    // several worlds and instances place the same shapes with different materials. Shading reads it by const reference,
+    // shapes made of many parts share it(Mesh's triangles) or index a MaterialTable of their own(SphereSet's spheres)
     Material material = Material();
     Shape* parent = nullptr;
+    // Whether findIntersections checks the ray against the bounding box before calling childIntersections
+    // Only worth it for shapes that contain other shapes, primitives are about as cheap to intersect as their box
+    bool cullWithBounds = false;
+
+    // Lets the parent know this shape's parent space bounds changed so it can update its own bounds
+    void updateParentBounds();
+    // Incremented every time the shape or any shape below it changes(transform, material, parent or bounds), lets the
+    // worlds holding the shape know their committed scene is out of date
+    unsigned int version = 1;
+    // Increments the version of the shape and every shape above it
+    void changed();
+    Shape* getRoot();
+
+    // Inverse of the transform from world space to the shape's object space(every parent's transform and the shape's own) and
+    // its transpose, baked by commit so points and normals do not walk up the parent chain. Only used while the shape's
+    // root is the one it was committed under and that root has not changed since, for shapes in a prototype they go up to
+    // the prototype instead of the world
+    Matrix4 worldInverse;
+    Matrix4 worldInverseTranspose;
+    Shape* committedRoot = nullptr;
+    unsigned int committedVersion = 0;
+    // Saves the world inverse transforms and marks the shape as committed, parentWorldInverse is the parent's world inverse
+    void bakeWorldTransform(const Matrix4 &parentWorldInverse);
+
+    // Position of the shape in the CSG it belongs to, assigned in depth first order by the outermost CSG so every
+    // subtree is a contiguous range of ids. -1 if the shape is not part of a CSG
+    int subtreeId = -1;
+    // Renumbers the outermost CSG this shape belongs to, called when shapes are added below a CSG after it was made
+    void updateSubtreeIds();
 public:
+    // Shapes are deleted through Shape pointers
+    virtual ~Shape() = default;
+
     // Getter and setter for transform and material
-    Matrix getTransform();
-    void setTransform(Matrix m);
-    Material getMaterial();
-    void setMaterial(Material m);
+    const Matrix4& getTransform();
+    const Matrix4& getInverseTransform();
+    const Matrix4& getInverseTranspose();
+    void setTransform(const Matrix4 &m);
+    const Material& getMaterial();
+    void setMaterial(const Material &m);
+    // Shapes made of many separate solids(eg. SphereSet) store which solid was hit in the hit's index, solidOf returns the solid
+    // a hit with that index belongs to or -1 for shapes that are one solid. Hits are shaded with their solid's material and
+    // each solid is a separate object when finding refractive indices
+    virtual int solidOf(int index);
+    virtual const Material& getSolidMaterial(int solid);
     Shape* getParent();
     void setParent(Shape* p);
 
     // Returns a vector of intersection objects where the ray r intersects the surface of the shape
     // findIntersections does some preprocessing that would be done for any shape
     std::vector<Intersection> findIntersections(Ray r);
+    // Adds the intersections to the end of intersects instead of returning a new vector, so the same buffer
+    // can be reused for every ray without allocating. Every shape adds its intersections in order of time
+    void findIntersections(Ray r, std::vector<Intersection> &intersects);
     // childIntersections executes custom code depending on what child class is being executed
-    virtual std::vector<Intersection> childIntersections(Ray r);
+    // Child classes override the buffer version, derived classes need "using Shape::childIntersections" to keep the
+    // vector returning version visible
+    std::vector<Intersection> childIntersections(Ray r);
+    virtual void childIntersections(Ray r, std::vector<Intersection> &intersects);
+
+    // Checks if the ray hits a shadow casting part of the shape between time 0 and tmax, used for shadow rays
+    // which only need to know if anything is in the way rather than every intersection
+    // isOccluded does some preprocessing that would be done for any shape
+    bool isOccluded(Ray r, float tmax);
+    // childOccluded executes custom code depending on what child class is being executed, defaults to checking childIntersections
+    virtual bool childOccluded(Ray r, float tmax);
+
+    // Finds the intersection with the lowest time between tmin and tmax(including tmin, excluding tmax) and stores it in hit
+    // Returns false and leaves hit unchanged if there is none. Lets shapes skip anything farther than the closest hit found so far
+    // findClosestHit does some preprocessing that would be done for any shape
+    bool findClosestHit(Ray r, float tmin, float tmax, Intersection &hit);
+    // childClosestHit executes custom code depending on what child class is being executed, defaults to checking childIntersections
+    virtual bool childClosestHit(Ray r, float tmin, float tmax, Intersection &hit);
+    // childClosestHit for every ray of the packet in mask(already in the shape's space), with a tmax per ray. Lanes that
+    // hit have their hit and tmax updated, returns the mask of those lanes. Defaults to childClosestHit one ray at a time,
+    // the primitives primary rays hit most often test the whole packet at once with SSE
+    virtual int childClosestHitPacket(const RayPacket &p, int mask, float tmin, float tmax[PACKET_SIZE], Intersection hits[PACKET_SIZE]);
 
     // Computes the normal vector of a point on the surface of the shape
     // findIntersections does some preprocessing that would be done for any shape
@@ -43,26 +126,61 @@ public:
 
     // Checks if the object includes the shape s, returns isEqual(s) if it is not a CSG or Group. CSG or Group will call recursively
     // on children until it finds a child that matches s(hence the default behaviour of returning isEqual for normal shapes)
-    // Used to compute hitLeft boolean value in CSG::filterIntersections
+    // CSG::filterIntersections uses subtree ids instead since this compares every shape in the subtree
     virtual bool includes(Shape* s);
+
+    // Getter for subtreeId and the function that assigns it. Numbers this shape and every shape below it starting at next,
+    // next is left as one past the last id used
+    int getSubtreeId();
+    virtual void assignSubtreeIds(int &next);
+
+    // Bounding box of the shape in object space(before transform is applied)
+    virtual BoundingBox bounds();
+    // Bounding box of the shape in its parent's space(after transform is applied)
+    BoundingBox parentSpaceBounds();
+    // Called when a child's bounds change, only groups and CSGs store their children's bounds
+    virtual void childBoundsChanged();
+    // Changes whenever the shape or a shape it contains changes
+    virtual unsigned int getVersion();
+
+    // Prepares the shape to be rendered, called by World::commit. parentWorld and parentWorldInverse transform between the
+    // parent's space and world space. Shapes that the world should intersect directly are added to leaves with their world
+    // space bounds, groups add their children instead of themselves so the world's hierarchy is flat. leaves is nullptr for
+    // shapes that are only reached through another shape(eg. the children of a CSG)
+    virtual void commit(const Matrix4 &parentWorld, const Matrix4 &parentWorldInverse, CommittedLeaves* leaves);
+    // Whether the baked world transforms are up to date
+    bool isCommitted();
+    const Matrix4& getWorldInverse();
     
     // Recursive functions for groups
     // Converts a point in the world to a point relative to the shape
     // Utilizes the shape's transform as well as any parent group transforms
-    Point worldToObject(Point p);
+    // For shapes inside an instanced prototype, instance is the instance the shape was hit through
+    Point worldToObject(Point p, Shape* instance = nullptr);
     // Converts a normal vector relative to the shape to a vector in the world coordinates
-    Vector normalToWorld(Vector normal);
+    Vector normalToWorld(Vector normal, Shape* instance = nullptr);
 };
 
 // Class to represent spheres in the canvas, default sphere has a radius of 1 and the center is at the origin
 class Sphere: public Shape{
     public:
+        // Time of the closest hit between tmin and tmax(including tmin, excluding tmax) of a ray in the shape's space, shared by
+        // the shape's functions and PrimitiveList. hitTimePacket does the same for every ray of the packet in mask at once and
+        // returns the mask of the rays that hit
+        static bool hitTime(Ray r, float tmin, float tmax, float &t);
+        static int hitTimePacket(const RayPacket &p, int mask, float tmin, const float tmax[PACKET_SIZE], float t[PACKET_SIZE]);
+
         // Shape class override functions
         bool childEqual(Shape* s);
+        using Shape::childIntersections;
         // Computes all intersections of the ray r with the sphere
-        std::vector<Intersection> childIntersections(Ray r);
+        void childIntersections(Ray r, std::vector<Intersection> &intersects);
+        bool childOccluded(Ray r, float tmax);
+        bool childClosestHit(Ray r, float tmin, float tmax, Intersection &hit);
+        int childClosestHitPacket(const RayPacket &p, int mask, float tmin, float tmax[PACKET_SIZE], Intersection hits[PACKET_SIZE]);
         // Computes normal vector at point p on the sphere
         Vector childNormal(Point p, Intersection hit = Intersection(0, nullptr));
+        BoundingBox bounds();
 };
 
 Sphere* glassSphere();
@@ -70,26 +188,46 @@ Sphere* glassSphere();
 // class to store the plane shape, a flat surface that extends infinitely in two directions and has no thickness
 class Plane : public Shape{
 public:
+    // Closest hit time and its packet version, see Sphere::hitTime
+    static bool hitTime(Ray r, float tmin, float tmax, float &t);
+    static int hitTimePacket(const RayPacket &p, int mask, float tmin, const float tmax[PACKET_SIZE], float t[PACKET_SIZE]);
+
     // Shape class override functions
     bool childEqual(Shape* s);
+    using Shape::childIntersections;
     // Computes the point of intersection of a ray on the plane 
-    std::vector<Intersection> childIntersections(Ray r);
+    void childIntersections(Ray r, std::vector<Intersection> &intersects);
+    bool childOccluded(Ray r, float tmax);
+    bool childClosestHit(Ray r, float tmin, float tmax, Intersection &hit);
+    int childClosestHitPacket(const RayPacket &p, int mask, float tmin, float tmax[PACKET_SIZE], Intersection hits[PACKET_SIZE]);
     // The normal vector at any point on the plane is the same
     // The default plane is an xz plane, so the normal vector will be Vector(0, 1, 0)
     Vector childNormal(Point p, Intersection hit = Intersection(0, nullptr));
+    // Planes are infinite so their bounds are unbounded in x and z
+    BoundingBox bounds();
 };
 
 // Class to represent cubes, default cube has a side length of 2 and origin at Point(0, 0, 0)
 class Cube : public Shape{
 public:
+    // Closest hit time and its packet version, see Sphere::hitTime
+    static bool hitTime(Ray r, float tmin, float tmax, float &t);
+    static int hitTimePacket(const RayPacket &p, int mask, float tmin, const float tmax[PACKET_SIZE], float t[PACKET_SIZE]);
+
     // Shape class override functions
     bool childEqual(Shape* s);
-    std::vector<Intersection> childIntersections(Ray r);
+    using Shape::childIntersections;
+    void childIntersections(Ray r, std::vector<Intersection> &intersects);
+    bool childOccluded(Ray r, float tmax);
+    bool childClosestHit(Ray r, float tmin, float tmax, Intersection &hit);
+    int childClosestHitPacket(const RayPacket &p, int mask, float tmin, float tmax[PACKET_SIZE], Intersection hits[PACKET_SIZE]);
     Vector childNormal(Point p, Intersection hit = Intersection(0, nullptr));
+    BoundingBox bounds();
 };
 
 // Cube helper function for computing intersections
-std::vector<float> check_axis(float origin, float direction);
+// Sets tmin and tmax to the times the ray enters and exits the pair of faces on one axis
+inline void check_axis(float origin, float direction, float &tmin, float &tmax);
 
 // Class to represent cylinders, the default cylinder extends infinitely in the +y and -y direction on the y axis
 class Cylinder : public Shape{
@@ -113,12 +251,18 @@ public:
 
     // Shape class override functions
     bool childEqual(Shape* s);
-    std::vector<Intersection> childIntersections(Ray r);
+    using Shape::childIntersections;
+    void childIntersections(Ray r, std::vector<Intersection> &intersects);
+    bool childOccluded(Ray r, float tmax);
+    bool childClosestHit(Ray r, float tmin, float tmax, Intersection &hit);
     Vector childNormal(Point p, Intersection hit = Intersection(0, nullptr));
+    BoundingBox bounds();
 
-    // Intersection helper functions for the top and bottom caps
+    // Intersection helper functions for the walls and the top and bottom caps, both write the times
+    // of the intersections to times and return how many there are
     static bool insideCapRadius(Ray r, float t);
-    void intersectCaps(Ray r, std::vector<Intersection> &intersects);
+    int wallIntersections(Ray r, float times[2]);
+    int capIntersections(Ray r, float times[2]);
 };
 
 // Class to represent cones, the default cone extends infinitely in the +y and -y direction on the y axis
@@ -143,12 +287,18 @@ public:
 
     // Shape class override functions
     bool childEqual(Shape* s);
-    std::vector<Intersection> childIntersections(Ray r);
+    using Shape::childIntersections;
+    void childIntersections(Ray r, std::vector<Intersection> &intersects);
+    bool childOccluded(Ray r, float tmax);
+    bool childClosestHit(Ray r, float tmin, float tmax, Intersection &hit);
     Vector childNormal(Point p, Intersection hit = Intersection(0, nullptr));
+    BoundingBox bounds();
 
-    // Intersection helper functions for the top and bottom caps
+    // Intersection helper functions for the walls and the top and bottom caps, both write the times
+    // of the intersections to times and return how many there are
     static bool insideCapRadius(Ray r, float t, float radius);
-    void intersectCaps(Ray r, std::vector<Intersection> &intersects);
+    int wallIntersections(Ray r, float times[2]);
+    int capIntersections(Ray r, float times[2]);
 };
 
 // Class to represent triangles
@@ -164,6 +314,14 @@ public:
     // Triangle constructor
     Triangle(Point p1, Point p2, Point p3);
 
+    // Moller-Trumbore ray-triangle intersection shared by triangles, smooth triangles and meshes, returns false if the ray
+    // misses the triangle with corner p1 and edges e1, e2. Otherwise sets the time of the hit and the u, v coordinates of where it hit
+    static bool intersectTriangle(Ray r, const Point &p1, const Vector &e1, const Vector &e2, float &t, float &u, float &v);
+    // intersectTriangle for every ray of the packet in mask at once, returns the mask of the rays that hit between tmin and
+    // tmax(a tmax per ray) and sets their t, u and v
+    static int intersectTrianglePacket(const RayPacket &p, int mask, const Point &p1, const Vector &e1, const Vector &e2, float tmin,
+                                       const float tmax[PACKET_SIZE], float t[PACKET_SIZE], float u[PACKET_SIZE], float v[PACKET_SIZE]);
+
     // Getters
     Point getP1();
     Point getP2();
@@ -174,8 +332,13 @@ public:
 
     // Shape class override functions
     bool childEqual(Shape* s);
-    std::vector<Intersection> childIntersections(Ray r);
+    using Shape::childIntersections;
+    void childIntersections(Ray r, std::vector<Intersection> &intersects);
+    bool childOccluded(Ray r, float tmax);
+    bool childClosestHit(Ray r, float tmin, float tmax, Intersection &hit);
+    int childClosestHitPacket(const RayPacket &p, int mask, float tmin, float tmax[PACKET_SIZE], Intersection hits[PACKET_SIZE]);
     Vector childNormal(Point p, Intersection hit = Intersection(0, nullptr));
+    BoundingBox bounds();
 };
 
 // Triangles that have smoother edges when put next to other shapes(Will look more like one shape rather than two shapes beside eachother)
@@ -194,6 +357,106 @@ public:
 
     // Shape class override functions
     bool childEqual(Shape* s);
-    std::vector<Intersection> childIntersections(Ray r);
+    using Shape::childIntersections;
+    void childIntersections(Ray r, std::vector<Intersection> &intersects);
+    bool childClosestHit(Ray r, float tmin, float tmax, Intersection &hit);
+    int childClosestHitPacket(const RayPacket &p, int mask, float tmin, float tmax[PACKET_SIZE], Intersection hits[PACKET_SIZE]);
     Vector childNormal(Point p, Intersection hit = Intersection(0, nullptr));
-};
\ No newline at end of file
+};
+
+// The intersection math used for every ray is defined here so PrimitiveList can inline it
+
+inline bool Sphere::hitTime(Ray r, float tmin, float tmax, float &t){
+    Vector sphere_to_ray = Vector(r.getOrigin() - Point());
+    float a = dotProduct(r.getDirection(), r.getDirection());
+    float b = 2*dotProduct(r.getDirection(), sphere_to_ray);
+    float c = dotProduct(sphere_to_ray, sphere_to_ray) - 1;
+    float discriminant = b*b - 4*a*c;
+
+    if(discriminant < 0){
+        return false;
+    }
+
+    // t1 is always the smaller root, t2 is only the closest if the ray starts inside the sphere
+    float t1 = (-b - sqrt(discriminant))/(2*a);
+    float t2 = (-b + sqrt(discriminant))/(2*a);
+    t = t1 >= tmin ? t1 : t2;
+    return t >= tmin && t < tmax;
+}
+
+inline bool Plane::hitTime(Ray r, float tmin, float tmax, float &t){
+    if(std::abs(r.getDirection().y) < EPSILON){
+        return false;
+    }
+
+    t = -r.getOrigin().y/r.getDirection().y;
+    return t >= tmin && t < tmax;
+}
+
+// Computes the time that the ray hits the plane corresponding to a negative and positive face of a cube using time = distance/speed 
+// where speed is the direction parameter passed in and distance will be calculated using the origin parameter
+// eg. Calculates when a ray hits a plane at x=-1 and x=1 to determine if the intersection was on the cube's surface
+inline void check_axis(float origin, float direction, float &tmin, float &tmax){
+    // Distance from origin to the plane x = -1 or x = 1 if origin corresponds to the cube's origin.x
+    float tmin_numerator = -1 - origin;
+    float tmax_numerator = 1 - origin;
+
+    if(std::abs(direction) >= EPSILON){
+        tmin = tmin_numerator/direction;
+        tmax = tmax_numerator/direction;
+    }else{ // if direction is near 0, handles division by 0
+        tmin = tmin_numerator*INFINITY;
+        tmax = tmax_numerator*INFINITY;
+    }
+
+    if(tmin > tmax){
+        std::swap(tmin, tmax);
+    }
+}
+
+// The entry time is the closest if it is in range, otherwise the exit time(the ray starts inside the cube)
+inline bool Cube::hitTime(Ray r, float tmin, float tmax, float &t){
+    float xtmin, xtmax, ytmin, ytmax, ztmin, ztmax;
+    check_axis(r.getOrigin().x, r.getDirection().x, xtmin, xtmax);
+    check_axis(r.getOrigin().y, r.getDirection().y, ytmin, ytmax);
+    check_axis(r.getOrigin().z, r.getDirection().z, ztmin, ztmax);
+
+    float t0 = std::max({xtmin, ytmin, ztmin});
+    float t1 = std::min({xtmax, ytmax, ztmax});
+    if(t0 > t1){
+        return false;
+    }
+
+    t = t0 >= tmin ? t0 : t1;
+    return t >= tmin && t < tmax;
+}
+
+// Moller-Trumbore ray-triangle intersection algorithm
+inline bool Triangle::intersectTriangle(Ray r, const Point &p1, const Vector &e1, const Vector &e2, float &t, float &u, float &v){
+    Vector dir_cross_e2 = crossProduct(r.getDirection(), e2);
+    float det = dotProduct(e1, dir_cross_e2);
+
+    // Ray is parallel to triangle
+    if(std::abs(det) < EPSILON){
+        return false;
+    }
+
+    // Ray misses p1-p3 edge
+    float f = 1.0/det;
+    Vector p1_to_origin = r.getOrigin() - p1;
+    u = f*dotProduct(p1_to_origin, dir_cross_e2);
+    if(u < 0 || u > 1){
+        return false;
+    }
+
+    // Ray misses p1-p2 edge and ray misses the p2-p3 edge
+    Vector origin_cross_e1 = crossProduct(p1_to_origin, e1);
+    v = f*dotProduct(r.getDirection(), origin_cross_e1);
+    if(v < 0 || (u + v) > 1){
+        return false;
+    }
+
+    // Ray hits the triangle
+    t = f*dotProduct(e2, origin_cross_e1);
+    return true;
+}
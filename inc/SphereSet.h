@@ -0,0 +1,78 @@
+#pragma once
+#include "Shape.h"
+#include "Intersection.h"
+#include "Tuple.h"
+#include "BVH.h"
+#include <vector>
+#include <string>
+#include <atomic>
+#include <mutex>
+
+// Number of spheres intersected together, one per AVX lane(two SSE passes without AVX)
+const int SPHERE_BLOCK_SIZE = 8;
+
+// Class storing many spheres as one shape(eg. particles or molecules). Each sphere is only a center, a radius and optionally
+// its own material instead of a whole Sphere object with its own matrices, so there is no transform per sphere. The spheres
+// all use the set's transform, hits store the index of the sphere that was hit
+// The hierarchy's leaves are blocks of SPHERE_BLOCK_SIZE nearby spheres stored as one array per component, so one ray is
+// tested against every sphere of a block at once
+class SphereSet : public Shape{
+private:
+    // Spheres in the order they were added, one array per component
+    std::vector<float> centerX, centerY, centerZ, radii;
+    // Materials of the spheres that have their own, identical materials share an entry
+    MaterialTable materials;
+    // Index of each sphere's material in materials, -1 for spheres that use the set's material
+    std::vector<int> materialIds;
+    // Box containing every sphere
+    BoundingBox box;
+
+    // Copy of the spheres sorted into blocks of nearby spheres, the last block is padded with spheres that are never hit
+    struct Blocks{
+        std::vector<float> x, y, z, radiusSquared;
+        // Index the sphere was added at, -1 for padding
+        std::vector<int> sphere;
+    };
+    Blocks blocks;
+    // Hierarchy over the blocks, built the first time the set is intersected after it changes like Mesh's
+    BVH bvh;
+    std::atomic<bool> bvhBuilt{false};
+    std::mutex bvhLock;
+
+    void checkIndex(int i, const std::string &function);
+    // Solves the quadratic for every sphere in the block, writes the times the ray enters(near) and exits(far) each sphere
+    // and returns a bitmask of the spheres that are hit. a is the squared length of direction
+    int intersectBlock(int block, const float origin[3], const float direction[3], float a, float near[SPHERE_BLOCK_SIZE], float far[SPHERE_BLOCK_SIZE]);
+public:
+    // Adds a sphere and returns its index, the radius has to be positive
+    int addSphere(Point center, float radius);
+    int addSphere(Point center, float radius, const Material &m);
+
+    // getters
+    int sphereCount();
+    Point getCenter(int i);
+    float getRadius(int i);
+    // Material of sphere i, the set's material unless the sphere has its own
+    const Material& getSphereMaterial(int i);
+    void setSphereMaterial(int i, const Material &m);
+    // Number of different materials stored for the spheres
+    int sphereMaterialCount();
+
+    // Builds the bounding volume hierarchy over the spheres. Called automatically when the set is intersected,
+    // but can be called once the set is populated so the first ray does not pay for it
+    void buildBVH();
+
+    // Shape override functions
+    bool childEqual(Shape* s);
+    using Shape::childIntersections;
+    void childIntersections(Ray r, std::vector<Intersection> &intersects);
+    bool childOccluded(Ray r, float tmax);
+    bool childClosestHit(Ray r, float tmin, float tmax, Intersection &hit);
+    // Uses the sphere index stored in hit
+    Vector childNormal(Point p, Intersection hit = Intersection(0, nullptr));
+    // Every sphere is its own solid
+    int solidOf(int index);
+    const Material& getSolidMaterial(int solid);
+    void commit(const Matrix4 &parentWorld, const Matrix4 &parentWorldInverse, CommittedLeaves* leaves);
+    BoundingBox bounds();
+};
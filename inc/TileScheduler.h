@@ -0,0 +1,43 @@
+#pragma once
+#include <algorithm>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Splits a width x height canvas into square tiles and runs a function on every tile using a pool of threads.
+// Every thread starts with an equal share of the tiles in its own queue. A thread takes tiles from the front
+// of its own queue and once it is empty it steals tiles from the back of the other threads' queues, so threads
+// that get cheap tiles(eg. empty background) help the threads that got expensive ones
+class TileScheduler{
+private:
+    // Queue of tile indices owned by one thread
+    struct TileQueue{
+        std::mutex lock;
+        std::deque<int> tiles;
+    };
+
+    int width, height;
+    int tileSize;
+    // Number of tiles in each row and column of the canvas
+    int tilesX, tilesY;
+    int threadCount;
+
+    // Gets the next tile for a thread, from its own queue first and then from other queues
+    // Returns false when every queue is empty
+    bool nextTile(std::vector<TileQueue> &queues, int thread, int &tile);
+public:
+    // TileScheduler constructor, a thread count of 0 uses std::thread::hardware_concurrency
+    TileScheduler(int width, int height, int tileSize, int threads);
+
+    // Getters
+    int getThreadCount();
+    int getTileCount();
+
+    // Calls renderTile(x, y, w, h) once for every tile where (x, y) is the top left pixel of the tile and w, h
+    // are the tile dimensions(smaller at the right and bottom edges). Returns once every tile is finished and
+    // rethrows the first exception thrown by renderTile
+    void run(std::function<void(int, int, int, int)> renderTile);
+};
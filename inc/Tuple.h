@@ -2,8 +2,17 @@
 #include "common.h"
 #include <cmath>
 
+// Tuple operations are used by every intersection and shading computation so they are implemented
+// in this header to be inlined. When SSE is available the four components are loaded into one
+// 128 bit register and operated on together, otherwise the scalar versions are used
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define TUPLE_USE_SSE 1
+#include <xmmintrin.h>
+#endif
+
 // Parent class for points and vectors
-class Tuple{
+// The class is 16 byte aligned so the components x, y, z, point can be loaded as one SSE register
+class alignas(16) Tuple{
     public:
         float x, y, z;
         // A variable to store the state of the tuple(1.0 for point, 0.0 for vector)
@@ -13,39 +22,133 @@ class Tuple{
         float point;
 
         // Tuple constructors
-        Tuple();
-        Tuple(float x, float y, float z, float point);
-        bool isEqual(Tuple a);
+        Tuple(): x(0), y(0), z(0), point(1) {}
+        Tuple(float x, float y, float z, float point): x(x), y(y), z(z), point(point) {}
+#ifdef TUPLE_USE_SSE
+        Tuple(__m128 v){
+            _mm_store_ps(&x, v);
+        }
+
+        // Loads the tuple into an SSE register
+        __m128 load() const{
+            return _mm_load_ps(&x);
+        }
+#endif
+        bool isEqual(Tuple a) const;
+
         // Tuple Operations
-        Tuple operator+(Tuple b);
-        Tuple operator-(Tuple b);
-        Tuple operator*(float scale);
-        Tuple operator/(float scale);
-        Tuple negateTuple();
+        // Adds tuples together. Adding a vector and point together is equivalent to starting from that point and travelling
+        // the distance and direction of the vector, also notice that a point(1) + vector(0) results in another point! Adding
+        // two vectors results in another vector(0 + 0 = 0)! Adding two points results in 1 + 1 = 2 (invalid)
+        Tuple operator+(const Tuple &b) const{
+#ifdef TUPLE_USE_SSE
+            return Tuple(_mm_add_ps(load(), b.load()));
+#else
+            return Tuple(x + b.x, y + b.y, z + b.z, point + b.point);
+#endif
+        }
+
+        // Performs a - b. Intuitively, subtracting a point from a point generates a vector from p2 to p1. Subtracting a point
+        // from a vector moves the point back the vector's distance and direction. Subtracting two vectors represents the change
+        // in direction between the two.
+        Tuple operator-(const Tuple &b) const{
+#ifdef TUPLE_USE_SSE
+            return Tuple(_mm_sub_ps(load(), b.load()));
+#else
+            return Tuple(x - b.x, y - b.y, z - b.z, point - b.point);
+#endif
+        }
+
+        // Multiplies a tuple by a factor of scale
+        Tuple operator*(float scale) const{
+#ifdef TUPLE_USE_SSE
+            return Tuple(_mm_mul_ps(load(), _mm_set1_ps(scale)));
+#else
+            return Tuple(x*scale, y*scale, z*scale, point*scale);
+#endif
+        }
+
+        // Divides a tuple by scale
+        Tuple operator/(float scale) const{
+#ifdef TUPLE_USE_SSE
+            return Tuple(_mm_div_ps(load(), _mm_set1_ps(scale)));
+#else
+            return Tuple(x/scale, y/scale, z/scale, point/scale);
+#endif
+        }
+
+        // Negates a tuple. Flipping direction of a vector
+        Tuple negateTuple() const{
+#ifdef TUPLE_USE_SSE
+            return Tuple(_mm_xor_ps(load(), _mm_set1_ps(-0.0f)));
+#else
+            return Tuple(-x, -y, -z, -point);
+#endif
+        }
 };
 
 // Class for a point, inherits from Tuple
 class Point: public Tuple{
     public:
         // Point constructors
-        Point();
-        Point(float x, float y, float z);
-        Point(Tuple t);
+        Point(): Tuple(0, 0, 0, 1.0) {}
+        Point(float x, float y, float z): Tuple(x, y, z, 1.0) {}
+        Point(const Tuple &t): Tuple(t.x, t.y, t.z, 1.0) {}
 };
 
 // Class for a vector, inherits from Tuple
 class Vector: public Tuple{
     public:
         // Vector constructors
-        Vector();
-        Vector(float x, float y, float z);
-        Vector(Tuple t);
+        Vector(): Tuple(1, 1, 1, 0.0) {}
+        Vector(float x, float y, float z): Tuple(x, y, z, 0.0) {}
+        Vector(const Tuple &t): Tuple(t.x, t.y, t.z, 0.0) {}
 
         // Vector Operations
-        float magnitude();
-        Vector normalize();
+        float magnitude() const;
+        Vector normalize() const;
 };
 
 // More Vector Operations
-float dotProduct(Vector a, Vector b);
-Vector crossProduct(Vector a, Vector b);
+// NOTE!! Point is included in these vector operations to hopefully help if there
+// are any bugs later as point should always be 0 so it will have no effect on these
+
+// Calculates dot product of vectors a and b
+inline float dotProduct(const Vector &a, const Vector &b){
+#ifdef TUPLE_USE_SSE
+    // Multiplies the components and then adds the four products together with two shuffles
+    __m128 products = _mm_mul_ps(a.load(), b.load());
+    __m128 swapped = _mm_shuffle_ps(products, products, _MM_SHUFFLE(2, 3, 0, 1));
+    __m128 sums = _mm_add_ps(products, swapped);
+    swapped = _mm_movehl_ps(swapped, sums);
+    return _mm_cvtss_f32(_mm_add_ss(sums, swapped));
+#else
+    return a.x*b.x + a.y*b.y + a.z*b.z + a.point*b.point;
+#endif
+}
+
+// Calculates cross product of vectors a and b
+inline Vector crossProduct(const Vector &a, const Vector &b){
+#ifdef TUPLE_USE_SSE
+    // (a.y*b.z - a.z*b.y, a.z*b.x - a.x*b.z, a.x*b.y - a.y*b.x) computed as
+    // yzx(a*yzx(b) - yzx(a)*b) where yzx rotates the x, y, z components
+    __m128 va = a.load();
+    __m128 vb = b.load();
+    __m128 aYZX = _mm_shuffle_ps(va, va, _MM_SHUFFLE(3, 0, 2, 1));
+    __m128 bYZX = _mm_shuffle_ps(vb, vb, _MM_SHUFFLE(3, 0, 2, 1));
+    __m128 c = _mm_sub_ps(_mm_mul_ps(va, bYZX), _mm_mul_ps(aYZX, vb));
+    return Vector(Tuple(_mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1))));
+#else
+    return Vector(a.y*b.z - a.z*b.y, a.z*b.x - a.x*b.z, a.x*b.y - a.y*b.x);
+#endif
+}
+
+// Calculates magnitude of vector
+inline float Vector::magnitude() const{
+    return sqrt(dotProduct(*this, *this));
+}
+
+// Normalizes vector so it's magnitude = 1
+inline Vector Vector::normalize() const{
+    return Vector(*this/magnitude());
+}
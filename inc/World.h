@@ -9,6 +9,11 @@
 #include "LightData.h"
 #include "Config.h"
 #include "Shape.h"
+#include "BVH.h"
+#include "RayPacket.h"
+#include "PrimitiveList.h"
+#include <mutex>
+#include <string>
 
 // Class to store all objects in the environment
 class World{
@@ -16,9 +21,25 @@ private:
     // Stores all objects in the world and the light source
     std::vector<Shape*> objects;
     LightSource light;
+
+    // Hierarchy over every shape the commit added as a leaf(groups are flattened into their children) with finite bounds,
+    // unbounded leaves(eg. planes) are tested by every ray. Rays are moved straight into a leaf's space using its baked
+    // world inverse rather than through every group above it. The leaves are stored by type so the common primitives are
+    // intersected without virtual calls
+    BVH bvh;
+    PrimitiveList bvhLeaves;
+    PrimitiveList unboundedLeaves;
+    // Set by commit and cleared when the object list changes, the intersection functions commit the world while it is unset
+    bool committed = false;
+    // Version of each object at the last commit, the scene is committed again if any of them changed
+    std::vector<unsigned int> committedVersions;
+    std::mutex commitLock;
 public:
     // World constructor
     World();
+    // Copies only the objects and the light, the copy is committed again when it is first intersected
+    World(const World &w);
+    World& operator=(const World &w);
 
     // Getters and setters for variables
     std::vector<Shape*> getObjects();
@@ -28,18 +49,40 @@ public:
     void setLight(LightSource l);
     void setObjects(std::vector<Shape*> obj);
 
+    // Prepares the scene for rendering if it changed since the last commit: bakes every shape's world transforms, flattens
+    // groups and builds every hierarchy. Once committed nothing is built or changed while intersecting, so any number
+    // of threads can render it. Camera::render calls this before the render threads start. The intersection functions
+    // commit the world if it was never committed or its object list changed, they only check that flag rather than every
+    // shape, so anything that changes a shape after the world was intersected has to call this again
+    void commit();
+    // Whether the scene has not changed since the last commit
+    bool isCommitted();
+
     // Returns a vector of intersection objects where the ray r intersects the surface of an object in the world
     std::vector<Intersection> RayIntersection(Ray r);
+    // Adds the sorted intersections to the end of intersects so the caller can reuse the same buffer for every ray
+    void RayIntersection(Ray r, std::vector<Intersection> &intersects);
     // Returns the computed colour of a hit using the world light source and the LightData data structure
-    Colour shadeHit(LightData data, int remaining = RECURSIVE_REFLECT_LIMIT);
+    Colour shadeHit(const LightData &data, int remaining = RECURSIVE_REFLECT_LIMIT);
     // Computes the colour at the first point hit by the ray r
     Colour colourAtHit(Ray r, int remaining = RECURSIVE_REFLECT_LIMIT);
+    // Computes the colour of every ray in rays, tracing them together as a packet for the first hit
+    void colourAtHitPacket(const Ray rays[PACKET_SIZE], Colour colours[PACKET_SIZE], int remaining = RECURSIVE_REFLECT_LIMIT);
+    // Computes the colour of the ray r given the first thing it hits
+    Colour shadeClosestHit(Ray r, const Intersection &closest, int remaining = RECURSIVE_REFLECT_LIMIT);
+    // Finds the intersection with the lowest time between tmin and tmax, returns false if the ray does not hit anything
+    bool findClosestHit(Ray r, float tmin, float tmax, Intersection &hit);
+    // findClosestHit for every ray of the packet in mask with a tmax per ray, returns the mask of the rays that hit something
+    // Packets whose rays do not point the same way are traced one ray at a time
+    int findClosestHitPacket(const RayPacket &p, int mask, float tmin, float tmax[PACKET_SIZE], Intersection hits[PACKET_SIZE]);
+    // Checks if the ray hits any shadow casting object between time 0 and tmax, stops at the first one found
+    bool isOccluded(Ray r, float tmax);
     // Checks if a point p in the world is covered by a shadow(object between point and light source)
     bool hasShadow(Point p);
     // Computes the reflected colour using LightData and the material's reflective attribute
-    Colour reflectedColour(LightData data, int remaining = RECURSIVE_REFLECT_LIMIT);
+    Colour reflectedColour(const LightData &data, int remaining = RECURSIVE_REFLECT_LIMIT);
     // Computes the reflected colour using LightData and the material's refractive index and transparency attribute
-    Colour refractedColour(LightData data, int remaining = RECURSIVE_REFLECT_LIMIT);
+    Colour refractedColour(const LightData &data, int remaining = RECURSIVE_REFLECT_LIMIT);
 };
 
 // Returns a default world with a light source and two spheres
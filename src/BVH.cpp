@@ -0,0 +1,274 @@
+#include "BVH.h"
+#include <algorithm>
+
+// Surface area of a box, proportional to the chance that a random ray hits it
+static float surfaceArea(const BoundingBox &b){
+    if(b.isEmpty()){
+        return 0;
+    }
+    Tuple d = b.max - b.min;
+    return 2*(d.x*d.y + d.y*d.z + d.z*d.x);
+}
+
+static float component(const Tuple &t, int axis){
+    return axis == 0 ? t.x : (axis == 1 ? t.y : t.z);
+}
+
+void BVH::build(const std::vector<BoundingBox> &boxes, int width, int minLeafSize){
+    if(width != 2 && width != 4 && width != 8){
+        throw std::invalid_argument("BVH:build - Invalid input: width " + std::to_string(width));
+    }
+    if(minLeafSize < 1 || minLeafSize > BVH_MAX_LEAF_SIZE){
+        throw std::invalid_argument("BVH:build - Invalid input: minLeafSize " + std::to_string(minLeafSize));
+    }
+
+    clear();
+    this->width = width;
+    this->minLeafSize = minLeafSize;
+    if(boxes.empty()){
+        return;
+    }
+
+    std::vector<Point> centroids(boxes.size());
+    order.resize(boxes.size());
+    for(int i = 0; i < boxes.size(); i++){
+        centroids[i] = Point((boxes[i].min + boxes[i].max)*0.5);
+        order[i] = i;
+    }
+
+    // A binary tree with n leaves has at most 2n - 1 nodes
+    nodes.reserve(2*boxes.size() - 1);
+    buildNode(boxes, centroids, 0, boxes.size(), 0);
+
+    if(width == 4){
+        collapseNode(nodes4, 0);
+    }else if(width == 8){
+        collapseNode(nodes8, 0);
+    }
+
+    if(width != 2){
+        nodes.clear();
+        nodes.shrink_to_fit();
+    }
+}
+
+void BVH::clear(){
+    nodes.clear();
+    nodes4.clear();
+    nodes8.clear();
+    order.clear();
+}
+
+bool BVH::isEmpty() const{
+    return nodes.empty() && nodes4.empty() && nodes8.empty();
+}
+
+int BVH::getWidth() const{
+    return width;
+}
+
+const std::vector<BVH::Node>& BVH::getNodes() const{
+    return nodes;
+}
+
+const std::vector<WideNode<4>>& BVH::getWideNodes4() const{
+    return nodes4;
+}
+
+const std::vector<WideNode<8>>& BVH::getWideNodes8() const{
+    return nodes8;
+}
+
+const std::vector<int>& BVH::getOrder() const{
+    return order;
+}
+
+int BVH::buildNode(const std::vector<BoundingBox> &boxes, std::vector<Point> &centroids, int start, int end, int depth){
+    int index = nodes.size();
+    nodes.push_back(Node());
+
+    BoundingBox box;
+    BoundingBox centroidBox;
+    for(int i = start; i < end; i++){
+        box.add(boxes[order[i]]);
+        centroidBox.add(centroids[order[i]]);
+    }
+
+    Node &n = nodes[index];
+    n.min[0] = box.min.x;
+    n.min[1] = box.min.y;
+    n.min[2] = box.min.z;
+    n.max[0] = box.max.x;
+    n.max[1] = box.max.y;
+    n.max[2] = box.max.z;
+    n.offset = start;
+    n.count = end - start;
+
+    int count = end - start;
+    if(count <= minLeafSize){
+        return index;
+    }
+
+    // Finds the cheapest split over all three axes by sorting the centroids into buckets along each axis
+    // and trying a split between every pair of neighbouring buckets
+    float bestCost = INFINITY;
+    int bestAxis = -1;
+    int bestSplit = -1;
+    if(depth < BVH_MAX_DEPTH){
+        for(int axis = 0; axis < 3; axis++){
+            float lo = component(centroidBox.min, axis);
+            float hi = component(centroidBox.max, axis);
+            if(hi <= lo){
+                continue;
+            }
+
+            int binCounts[BVH_BINS] = {0};
+            BoundingBox binBoxes[BVH_BINS];
+            float scale = BVH_BINS/(hi - lo);
+            for(int i = start; i < end; i++){
+                int b = std::min(BVH_BINS - 1, (int)((component(centroids[order[i]], axis) - lo)*scale));
+                binCounts[b]++;
+                binBoxes[b].add(boxes[order[i]]);
+            }
+
+            // Sweeps from the right to get the area and count of every right side
+            float rightAreas[BVH_BINS];
+            int rightCounts[BVH_BINS];
+            BoundingBox right;
+            int rightCount = 0;
+            for(int b = BVH_BINS - 1; b > 0; b--){
+                right.add(binBoxes[b]);
+                rightCount += binCounts[b];
+                rightAreas[b] = surfaceArea(right);
+                rightCounts[b] = rightCount;
+            }
+
+            // Then from the left, split b puts buckets [0, b) on the left
+            BoundingBox left;
+            int leftCount = 0;
+            for(int b = 1; b < BVH_BINS; b++){
+                left.add(binBoxes[b - 1]);
+                leftCount += binCounts[b - 1];
+                if(leftCount == 0 || rightCounts[b] == 0){
+                    continue;
+                }
+                float cost = surfaceArea(left)*leftCount + rightAreas[b]*rightCounts[b];
+                if(cost < bestCost){
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestSplit = b;
+                }
+            }
+        }
+    }
+
+    int mid = -1;
+    if(bestAxis != -1){
+        // Cost of the split relative to testing every primitive in this node, one unit is added for
+        // testing the two child boxes
+        float area = surfaceArea(box);
+        float splitCost = area > 0 ? 1 + bestCost/area : count;
+        if(splitCost >= count && count <= BVH_MAX_LEAF_SIZE){
+            return index;
+        }
+
+        float lo = component(centroidBox.min, bestAxis);
+        float scale = BVH_BINS/(component(centroidBox.max, bestAxis) - lo);
+        int* splitPoint = std::partition(order.data() + start, order.data() + end, [&](int i){
+            return std::min(BVH_BINS - 1, (int)((component(centroids[i], bestAxis) - lo)*scale)) < bestSplit;
+        });
+        mid = splitPoint - order.data();
+    }
+
+    // Every centroid is in the same place or the tree is too deep, splits the primitives in half instead
+    if(mid <= start || mid >= end){
+        if(count <= BVH_MAX_LEAF_SIZE){
+            return index;
+        }
+        mid = start + count/2;
+        int axis = 0;
+        Tuple extent = centroidBox.max - centroidBox.min;
+        if(extent.y > extent.x && extent.y >= extent.z){
+            axis = 1;
+        }else if(extent.z > extent.x && extent.z > extent.y){
+            axis = 2;
+        }
+        std::nth_element(order.begin() + start, order.begin() + mid, order.begin() + end, [&](int a, int b){
+            return component(centroids[a], axis) < component(centroids[b], axis);
+        });
+    }
+
+    // The left child is built directly after this node, nodes can reallocate so n is not used after this
+    buildNode(boxes, centroids, start, mid, depth + 1);
+    int right = buildNode(boxes, centroids, mid, end, depth + 1);
+    nodes[index].offset = right;
+    nodes[index].count = 0;
+
+    return index;
+}
+
+// Starts with the binary node as the only child and keeps replacing the interior child with the largest surface area
+// with its two children until there are N children or every child is a leaf. Opening the largest box first keeps
+// the children about the same size, which is what the binary tree's levels would have tested anyway
+template<int N>
+int BVH::collapseNode(std::vector<WideNode<N>> &wide, int node){
+    int children[N];
+    int size = 1;
+    children[0] = node;
+
+    while(size < N){
+        int largest = -1;
+        float largestArea = -1;
+        for(int i = 0; i < size; i++){
+            const Node &n = nodes[children[i]];
+            if(n.count > 0){
+                continue;
+            }
+            BoundingBox b(Point(n.min[0], n.min[1], n.min[2]), Point(n.max[0], n.max[1], n.max[2]));
+            float area = surfaceArea(b);
+            if(area > largestArea){
+                largest = i;
+                largestArea = area;
+            }
+        }
+
+        if(largest == -1){
+            break;
+        }
+
+        // The left child is directly after its parent and offset is the right child
+        int opened = children[largest];
+        children[largest] = opened + 1;
+        children[size++] = nodes[opened].offset;
+    }
+
+    int index = wide.size();
+    wide.push_back(WideNode<N>());
+    for(int i = 0; i < N; i++){
+        for(int bound = 0; bound < 6; bound++){
+            wide[index].bounds[bound][i] = 0;
+        }
+        wide[index].child[i] = 0;
+        wide[index].count[i] = 0;
+    }
+    wide[index].size = size;
+
+    for(int i = 0; i < size; i++){
+        const Node &n = nodes[children[i]];
+        for(int axis = 0; axis < 3; axis++){
+            wide[index].bounds[axis][i] = n.min[axis];
+            wide[index].bounds[axis + 3][i] = n.max[axis];
+        }
+
+        // wide can reallocate while the child is collapsed so the node is indexed again afterwards
+        if(n.count > 0){
+            wide[index].child[i] = n.offset;
+            wide[index].count[i] = n.count;
+        }else{
+            int child = collapseNode(wide, children[i]);
+            wide[index].child[i] = child;
+        }
+    }
+
+    return index;
+}
\ No newline at end of file
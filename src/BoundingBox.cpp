@@ -0,0 +1,100 @@
+#include "BoundingBox.h"
+
+// Empty box, min is larger than max so adding any point makes the box that point
+BoundingBox::BoundingBox(){
+    min = Point(INFINITY, INFINITY, INFINITY);
+    max = Point(-INFINITY, -INFINITY, -INFINITY);
+}
+
+BoundingBox::BoundingBox(Point min, Point max){
+    this->min = min;
+    this->max = max;
+}
+
+void BoundingBox::add(Point p){
+    min = Point(std::min(min.x, p.x), std::min(min.y, p.y), std::min(min.z, p.z));
+    max = Point(std::max(max.x, p.x), std::max(max.y, p.y), std::max(max.z, p.z));
+}
+
+void BoundingBox::add(const BoundingBox &b){
+    if(b.isEmpty()){
+        return;
+    }
+    add(b.min);
+    add(b.max);
+}
+
+bool BoundingBox::isEmpty() const{
+    return min.x > max.x || min.y > max.y || min.z > max.z;
+}
+
+bool BoundingBox::isUnbounded() const{
+    return min.x == -INFINITY || min.y == -INFINITY || min.z == -INFINITY ||
+           max.x == INFINITY || max.y == INFINITY || max.z == INFINITY;
+}
+
+bool BoundingBox::containsPoint(Point p) const{
+    return min.x <= p.x && p.x <= max.x && min.y <= p.y && p.y <= max.y && min.z <= p.z && p.z <= max.z;
+}
+
+// Transforms all 8 corners of the box and returns the box containing them
+BoundingBox BoundingBox::transform(const Matrix4 &m) const{
+    if(isEmpty()){
+        return BoundingBox();
+    }
+
+    // Infinite components would turn into NaN when multiplied by 0, so an unbounded box
+    // is treated as extending infinitely in every direction after being transformed
+    if(isUnbounded()){
+        return BoundingBox(Point(-INFINITY, -INFINITY, -INFINITY), Point(INFINITY, INFINITY, INFINITY));
+    }
+
+    BoundingBox result;
+    for(int i = 0; i < 8; i++){
+        Point corner(i & 1 ? max.x : min.x, i & 2 ? max.y : min.y, i & 4 ? max.z : min.z);
+        result.add(Point(m*corner));
+    }
+
+    return result;
+}
+
+// Slab test, computes the times the ray enters and exits the planes of each pair of faces. Similar to Cube::childIntersections
+// the largest entering time and smallest exiting time are when the ray enters and exits the box
+bool BoundingBox::intersects(Ray r) const{
+    if(isEmpty()){
+        return false;
+    }
+    if(isUnbounded()){
+        return true;
+    }
+
+    Point origin = r.getOrigin();
+    Vector direction = r.getDirection();
+    const float o[3] = {origin.x, origin.y, origin.z};
+    const float d[3] = {direction.x, direction.y, direction.z};
+    const float lo[3] = {min.x, min.y, min.z};
+    const float hi[3] = {max.x, max.y, max.z};
+
+    float tmin = -INFINITY;
+    float tmax = INFINITY;
+    for(int axis = 0; axis < 3; axis++){
+        // Ray is parallel to the faces, it only passes through the box if it starts between them
+        if(d[axis] == 0){
+            if(o[axis] < lo[axis] || o[axis] > hi[axis]){
+                return false;
+            }
+            continue;
+        }
+
+        float t0 = (lo[axis] - o[axis])/d[axis];
+        float t1 = (hi[axis] - o[axis])/d[axis];
+        if(t0 > t1){
+            std::swap(t0, t1);
+        }
+        tmin = std::max(tmin, t0);
+        tmax = std::min(tmax, t1);
+    }
+
+    // EPSILON allows rays that graze a box edge or pass through flat boxes(eg. triangles) to still be tested
+    return tmin <= tmax + EPSILON;
+}
@@ -6,6 +6,12 @@ CSG::CSG(SetOperation op, Shape* l, Shape* r){
     right = r;
     l->setParent(this);
     r->setParent(this);
+    cullWithBounds = true;
+    childBoundsChanged();
+
+    // Numbers this CSG and its children, if this CSG is inside another CSG it gets renumbered when that CSG is made
+    int next = 0;
+    assignSubtreeIds(next);
 }
 
 Shape* CSG::getLeft(){
@@ -34,18 +40,24 @@ bool CSG::validIntersection(bool hitLeft, bool insideLeft, bool insideRight){
 }
 
 std::vector<Intersection> CSG::filterIntersections(std::vector<Intersection> intersects){
-    std::vector<Intersection> result;
+    filterIntersections(intersects, 0);
+    return intersects;
+}
 
+// Valid intersections are moved forward over the invalid ones so no other vector is needed
+void CSG::filterIntersections(std::vector<Intersection> &intersects, int start){
     // Ray starts outside of both shapes
     bool insideLeft = false;
     bool insideRight = false;
 
-    for(int i = 0; i < intersects.size(); i++){
-        // Checks which shape the ray hits(left or right)
-        bool hitLeft = left->includes(intersects.at(i).getShape());
+    int kept = start;
+    for(int i = start; i < intersects.size(); i++){
+        // Checks which shape the ray hits(left or right), shapes hit through an instance belong to the instance's side
+        Shape* s = intersects[i].getInstance() != nullptr ? intersects[i].getInstance() : intersects[i].getShape();
+        bool hitLeft = inLeft(s);
 
         if(validIntersection(hitLeft, insideLeft, insideRight)){
-            result.push_back(intersects.at(i));
+            intersects[kept++] = intersects[i];
         }
 
         // Ray is entering or exiting the shape that it hit(left or right)
@@ -56,24 +68,56 @@ std::vector<Intersection> CSG::filterIntersections(std::vector<Intersection> int
         }
     }
 
-    return result;
+    intersects.erase(intersects.begin() + kept, intersects.end());
 }
 
 bool CSG::includes(Shape* s){
     return left->includes(s) || right->includes(s);
 }
 
-std::vector<Intersection> CSG::childIntersections(Ray r){
-    std::vector<Intersection> leftIntersects = left->findIntersections(r);
-    std::vector<Intersection> rightIntersects = right->findIntersections(r);
+bool CSG::inLeft(Shape* s){
+    int id = s->getSubtreeId();
+    return leftStart <= id && id < leftEnd;
+}
+
+// The left subtree is numbered right after this CSG so its ids are one contiguous range
+void CSG::assignSubtreeIds(int &next){
+    subtreeId = next++;
+    leftStart = next;
+    left->assignSubtreeIds(next);
+    leftEnd = next;
+    right->assignSubtreeIds(next);
+}
+
+void CSG::childIntersections(Ray r, std::vector<Intersection> &intersects){
+    // Adds the intersections of the left and right shapes to the end of the buffer
+    int start = intersects.size();
+    left->findIntersections(r, intersects);
+    int mid = intersects.size();
+    right->findIntersections(r, intersects);
 
-    // Concatenates intersections of left and right shapes into one vector
-    std::vector<Intersection> intersects;
-    intersects.insert(intersects.end(), leftIntersects.begin(), leftIntersects.end());
-    intersects.insert(intersects.end(), rightIntersects.begin(), rightIntersects.end());
+    // Both lists are already sorted
+    mergeIntersections(intersects, start, mid);
 
-    // Sorts concatenated vector
-    std::sort(intersects.begin(), intersects.end(), compareIntersections);
+    filterIntersections(intersects, start);
+}
+
+BoundingBox CSG::bounds(){
+    return box;
+}
+
+// The union of both children's boxes, every set operation only produces intersections on one of the children
+// The children are only intersected through the CSG, so only the CSG is added to leaves
+void CSG::commit(const Matrix4 &parentWorld, const Matrix4 &parentWorldInverse, CommittedLeaves* leaves){
+    Shape::commit(parentWorld, parentWorldInverse, leaves);
+    Matrix4 world = parentWorld*transform;
+    left->commit(world, worldInverse, nullptr);
+    right->commit(world, worldInverse, nullptr);
+}
 
-    return filterIntersections(intersects);
+void CSG::childBoundsChanged(){
+    box = BoundingBox();
+    box.add(left->parentSpaceBounds());
+    box.add(right->parentSpaceBounds());
+    updateParentBounds();
 }
\ No newline at end of file
@@ -5,7 +5,7 @@ Camera::Camera(int h, int v, float fov){
     hsize = h;
     vsize = v;
     this->fov = fov;
-    transform = Matrix(4);
+    transform = Matrix4();
     computePixelSize();
 }
 
@@ -22,7 +22,7 @@ float Camera::getFOV(){
     return fov;
 }
 
-Matrix Camera::getTransform(){
+const Matrix4& Camera::getTransform(){
     return transform;
 }
 
@@ -31,8 +31,11 @@ float Camera::getPixelSize(){
 }
 
 // Setter variables for camera
-void Camera::setTransform(Matrix m){
+void Camera::setTransform(const Matrix4 &m){
     transform = m;
+    inverseTransform = m.inverse();
+    origin = Point(inverseTransform*Point());
+    computeRayDeltas();
 }
 
 // Computes the size of a pixel in the units of the world eg. if the pixel size is 0.01 then 
@@ -59,6 +62,16 @@ void Camera::computePixelSize(){
     }
 
     pixel_size = half_width*2/hsize;
+    computeRayDeltas();
+}
+
+// The canvas point of pixel (x, y) is (half_width - (x + 0.5)*pixel_size, half_height - (y + 0.5)*pixel_size, -1)
+// which changes linearly with x and y. Transforming the point of pixel (0, 0) and the offset between neighbouring
+// pixels to world space once means every pixel's world position is found with two multiply-adds
+void Camera::computeRayDeltas(){
+    firstPixel = Point(inverseTransform*Point(half_width - 0.5*pixel_size, half_height - 0.5*pixel_size, -1));
+    columnStep = Vector(inverseTransform*Vector(-pixel_size, 0, 0));
+    rowStep = Vector(inverseTransform*Vector(0, -pixel_size, 0));
 }
 
 // Computes a ray that starts at the camera and goes through the canvas at the specified xy pixel
@@ -67,39 +80,75 @@ Ray Camera::rayToPixel(int x, int y){
         throw std::invalid_argument("rayToPixel xy invalid");
     }
 
-    // Offset of canvas edge to center of pixel
-    float xOffset = (x + 0.5)*pixel_size;
-    float yOffset = (y + 0.5)*pixel_size;
-
-    // half_width is the largest x value for rays that go through the canvas,
-    // half_height is the largest y value for rays that go through the canvas.
-    // Subtracting by the offset will represent the xy coordinate from the corner
-    // (max(x), max(y)) of the canvas
-    float xWorld = half_width - xOffset;
-    float yWorld = half_height - yOffset;
-
-    // transforms the canvas point and camera origin to their
-    // world positions
-    Point pixel = Point(transform.inverse()*Point(xWorld, yWorld, -1));
-    Point origin = Point(transform.inverse()*Point());
+    // World position of the pixel center, computed in the same order as raysForTile so both produce the same rays
+    Point pixel = Point((firstPixel + rowStep*y) + columnStep*x);
     Vector direction = Vector(pixel - origin).normalize();
 
     return Ray(origin, direction);
 }
 
+// Computes the rays for a tile of pixels, starting from the world position of each row and stepping along it
+void Camera::raysForTile(int x, int y, int w, int h, std::vector<Ray> &rays){
+    rays.resize(w*h);
+
+    for(int j = 0; j < h; j++){
+        Tuple rowStart = firstPixel + rowStep*(y + j);
+        for(int i = 0; i < w; i++){
+            Point pixel = Point(rowStart + columnStep*(x + i));
+            rays[j*w + i] = Ray(origin, Vector(pixel - origin).normalize());
+        }
+    }
+}
+
+static_assert(RENDER_TILE_SIZE % PACKET_SIZE == 0, "RENDER_TILE_SIZE has to be a multiple of PACKET_SIZE");
+
+// Colours count neighbouring pixels of one row starting at x, y. Traces them PACKET_SIZE at a time when packets are enabled
+// and the rest one at a time. Tiles start at multiples of RENDER_TILE_SIZE, which is a multiple of PACKET_SIZE, so every pixel
+// is in the same packet whether the canvas is rendered in tiles or in rows. Only the last tile of a row can end part way
+// through a packet, its last pixels are traced one at a time
+static void renderRow(World &w, const Ray* rays, int count, Canvas &image, int x, int y){
+    int i = 0;
+    if(RENDER_RAY_PACKETS){
+        Colour colours[PACKET_SIZE];
+        for(; i + PACKET_SIZE <= count; i += PACKET_SIZE){
+            w.colourAtHitPacket(rays + i, colours);
+            for(int j = 0; j < PACKET_SIZE; j++){
+                image.write_pixel(x + i + j, y, colours[j]);
+            }
+        }
+    }
+
+    for(; i < count; i++){
+        image.write_pixel(x + i, y, w.colourAtHit(rays[i]));
+    }
+}
+
 // Renders the world using the camera and world properties
-Canvas Camera::render(World w){
+Canvas Camera::render(World &w, int threads){
     Canvas image(hsize, vsize);
-    Ray r;
-    Colour col;
-
-    for(int y = 0; y < vsize; y++){
-        for(int x = 0; x < hsize; x++){
-            r = this->rayToPixel(x, y);
-            col = w.colourAtHit(r);
-            image.write_pixel(x, y, col);
+    w.commit();
+
+    if(threads == 1){
+        std::vector<Ray> rays;
+
+        // Generates the rays one scanline at a time
+        for(int y = 0; y < vsize; y++){
+            raysForTile(0, y, hsize, 1, rays);
+            renderRow(w, rays.data(), hsize, image, 0, y);
         }
+
+        return image;
     }
 
+    // Each tile writes to its own pixels so the threads never write to the same part of the canvas
+    TileScheduler scheduler(hsize, vsize, RENDER_TILE_SIZE, threads);
+    scheduler.run([&](int x, int y, int width, int height){
+        std::vector<Ray> rays;
+        raysForTile(x, y, width, height, rays);
+        for(int j = 0; j < height; j++){
+            renderRow(w, rays.data() + j*width, width, image, x, y + j);
+        }
+    });
+
     return image;
 }
\ No newline at end of file
@@ -17,7 +17,7 @@ Colour::Colour(float r, float g, float b){
 }
 
 // Checks if two colours are equal
-bool Colour::isEqual(Colour a){
+bool Colour::isEqual(Colour a) const{
     if(!floatIsEqual(r, a.r) || !floatIsEqual(g, a.g) || !floatIsEqual(b, a.b)){
         return false;
     }
@@ -2,10 +2,12 @@
 
 Group::Group(){
     name = "";
+    cullWithBounds = true;
 }
 
 Group::Group(std::string n){
     name = n;
+    cullWithBounds = true;
 }
 
 std::vector<Shape*> Group::getShapes(){
@@ -15,21 +17,106 @@ std::vector<Shape*> Group::getShapes(){
 void Group::appendShape(Shape* s){
     shapes.push_back(s);
     s->setParent(this);
+    box.add(s->parentSpaceBounds());
+    bvhBuilt = false;
+    updateParentBounds();
+    updateSubtreeIds();
 }
 
-std::vector<Intersection> Group::childIntersections(Ray r){
-    std::vector<Intersection> intersects;
-    std::vector<Intersection> temp;
+void Group::buildBVH(){
+    std::lock_guard<std::mutex> guard(bvhLock);
+    if(bvhBuilt){
+        return;
+    }
 
+    bvhShapes.clear();
+    unboundedShapes.clear();
+    std::vector<BoundingBox> boxes;
     for(int i = 0; i < shapes.size(); i++){
-        temp = shapes.at(i)->findIntersections(r);
-        for(int j = 0; j < temp.size(); j++){
-            intersects.push_back(temp.at(j));
+        BoundingBox b = shapes.at(i)->parentSpaceBounds();
+        // Shapes with empty bounds(eg. empty groups) can never be hit
+        if(b.isUnbounded()){
+            unboundedShapes.add(shapes.at(i), shapes.at(i)->getInverseTransform());
+        }else if(!b.isEmpty()){
+            bvhShapes.add(shapes.at(i), shapes.at(i)->getInverseTransform());
+            boxes.push_back(b);
+        }
+    }
+
+    bvh.build(boxes);
+    bvhBuilt = true;
+}
+
+// Adds the intersections of every child to the buffer, then merges the children's sorted lists together
+void Group::childIntersections(Ray r, std::vector<Intersection> &intersects){
+    if(!bvhBuilt){
+        buildBVH();
+    }
+
+    std::vector<int> &runs = runBuffer();
+    int firstRun = runs.size();
+    for(int i = 0; i < unboundedShapes.size(); i++){
+        runs.push_back(intersects.size());
+        unboundedShapes.intersections(i, r, intersects);
+    }
+
+    // Every intersection is needed(including ones behind the ray) so the traversal is never cut short
+    bvh.traverse(r, -INFINITY, INFINITY, [&](int i, float tmax){
+        runs.push_back(intersects.size());
+        bvhShapes.intersections(i, r, intersects);
+        return tmax;
+    });
+    mergeRuns(intersects, runs, firstRun);
+    runs.resize(firstRun);
+}
+
+// Stops at the first child that blocks the ray
+bool Group::childOccluded(Ray r, float tmax){
+    if(!bvhBuilt){
+        buildBVH();
+    }
+
+    for(int i = 0; i < unboundedShapes.size(); i++){
+        if(unboundedShapes.occluded(i, r, tmax)){
+            return true;
+        }
+    }
+
+    bool occluded = false;
+    bvh.traverse(r, 0, tmax, [&](int i, float t){
+        if(bvhShapes.occluded(i, r, tmax)){
+            occluded = true;
+            return -INFINITY;
+        }
+        return t;
+    });
+
+    return occluded;
+}
+
+// Every hit shrinks tmax so the hierarchy can skip everything behind it
+bool Group::childClosestHit(Ray r, float tmin, float tmax, Intersection &hit){
+    if(!bvhBuilt){
+        buildBVH();
+    }
+
+    bool found = false;
+    for(int i = 0; i < unboundedShapes.size(); i++){
+        if(unboundedShapes.closestHit(i, r, tmin, tmax, hit)){
+            tmax = hit.getTime();
+            found = true;
         }
     }
 
-    std::sort(intersects.begin(), intersects.end(), compareIntersections);
-    return intersects;
+    bvh.traverse(r, tmin, tmax, [&](int i, float t){
+        if(bvhShapes.closestHit(i, r, tmin, t, hit)){
+            found = true;
+            return hit.getTime();
+        }
+        return t;
+    });
+
+    return found;
 }
 
 bool Group::includes(Shape* s){
@@ -40,4 +127,39 @@ bool Group::includes(Shape* s){
     }
 
     return false;
+}
+
+void Group::assignSubtreeIds(int &next){
+    subtreeId = next++;
+    for(int i = 0; i < shapes.size(); i++){
+        shapes.at(i)->assignSubtreeIds(next);
+    }
+}
+
+// Groups in the world are flattened, their children are added to leaves instead of the group. Groups only reached through
+// another shape build their own hierarchy now so it is not built while rendering
+void Group::commit(const Matrix4 &parentWorld, const Matrix4 &parentWorldInverse, CommittedLeaves* leaves){
+    bakeWorldTransform(parentWorldInverse);
+    if(leaves == nullptr){
+        buildBVH();
+    }
+
+    Matrix4 world = parentWorld*transform;
+    for(int i = 0; i < shapes.size(); i++){
+        shapes.at(i)->commit(world, worldInverse, leaves);
+    }
+}
+
+BoundingBox Group::bounds(){
+    return box;
+}
+
+// Recomputes the box from all of the children since the changed child could have shrunk
+void Group::childBoundsChanged(){
+    box = BoundingBox();
+    for(int i = 0; i < shapes.size(); i++){
+        box.add(shapes.at(i)->parentSpaceBounds());
+    }
+    bvhBuilt = false;
+    updateParentBounds();
 }
\ No newline at end of file
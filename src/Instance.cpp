@@ -0,0 +1,142 @@
+#include "Instance.h"
+#include "Group.h"
+#include "Mesh.h"
+#include "CSG.h"
+
+// Hits only store one instance, so instances inside a prototype are not allowed
+static bool containsInstance(Shape* s){
+    if(dynamic_cast<Instance*>(s) != nullptr){
+        return true;
+    }
+
+    Group* g = dynamic_cast<Group*>(s);
+    if(g != nullptr){
+        std::vector<Shape*> shapes = g->getShapes();
+        for(int i = 0; i < shapes.size(); i++){
+            if(containsInstance(shapes.at(i))){
+                return true;
+            }
+        }
+        return false;
+    }
+
+    CSG* c = dynamic_cast<CSG*>(s);
+    if(c != nullptr){
+        return containsInstance(c->getLeft()) || containsInstance(c->getRight());
+    }
+
+    return false;
+}
+
+// Builds the prototype's hierarchy now so every instance shares it rather than the first ray through each one building it
+Instance::Instance(Shape* prototype){
+    if(prototype == nullptr || prototype->getParent() != nullptr || containsInstance(prototype)){
+        throw std::invalid_argument("Instance:Instance - Invalid input: prototype must be a shape with no parent that contains no instances");
+    }
+
+    this->prototype = prototype;
+    if(Group* g = dynamic_cast<Group*>(prototype)){
+        g->buildBVH();
+    }else if(Mesh* m = dynamic_cast<Mesh*>(prototype)){
+        m->buildBVH();
+    }
+}
+
+Shape* Instance::getPrototype(){
+    return prototype;
+}
+
+void Instance::setMaterialOverride(const Material &m){
+    setMaterial(m);
+    overridesMaterial = true;
+}
+
+void Instance::clearMaterialOverride(){
+    setMaterial(Material());
+    overridesMaterial = false;
+}
+
+bool Instance::hasMaterialOverride(){
+    return overridesMaterial;
+}
+
+const Material& Instance::materialOf(Shape* s, Shape* instance, int solid){
+    Instance* i = static_cast<Instance*>(instance);
+    if(i != nullptr && i->hasMaterialOverride()){
+        return i->getMaterial();
+    }
+    return s->getSolidMaterial(solid);
+}
+
+void Instance::markHits(std::vector<Intersection> &intersects, int start){
+    for(int i = start; i < intersects.size(); i++){
+        intersects[i].setInstance(this);
+    }
+}
+
+// Instances are equal if they place the same prototype with the same material override
+bool Instance::childEqual(Shape* s){
+    Instance* i = dynamic_cast<Instance*>(s);
+    if(i == nullptr){
+        return false;
+    }
+
+    return prototype == i->getPrototype() && overridesMaterial == i->hasMaterialOverride();
+}
+
+// The ray is already in the instance's space, which is the space the prototype is placed in
+void Instance::childIntersections(Ray r, std::vector<Intersection> &intersects){
+    int start = intersects.size();
+    prototype->findIntersections(r, intersects);
+    markHits(intersects, start);
+}
+
+// With a material override the override decides whether the instance casts shadows, otherwise the prototype's shapes do
+bool Instance::childOccluded(Ray r, float tmax){
+    if(!overridesMaterial){
+        return prototype->isOccluded(r, tmax);
+    }
+
+    Intersection hit(0, nullptr);
+    return getMaterial().castsShadow && prototype->findClosestHit(r, 0, tmax, hit);
+}
+
+bool Instance::childClosestHit(Ray r, float tmin, float tmax, Intersection &hit){
+    if(!prototype->findClosestHit(r, tmin, tmax, hit)){
+        return false;
+    }
+
+    hit.setInstance(this);
+    return true;
+}
+
+bool Instance::includes(Shape* s){
+    return isEqual(s) || prototype->includes(s);
+}
+
+// The prototype's transforms are baked relative to the prototype, hits through the instance add the instance's own
+// The prototype is only recorded here and the world commits each distinct prototype once, so many instances of a large
+// prototype do not each commit it again. Instances in a CSG have no leaves to record into and commit the prototype
+// themselves if it is out of date
+void Instance::commit(const Matrix4 &parentWorld, const Matrix4 &parentWorldInverse, CommittedLeaves* leaves){
+    if(prototype->getParent() != nullptr){
+        throw std::invalid_argument("Instance:commit - Invalid input: prototype must not have a parent");
+    }
+
+    Shape::commit(parentWorld, parentWorldInverse, leaves);
+    if(leaves != nullptr){
+        leaves->prototypes.push_back(prototype);
+    }else if(!prototype->isCommitted()){
+        prototype->commit(Matrix4(), Matrix4(), nullptr);
+    }
+}
+
+// Sum of two counters that only go up, so it changes whenever either does
+unsigned int Instance::getVersion(){
+    return version + prototype->getVersion();
+}
+
+// Computed from the prototype every time since the prototype does not tell its instances when it changes
+BoundingBox Instance::bounds(){
+    return prototype->parentSpaceBounds();
+}
@@ -1,7 +1,14 @@
 #include "Intersection.h"
 #include "Shape.h"
+#include "Instance.h"
+#include <algorithm>
 
 // Intersection constructors
+Intersection::Intersection(){
+    time = 0;
+    s = nullptr;
+}
+
 Intersection::Intersection(float t, Shape* s){
     time = t;
     this->s = s;
@@ -14,25 +21,49 @@ Intersection::Intersection(float t, Shape* s, float u, float v){
     this->v = v;
 }
 
+Intersection::Intersection(float t, Shape* s, float u, float v, int index){
+    time = t;
+    this->s = s;
+    this->u = u;
+    this->v = v;
+    this->index = index;
+}
+
 // Getters for Intersection variables
-float Intersection::getTime(){
+float Intersection::getTime() const{
     return time;
 }
 
-Shape* Intersection::getShape(){
+Shape* Intersection::getShape() const{
     return s;
 }
 
-float Intersection::getU(){
+float Intersection::getU() const{
     return u;
 }
 
-float Intersection::getV(){
+float Intersection::getV() const{
     return v;
 }
 
-bool Intersection::isEqual(Intersection i){
-    return floatIsEqual(time, i.getTime()) && s == i.getShape();
+int Intersection::getIndex() const{
+    return index;
+}
+
+Shape* Intersection::getInstance() const{
+    return instance;
+}
+
+void Intersection::setInstance(Shape* i){
+    instance = i;
+}
+
+const Material& Intersection::getMaterial() const{
+    return Instance::materialOf(s, instance, s->solidOf(index));
+}
+
+bool Intersection::isEqual(Intersection i) const{
+    return floatIsEqual(time, i.getTime()) && s == i.getShape() && instance == i.getInstance();
 }
 
 // Aggregating intersections into a vector
@@ -58,4 +89,89 @@ int hit(std::vector<Intersection> vec){
 // Used for std::sort function
 bool compareIntersections(Intersection a, Intersection b){
     return a.getTime() < b.getTime();
+}
+
+// Merges from the back so only the new intersections need to be copied out of the way. Children are usually visited
+// nearest first so most of the time the lists are already in order and nothing is moved
+void mergeIntersections(std::vector<Intersection> &intersects, int start, int mid){
+    int end = intersects.size();
+    if(start == mid || mid == end || intersects[mid - 1].getTime() <= intersects[mid].getTime()){
+        return;
+    }
+
+    // Reused between calls, nothing is called while it is in use so nested groups can share it
+    thread_local std::vector<Intersection> newIntersects;
+    newIntersects.assign(intersects.begin() + mid, intersects.end());
+
+    int i = mid - 1;
+    int j = newIntersects.size() - 1;
+    int k = end - 1;
+    while(j >= 0){
+        // Ties keep the earlier list first
+        if(i >= start && intersects[i].getTime() > newIntersects[j].getTime()){
+            intersects[k--] = intersects[i--];
+        }else{
+            intersects[k--] = newIntersects[j--];
+        }
+    }
+}
+
+std::vector<int>& runBuffer(){
+    thread_local std::vector<int> runs;
+    return runs;
+}
+
+// The runs are merged with a min heap of the run each next intersection could come from, ties take the earlier run first
+void mergeRuns(std::vector<Intersection> &intersects, const std::vector<int> &runs, int firstRun){
+    int end = intersects.size();
+    // Reused between calls, nothing is called while they are in use so nested groups can share them
+    thread_local std::vector<int> next, ends, heap;
+    next.clear();
+    ends.clear();
+    for(int i = firstRun; i < runs.size(); i++){
+        int runEnd = i + 1 < runs.size() ? runs[i + 1] : end;
+        if(runs[i] < runEnd){
+            next.push_back(runs[i]);
+            ends.push_back(runEnd);
+        }
+    }
+
+    // Children are usually visited nearest first so most of the time the runs are already in order and nothing is moved
+    bool sorted = true;
+    for(int i = 1; i < next.size() && sorted; i++){
+        sorted = intersects[next[i] - 1].getTime() <= intersects[next[i]].getTime();
+    }
+    if(sorted){
+        return;
+    }
+    if(next.size() == 2){
+        mergeIntersections(intersects, next[0], next[1]);
+        return;
+    }
+
+    auto later = [&](int a, int b){
+        float ta = intersects[next[a]].getTime();
+        float tb = intersects[next[b]].getTime();
+        return ta > tb || (ta == tb && a > b);
+    };
+    heap.clear();
+    for(int i = 0; i < next.size(); i++){
+        heap.push_back(i);
+    }
+    std::make_heap(heap.begin(), heap.end(), later);
+
+    thread_local std::vector<Intersection> merged;
+    merged.clear();
+    int first = next[0];
+    while(!heap.empty()){
+        std::pop_heap(heap.begin(), heap.end(), later);
+        int run = heap.back();
+        merged.push_back(intersects[next[run]++]);
+        if(next[run] < ends[run]){
+            std::push_heap(heap.begin(), heap.end(), later);
+        }else{
+            heap.pop_back();
+        }
+    }
+    std::copy(merged.begin(), merged.end(), intersects.begin() + first);
 }
\ No newline at end of file
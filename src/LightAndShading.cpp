@@ -47,7 +47,7 @@ Material::Material(){
 }
 
 // Material equality checker
-bool Material::isEqual(Material m){
+bool Material::isEqual(const Material &m) const{
     if(!colour.isEqual(m.colour)){
         return false;
     }
@@ -79,8 +79,54 @@ bool Material::isEqual(Material m){
     return true;
 }
 
+// Materials are only shared if every value matches exactly, isEqual allows small differences and ignores the pattern
+static bool identicalMaterials(const Material &a, const Material &b){
+    return a.colour.r == b.colour.r && a.colour.g == b.colour.g && a.colour.b == b.colour.b && a.pattern == b.pattern &&
+           a.ambient == b.ambient && a.diffuse == b.diffuse && a.specular == b.specular && a.shininess == b.shininess &&
+           a.reflective == b.reflective && a.transparency == b.transparency && a.refractiveIndex == b.refractiveIndex &&
+           a.castsShadow == b.castsShadow;
+}
+
+// Combines the hash of every value identicalMaterials compares
+size_t MaterialTable::hash(const Material &m){
+    const float values[] = {m.colour.r, m.colour.g, m.colour.b, m.ambient, m.diffuse, m.specular, m.shininess, m.reflective,
+                            m.transparency, m.refractiveIndex};
+    size_t h = std::hash<const Pattern*>()(m.pattern) ^ m.castsShadow;
+    for(float v : values){
+        h ^= std::hash<float>()(v) + 0x9e3779b9 + (h << 6) + (h >> 2);
+    }
+    return h;
+}
+
+int MaterialTable::add(const Material &m){
+    size_t h = hash(m);
+    auto range = indices.equal_range(h);
+    for(auto i = range.first; i != range.second; i++){
+        if(identicalMaterials(materials[i->second], m)){
+            return i->second;
+        }
+    }
+
+    materials.push_back(m);
+    indices.emplace(h, materials.size() - 1);
+    return materials.size() - 1;
+}
+
+const Material& MaterialTable::get(int id) const{
+    return materials[id];
+}
+
+int MaterialTable::size() const{
+    return materials.size();
+}
+
+void MaterialTable::clear(){
+    materials.clear();
+    indices.clear();
+}
+
 // Calculates the updated colour value of a point based on the ray, light, and object/material attributes
-Colour computeLighting(Material m, Shape* object, LightSource l, Point p, Vector camera, Vector normal, bool inShadow){
+Colour computeLighting(const Material &m, Shape* object, LightSource l, Point p, Vector camera, Vector normal, bool inShadow){
     Colour colour;
     if(m.pattern == nullptr){
         colour = m.colour;
@@ -1,8 +1,12 @@
 #include "LightData.h"
+#include "Instance.h"
+#include <unordered_map>
 
-// Light data constructor
+// Light data constructor, nothing is allocated so it can be made on the stack for every hit
 LightData::LightData(){
-    object = new Sphere;
+    object = nullptr;
+    instance = nullptr;
+    solid = -1;
     time = 0;
     point = Point();
     camera = Vector();
@@ -14,12 +18,18 @@ LightData::LightData(){
     n2 = 1;
 }
 
-// Packs the data required for the computeLighting function into the LightData data structure
-LightData prepareLightData(Intersection i, Ray r, std::vector<Intersection> rayIntersects){
+const Material& LightData::getMaterial() const{
+    return Instance::materialOf(object, instance, solid);
+}
+
+// Packs the data required for the computeLighting function into the LightData data structure, except for the refractive indices
+static LightData surfaceData(Intersection i, Ray r){
     LightData data;
 
     data.time = i.getTime();
     data.object = i.getShape();
+    data.instance = i.getInstance();
+    data.solid = data.object->solidOf(i.getIndex());
 
     data.point = r.computePosition(data.time);
     data.camera = Vector(r.getDirection().negateTuple());
@@ -34,57 +44,102 @@ LightData prepareLightData(Intersection i, Ray r, std::vector<Intersection> rayI
     data.overPoint = data.point + data.normal*EPSILON;
     data.underPoint = data.point - data.normal*EPSILON;
 
-    findRefractiveIndices(data, i, rayIntersects);
+    return data;
+}
 
+// Packs the data required for the computeLighting function into the LightData data structure
+LightData prepareLightData(Intersection i, Ray r, const std::vector<Intersection> &rayIntersects){
+    LightData data = surfaceData(i, r);
+    findRefractiveIndices(data, i, rayIntersects);
     return data;
 }
 
-// Algorithm for computing the refractive indices of the material being exited and the material being entered
-void findRefractiveIndices(LightData &data, Intersection i, std::vector<Intersection> rayIntersects){
-    std::vector<Shape*> containers;
+LightData prepareLightData(const std::vector<Intersection> &rayIntersects, int hitIndex, Ray r){
+    LightData data = surfaceData(rayIntersects.at(hitIndex), r);
+    findRefractiveIndices(data, hitIndex, rayIntersects);
+    return data;
+}
 
+// Finds the index of the hit and computes the refractive indices, if the hit is not in the list n1 and n2 are left unchanged
+void findRefractiveIndices(LightData &data, Intersection i, const std::vector<Intersection> &rayIntersects){
     for(int a = 0; a < rayIntersects.size(); a++){
-        // if the current index is the hit
         if(rayIntersects.at(a).isEqual(i)){
-            // Ray is not currently in any object
-            if(containers.empty()){
-                data.n1 = 1.0;
-            }else{
-                // n1 refractive index is set to the last shape's material in containers because the ray is exiting that shape
-                data.n1 = containers.back()->getMaterial().refractiveIndex;
-            }
+            findRefractiveIndices(data, a, rayIntersects);
+            return;
         }
+    }
+}
+
+// Shapes in a prototype are shared by all of its instances, so a shape the ray is inside of is identified by the shape and
+// the instance it was hit through, and by the solid for shapes made of separate solids
+struct Container{
+    Shape* shape;
+    Shape* instance;
+    int solid;
 
-        bool enteredObject = false;
-        int b;
-        for(b = 0; b < containers.size(); b++){
-            if(rayIntersects.at(a).getShape() == containers.at(b)){
-                enteredObject = true;
-                break;
+    bool operator==(const Container &c) const{
+        return shape == c.shape && instance == c.instance && solid == c.solid;
+    }
+};
+
+struct ContainerHash{
+    size_t operator()(const Container &c) const{
+        return (std::hash<Shape*>()(c.shape)*31 + std::hash<Shape*>()(c.instance))*31 + std::hash<int>()(c.solid);
+    }
+};
+
+// Algorithm for computing the refractive indices of the material being exited and the material being entered
+// The shapes the ray is inside of are kept on a stack in the order they were entered. Exiting a shape only marks it as exited
+// and exited shapes are removed once they reach the top of the stack, so every intersection is handled in constant time
+void findRefractiveIndices(LightData &data, int hitIndex, const std::vector<Intersection> &rayIntersects){
+    // Reused between calls so refracted rays do not allocate once they have been used
+    thread_local std::vector<Container> containers;
+    // Position in containers of each shape the ray is currently inside of
+    thread_local std::unordered_map<Container, int, ContainerHash> entries;
+    containers.clear();
+    entries.clear();
+
+    // Refractive index of the last entered shape that the ray is still inside of
+    auto currentIndex = [&](){
+        while(!containers.empty()){
+            auto entry = entries.find(containers.back());
+            if(entry != entries.end() && entry->second == containers.size() - 1){
+                const Container &c = containers.back();
+                return Instance::materialOf(c.shape, c.instance, c.solid).refractiveIndex;
             }
+            containers.pop_back();
+        }
+        // Ray is not currently in any object
+        return 1.0f;
+    };
+
+    // Intersections after the hit do not affect it
+    for(int a = 0; a <= hitIndex; a++){
+        // n1 refractive index is set to the last shape's material in containers because the ray is exiting that shape
+        if(a == hitIndex){
+            data.n1 = currentIndex();
         }
 
-        if(enteredObject){
-            containers.erase(containers.begin() + b);
+        Shape* shape = rayIntersects[a].getShape();
+        Container s{shape, rayIntersects[a].getInstance(), shape->solidOf(rayIntersects[a].getIndex())};
+        auto entry = entries.find(s);
+        if(entry != entries.end()){
+            entries.erase(entry);
         }else{
-            containers.push_back(rayIntersects.at(a).getShape());
+            entries[s] = containers.size();
+            containers.push_back(s);
         }
 
-        if(rayIntersects.at(a).isEqual(i)){
-            // Ray is not currently in any object
-            if(containers.empty()){
-                data.n2 = 1.0;
-            }else{
-                // n2 refractive index is set to the refractive index of the last shape that was entered
-                data.n2 = containers.back()->getMaterial().refractiveIndex;
-            }
+        // n2 refractive index is set to the refractive index of the last shape that was entered
+        if(a == hitIndex){
+            data.n2 = currentIndex();
         }
     }
 }
 
 // Approximates Fresnel Effect using Schlick's approximation
 // Refer to "Reflections and Refractions in Ray Tracing" by Bram de Greve
-float schlickApproximation(LightData data){
+float schlickApproximation(const LightData &data){
     // cosine of the angle between camera and normal vector
     float cos = dotProduct(data.camera, data.normal);
 
@@ -61,6 +61,19 @@ Matrix::Matrix(int r, int c, std::vector<std::vector<float>> vec){
     }
 }
 
+// Constructor copying a fixed size 4x4 matrix
+Matrix::Matrix(Matrix4 m){
+    rows = 4;
+    cols = 4;
+
+    matrix = std::vector<std::vector<float>>(rows, std::vector<float> (cols, 0));
+    for(int r = 0; r < rows; r++){
+        for(int c = 0; c < cols; c++){
+            matrix[r][c] = m(r, c);
+        }
+    }
+}
+
 // Checks if given xy coordinates are within range of the matrix dimensions
 bool Matrix::checkCoordValid(int x, int y){
     if(x > -1 && y > -1 && x < rows && y < cols){
@@ -252,6 +265,9 @@ float Matrix::determinant(){
 
     if(rows == 2 && cols == 2){
         return this->twoDet();
+    }else if(rows == 4 && cols == 4){
+        // 4x4 matrices use the closed form determinant
+        return Matrix4(*this).determinant();
     }else{
         float det = 0;
         // Calculating determinant which is the sum of (every element in any row or col*cofactor of each element)
@@ -269,6 +285,10 @@ bool Matrix::isInvertable(){
     if(rows != cols || rows == 1){
         return false;
     }
+    // Uses the same test as inverse, which goes through Matrix4 for 4x4 matrices
+    if(rows == 4){
+        return Matrix4(*this).isInvertable();
+    }
 
     return !floatIsEqual(this->determinant(), 0.0f);
 }
@@ -276,6 +296,15 @@ bool Matrix::isInvertable(){
 // Computes inverse of matrix
 // Element [r, c] = cofactor(c, r)/det
 Matrix Matrix::inverse(){
+    // 4x4 matrices use the closed form inverse instead of computing every cofactor recursively
+    if(rows == 4 && cols == 4){
+        Matrix4 result;
+        if(!Matrix4(*this).tryInverse(result)){
+            throw std::invalid_argument("inverse: Matrix is not invertable\n" + toString());
+        }
+        return Matrix(result);
+    }
+
     if(!this->isInvertable()){
         throw std::invalid_argument("inverse: Matrix is not invertable\n" + toString());
     }
@@ -292,6 +321,254 @@ Matrix Matrix::inverse(){
     return m;
 }
 
+// Matrix4 constructors
+// Default constructor generates the 4x4 identity matrix
+Matrix4::Matrix4(){
+    for(int i = 0; i < 16; i++){
+        m[i] = 0;
+    }
+    m[0] = 1;
+    m[5] = 1;
+    m[10] = 1;
+    m[15] = 1;
+}
+
+// Converts a generic matrix to a Matrix4, only valid for 4x4 matrices
+Matrix4::Matrix4(Matrix mat){
+    if(mat.getRows() != 4 || mat.getCols() != 4){
+        throw std::invalid_argument("Matrix4: Invalid matrix dimensions");
+    }
+
+    for(int r = 0; r < 4; r++){
+        for(int c = 0; c < 4; c++){
+            m[r*4 + c] = mat.getElement(r, c);
+        }
+    }
+}
+
+// Checks if given xy coordinates are within range of a 4x4 matrix
+bool Matrix4::checkCoordValid(int x, int y){
+    return x > -1 && y > -1 && x < 4 && y < 4;
+}
+
+// Getter for element at coord xy
+float Matrix4::getElement(int x, int y) const{
+    if(!checkCoordValid(x, y)){
+        throw std::invalid_argument("getElement: received invalid xy coordinates [" + std::to_string(x) + ", " + std::to_string(y) + "]");
+    }
+    return m[x*4 + y];
+}
+
+// Sets element in matrix at coord xy to val
+void Matrix4::setElement(int x, int y, float val){
+    if(!checkCoordValid(x, y)){
+        throw std::invalid_argument("setElement: received invalid xy coordinates [" + std::to_string(x) + ", " + std::to_string(y) + "]");
+    }
+    m[x*4 + y] = val;
+}
+
+// Converts matrix to string
+std::string Matrix4::toString() const{
+    std::string s = "";
+    for(int r = 0; r < 4; r++){
+        s += "[";
+        for(int c = 0; c < 4; c++){
+            s += std::to_string(m[r*4 + c]) + " ";
+        }
+        s += "]\n";
+    }
+
+    return s;
+}
+
+// Matrix equality check
+bool Matrix4::isEqual(const Matrix4 &a) const{
+    for(int i = 0; i < 16; i++){
+        if(!floatIsEqual(m[i], a.m[i])){
+            return false;
+        }
+    }
+    return true;
+}
+
+// Computes the transpose of the matrix
+Matrix4 Matrix4::transpose() const{
+    Matrix4 result;
+    for(int r = 0; r < 4; r++){
+        for(int c = 0; c < 4; c++){
+            result.m[c*4 + r] = m[r*4 + c];
+        }
+    }
+
+    return result;
+}
+
+// Checks if the last row of the matrix is 0, 0, 0, 1. Translation, scaling, rotation, shearing, and any
+// chain of them all produce matrices like this
+bool Matrix4::isAffine() const{
+    return m[12] == 0 && m[13] == 0 && m[14] == 0 && m[15] == 1;
+}
+
+// Computes the determinant by expanding along the first row using the 2x2 determinants of the bottom two rows
+// so no submatrices have to be created
+float Matrix4::determinant() const{
+    if(isAffine()){
+        // The determinant of an affine matrix is the determinant of the top left 3x3 matrix
+        return m[0]*(m[5]*m[10] - m[6]*m[9]) - m[1]*(m[4]*m[10] - m[6]*m[8]) + m[2]*(m[4]*m[9] - m[5]*m[8]);
+    }
+
+    float s0 = m[8]*m[13] - m[9]*m[12];
+    float s1 = m[8]*m[14] - m[10]*m[12];
+    float s2 = m[8]*m[15] - m[11]*m[12];
+    float s3 = m[9]*m[14] - m[10]*m[13];
+    float s4 = m[9]*m[15] - m[11]*m[13];
+    float s5 = m[10]*m[15] - m[11]*m[14];
+
+    return m[0]*(m[5]*s5 - m[6]*s4 + m[7]*s3)
+         - m[1]*(m[4]*s5 - m[6]*s2 + m[7]*s1)
+         + m[2]*(m[4]*s4 - m[5]*s2 + m[7]*s0)
+         - m[3]*(m[4]*s3 - m[5]*s1 + m[6]*s0);
+}
+
+// The product of the row lengths bounds the determinant(Hadamard's inequality), so comparing against it makes the test
+// independent of the scale of the matrix
+bool Matrix4::isSingular(float det, int size) const{
+    float bound = 1;
+    for(int r = 0; r < size; r++){
+        float lengthSquared = 0;
+        for(int c = 0; c < size; c++){
+            lengthSquared += m[r*4 + c]*m[r*4 + c];
+        }
+        bound *= std::sqrt(lengthSquared);
+    }
+    return !(std::abs(det) > MATRIX_SINGULAR_TOLERANCE*bound);
+}
+
+// Checks if the matrix is invertable
+bool Matrix4::isInvertable() const{
+    return !isSingular(determinant(), isAffine() ? 3 : 4);
+}
+
+// Computes the inverse of the matrix into result, returns false if the matrix is not invertable
+bool Matrix4::tryInverse(Matrix4 &result) const{
+    if(isAffine()){
+        // For an affine matrix [A t; 0 1] the inverse is [inverse(A) -inverse(A)*t; 0 1]
+        // so only the 3x3 matrix A has to be inverted
+        float c00 = m[5]*m[10] - m[6]*m[9];
+        float c01 = m[6]*m[8] - m[4]*m[10];
+        float c02 = m[4]*m[9] - m[5]*m[8];
+        float det = m[0]*c00 + m[1]*c01 + m[2]*c02;
+        if(isSingular(det, 3)){
+            return false;
+        }
+
+        float invDet = 1.0f/det;
+        float r[16];
+        r[0] = c00*invDet;
+        r[1] = (m[2]*m[9] - m[1]*m[10])*invDet;
+        r[2] = (m[1]*m[6] - m[2]*m[5])*invDet;
+        r[4] = c01*invDet;
+        r[5] = (m[0]*m[10] - m[2]*m[8])*invDet;
+        r[6] = (m[2]*m[4] - m[0]*m[6])*invDet;
+        r[8] = c02*invDet;
+        r[9] = (m[1]*m[8] - m[0]*m[9])*invDet;
+        r[10] = (m[0]*m[5] - m[1]*m[4])*invDet;
+
+        // Back transforms the translation
+        r[3] = -(r[0]*m[3] + r[1]*m[7] + r[2]*m[11]);
+        r[7] = -(r[4]*m[3] + r[5]*m[7] + r[6]*m[11]);
+        r[11] = -(r[8]*m[3] + r[9]*m[7] + r[10]*m[11]);
+
+        r[12] = 0;
+        r[13] = 0;
+        r[14] = 0;
+        r[15] = 1;
+
+        for(int i = 0; i < 16; i++){
+            result.m[i] = r[i];
+        }
+        return true;
+    }
+
+    // General case, the inverse is the adjugate(transpose of the cofactors) divided by the determinant
+    // The cofactors are built from the 2x2 determinants of the top two rows(s) and bottom two rows(c)
+    float s0 = m[0]*m[5] - m[1]*m[4];
+    float s1 = m[0]*m[6] - m[2]*m[4];
+    float s2 = m[0]*m[7] - m[3]*m[4];
+    float s3 = m[1]*m[6] - m[2]*m[5];
+    float s4 = m[1]*m[7] - m[3]*m[5];
+    float s5 = m[2]*m[7] - m[3]*m[6];
+
+    float c5 = m[10]*m[15] - m[11]*m[14];
+    float c4 = m[9]*m[15] - m[11]*m[13];
+    float c3 = m[9]*m[14] - m[10]*m[13];
+    float c2 = m[8]*m[15] - m[11]*m[12];
+    float c1 = m[8]*m[14] - m[10]*m[12];
+    float c0 = m[8]*m[13] - m[9]*m[12];
+
+    float det = s0*c5 - s1*c4 + s2*c3 + s3*c2 - s4*c1 + s5*c0;
+    if(isSingular(det, 4)){
+        return false;
+    }
+
+    float invDet = 1.0f/det;
+    float r[16];
+    r[0] = (m[5]*c5 - m[6]*c4 + m[7]*c3)*invDet;
+    r[1] = (-m[1]*c5 + m[2]*c4 - m[3]*c3)*invDet;
+    r[2] = (m[13]*s5 - m[14]*s4 + m[15]*s3)*invDet;
+    r[3] = (-m[9]*s5 + m[10]*s4 - m[11]*s3)*invDet;
+
+    r[4] = (-m[4]*c5 + m[6]*c2 - m[7]*c1)*invDet;
+    r[5] = (m[0]*c5 - m[2]*c2 + m[3]*c1)*invDet;
+    r[6] = (-m[12]*s5 + m[14]*s2 - m[15]*s1)*invDet;
+    r[7] = (m[8]*s5 - m[10]*s2 + m[11]*s1)*invDet;
+
+    r[8] = (m[4]*c4 - m[5]*c2 + m[7]*c0)*invDet;
+    r[9] = (-m[0]*c4 + m[1]*c2 - m[3]*c0)*invDet;
+    r[10] = (m[12]*s4 - m[13]*s2 + m[15]*s0)*invDet;
+    r[11] = (-m[8]*s4 + m[9]*s2 - m[11]*s0)*invDet;
+
+    r[12] = (-m[4]*c3 + m[5]*c1 - m[6]*c0)*invDet;
+    r[13] = (m[0]*c3 - m[1]*c1 + m[2]*c0)*invDet;
+    r[14] = (-m[12]*s3 + m[13]*s1 - m[14]*s0)*invDet;
+    r[15] = (m[8]*s3 - m[9]*s1 + m[10]*s0)*invDet;
+
+    for(int i = 0; i < 16; i++){
+        result.m[i] = r[i];
+    }
+    return true;
+}
+
+// Computes inverse of matrix
+Matrix4 Matrix4::inverse() const{
+    Matrix4 result;
+    if(!tryInverse(result)){
+        throw std::invalid_argument("inverse: Matrix is not invertable\n" + toString());
+    }
+
+    return result;
+}
+
+// Matrix multiplication, the loops have fixed bounds so the compiler can fully unroll them
+Matrix4 Matrix4::operator*(const Matrix4 &m2) const{
+    Matrix4 result;
+    for(int r = 0; r < 4; r++){
+        for(int c = 0; c < 4; c++){
+            result.m[r*4 + c] = m[r*4]*m2.m[c] + m[r*4 + 1]*m2.m[4 + c] + m[r*4 + 2]*m2.m[8 + c] + m[r*4 + 3]*m2.m[12 + c];
+        }
+    }
+
+    return result;
+}
+
+// Matrix multiplication with a tuple
+Tuple Matrix4::operator*(const Tuple &t) const{
+    return Tuple(m[0]*t.x + m[1]*t.y + m[2]*t.z + m[3]*t.point,
+                 m[4]*t.x + m[5]*t.y + m[6]*t.z + m[7]*t.point,
+                 m[8]*t.x + m[9]*t.y + m[10]*t.z + m[11]*t.point,
+                 m[12]*t.x + m[13]*t.y + m[14]*t.z + m[15]*t.point);
+}
+
 // Computes translation matrix given x, y, and z
 // When this matrix is multiplied with a Point
 // The point will be translated in the x direction
@@ -299,9 +576,9 @@ Matrix Matrix::inverse(){
 // the z direction z units away
 // Additionally, multiplying a Vector by this matrix will
 // do nothing because of the point variable being 0.0
-Matrix translationMatrix(float x, float y, float z){
+Matrix4 translationMatrix(float x, float y, float z){
     // Generates 4x4 identity matrix
-    Matrix m(4);
+    Matrix4 m;
 
     // Translation matrix is equivalent to:
     // 1 0 0 x
@@ -318,9 +595,9 @@ Matrix translationMatrix(float x, float y, float z){
 // Does same thing as translation matrix but the multiplied tuple
 // is scaled instead. Works for both points and vectors
 // Can also perform reflection using negative input parameters
-Matrix scalingMatrix(float x, float y, float z){
+Matrix4 scalingMatrix(float x, float y, float z){
     // Generates 4x4 identity matrix
-    Matrix m(4);
+    Matrix4 m;
 
     // Scaling matrix is equivalent to:
     // x 0 0 0
@@ -338,9 +615,9 @@ Matrix scalingMatrix(float x, float y, float z){
 // Does same thing as translation matrix but the multiplied tuple
 // is rotated along specified axis in funct name instead. Works 
 // for points and vectors
-Matrix xRotationMatrix(float r){
+Matrix4 xRotationMatrix(float r){
     // Generates 4x4 identity matrix
-    Matrix m(4);
+    Matrix4 m;
 
     // Scaling matrix is equivalent to:
     // 1  0      0      0
@@ -355,9 +632,9 @@ Matrix xRotationMatrix(float r){
     return m;
 }
 
-Matrix yRotationMatrix(float r){
+Matrix4 yRotationMatrix(float r){
     // Generates 4x4 identity matrix
-    Matrix m(4);
+    Matrix4 m;
 
     // Scaling matrix is equivalent to:
     // cos(r)  0 sin(r) 0
@@ -372,9 +649,9 @@ Matrix yRotationMatrix(float r){
     return m;
 }
 
-Matrix zRotationMatrix(float r){
+Matrix4 zRotationMatrix(float r){
     // Generates 4x4 identity matrix
-    Matrix m(4);
+    Matrix4 m;
 
     // Scaling matrix is equivalent to:
     // cos(r) -sin(r) 0 0
@@ -393,9 +670,9 @@ Matrix zRotationMatrix(float r){
 // the more the x value changes. This can be applied to x and z too(x_z) and other axis combinations
 // as seen in the parameters. This has the effect of making a straight line slanted, etc. Meant to be 
 // used for points, although vectors would work
-Matrix shearingMatrix(float x_y, float x_z, float y_x, float y_z, float z_x, float z_y){
+Matrix4 shearingMatrix(float x_y, float x_z, float y_x, float y_z, float z_x, float z_y){
     // Generates 4x4 identity matrix
-    Matrix m(4);
+    Matrix4 m;
 
     // Scaling matrix is equivalent to:
     // 1   x_y x_z 0
@@ -415,8 +692,8 @@ Matrix shearingMatrix(float x_y, float x_z, float y_x, float y_z, float z_x, flo
 // Chaining transformations, input the matrix transformations as parameters to produce
 // a matrix that performs all transformations at once when multiplied
 // eg. Resulting matrix is equal to C*(B*(A*I)) if input is {A, B, C}
-Matrix chainTransformationMatrices(std::initializer_list<Matrix> matrices){
-    Matrix result = Matrix(4);
+Matrix4 chainTransformationMatrices(std::initializer_list<Matrix4> matrices){
+    Matrix4 result;
     for (auto m : matrices) {
         result = m*result;
     }
@@ -443,11 +720,11 @@ Matrix chainTransformationMatrices(std::initializer_list<Matrix> matrices){
 // Afterwards, multiply this matrix by the translationMatrix(-cameraPosition). This is because since you are actually
 // moving the world relative to the camera, you need to orient the scene and then move it to the appropriate position
 // relative to the camera
-Matrix viewTransformationMatrix(Point cameraPosition, Point to, Vector up){
+Matrix4 viewTransformationMatrix(Point cameraPosition, Point to, Vector up){
     Vector forward = Vector((to - cameraPosition)).normalize();
     Vector left = crossProduct(forward, up.normalize());
     Vector trueUp = crossProduct(left, forward);
-    Matrix orientation(4);
+    Matrix4 orientation;
 
     orientation.setElement(0, 0, left.x);
     orientation.setElement(0, 1, left.y);
@@ -0,0 +1,411 @@
+#include "Mesh.h"
+#ifdef __AVX__
+#include <immintrin.h>
+#endif
+
+int Mesh::addVertex(Point p){
+    vertices.push_back(p);
+    return vertices.size() - 1;
+}
+
+int Mesh::addNormal(Vector n){
+    normals.push_back(n);
+    return normals.size() - 1;
+}
+
+void Mesh::checkIndex(int i, int size, const std::string &function){
+    if(i < 0 || i >= size){
+        throw std::invalid_argument("Mesh:" + function + " - Invalid input: " + std::to_string(i));
+    }
+}
+
+void Mesh::addTriangle(int v1, int v2, int v3){
+    checkIndex(v1, vertices.size(), "addTriangle");
+    checkIndex(v2, vertices.size(), "addTriangle");
+    checkIndex(v3, vertices.size(), "addTriangle");
+    indices.push_back(v1);
+    indices.push_back(v2);
+    indices.push_back(v3);
+    if(!normalIndices.empty()){
+        normalIndices.insert(normalIndices.end(), 3, -1);
+    }
+
+    // Parents only need to know if the box grew, which stops a mesh in a group from updating the group for every triangle
+    BoundingBox old = box;
+    box.add(vertices[v1]);
+    box.add(vertices[v2]);
+    box.add(vertices[v3]);
+    bvhBuilt = false;
+    if(!old.containsPoint(box.min) || !old.containsPoint(box.max)){
+        updateParentBounds();
+    }else{
+        changed();
+    }
+}
+
+void Mesh::addTriangle(int v1, int v2, int v3, int n1, int n2, int n3){
+    checkIndex(n1, normals.size(), "addTriangle");
+    checkIndex(n2, normals.size(), "addTriangle");
+    checkIndex(n3, normals.size(), "addTriangle");
+    addTriangle(v1, v2, v3);
+
+    // The first smooth triangle fills in the normal indices of every triangle before it
+    if(normalIndices.empty()){
+        normalIndices.assign(indices.size(), -1);
+    }
+    normalIndices.end()[-3] = n1;
+    normalIndices.end()[-2] = n2;
+    normalIndices.end()[-1] = n3;
+}
+
+const std::vector<Point>& Mesh::getVertices(){
+    return vertices;
+}
+
+const std::vector<Vector>& Mesh::getNormals(){
+    return normals;
+}
+
+const std::vector<int>& Mesh::getIndices(){
+    return indices;
+}
+
+int Mesh::triangleCount(){
+    return indices.size()/3;
+}
+
+bool Mesh::isSmooth(int triangle){
+    return !normalIndices.empty() && normalIndices[3*triangle] != -1;
+}
+
+void Mesh::triangleEdges(int i, Point &p1, Vector &e1, Vector &e2){
+    p1 = vertices[indices[3*i]];
+    e1 = vertices[indices[3*i + 1]] - p1;
+    e2 = vertices[indices[3*i + 2]] - p1;
+}
+
+// Copies the triangles in the order the hierarchy's leaves reference them, so every leaf is a contiguous run of triangles. A leaf
+// of a whole block costs about the same to test as one triangle, so nodes are only split once they no longer fit in a block
+void Mesh::buildBVH(){
+    std::lock_guard<std::mutex> guard(bvhLock);
+    if(bvhBuilt){
+        return;
+    }
+
+    int count = triangleCount();
+    std::vector<BoundingBox> boxes(count);
+    for(int i = 0; i < count; i++){
+        boxes[i].add(vertices[indices[3*i]]);
+        boxes[i].add(vertices[indices[3*i + 1]]);
+        boxes[i].add(vertices[indices[3*i + 2]]);
+    }
+    bvh.build(boxes, BVH_WIDTH, TRIANGLE_BLOCK_SIZE);
+    const std::vector<int> &order = bvh.getOrder();
+
+    // Padding has a NaN corner so every comparison in intersectBlock fails
+    int size = count + TRIANGLE_BLOCK_SIZE;
+    std::vector<float>* arrays[9] = {&blocks.p1x, &blocks.p1y, &blocks.p1z, &blocks.e1x, &blocks.e1y, &blocks.e1z, &blocks.e2x, &blocks.e2y, &blocks.e2z};
+    for(int i = 0; i < 9; i++){
+        arrays[i]->assign(size, NAN);
+    }
+    blocks.triangle.assign(size, -1);
+    for(int i = 0; i < count; i++){
+        int s = order[i];
+        Point p1;
+        Vector e1, e2;
+        triangleEdges(s, p1, e1, e2);
+        blocks.p1x[i] = p1.x;
+        blocks.p1y[i] = p1.y;
+        blocks.p1z[i] = p1.z;
+        blocks.e1x[i] = e1.x;
+        blocks.e1y[i] = e1.y;
+        blocks.e1z[i] = e1.z;
+        blocks.e2x[i] = e2.x;
+        blocks.e2y[i] = e2.y;
+        blocks.e2z[i] = e2.z;
+        blocks.triangle[i] = s;
+    }
+
+    bvhBuilt = true;
+}
+
+// Same steps as Triangle::intersectTriangle with a triangle in every lane, a lane that fails a step is masked off. The lanes
+// past count hold the next leaf's triangles(or padding) and are masked off at the end
+int Mesh::intersectBlock(int first, int count, const float origin[3], const float direction[3], float tmin, float tmax,
+                         float t[TRIANGLE_BLOCK_SIZE], float u[TRIANGLE_BLOCK_SIZE], float v[TRIANGLE_BLOCK_SIZE]){
+    int lanes = (1 << count) - 1;
+#ifdef __AVX__
+    __m256 dx = _mm256_set1_ps(direction[0]), dy = _mm256_set1_ps(direction[1]), dz = _mm256_set1_ps(direction[2]);
+    __m256 e1x = _mm256_loadu_ps(&blocks.e1x[first]), e1y = _mm256_loadu_ps(&blocks.e1y[first]), e1z = _mm256_loadu_ps(&blocks.e1z[first]);
+    __m256 e2x = _mm256_loadu_ps(&blocks.e2x[first]), e2y = _mm256_loadu_ps(&blocks.e2y[first]), e2z = _mm256_loadu_ps(&blocks.e2z[first]);
+
+    // dir_cross_e2 and the determinant
+    __m256 cx = _mm256_sub_ps(_mm256_mul_ps(dy, e2z), _mm256_mul_ps(dz, e2y));
+    __m256 cy = _mm256_sub_ps(_mm256_mul_ps(dz, e2x), _mm256_mul_ps(dx, e2z));
+    __m256 cz = _mm256_sub_ps(_mm256_mul_ps(dx, e2y), _mm256_mul_ps(dy, e2x));
+    __m256 det = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(e1x, cx), _mm256_mul_ps(e1y, cy)), _mm256_mul_ps(e1z, cz));
+    __m256 absDet = _mm256_andnot_ps(_mm256_set1_ps(-0.0f), det);
+    __m256 valid = _mm256_cmp_ps(absDet, _mm256_set1_ps(EPSILON), _CMP_GE_OQ);
+    __m256 f = _mm256_div_ps(_mm256_set1_ps(1), det);
+
+    // p1_to_origin and the p1-p3 edge
+    __m256 sx = _mm256_sub_ps(_mm256_set1_ps(origin[0]), _mm256_loadu_ps(&blocks.p1x[first]));
+    __m256 sy = _mm256_sub_ps(_mm256_set1_ps(origin[1]), _mm256_loadu_ps(&blocks.p1y[first]));
+    __m256 sz = _mm256_sub_ps(_mm256_set1_ps(origin[2]), _mm256_loadu_ps(&blocks.p1z[first]));
+    __m256 uLanes = _mm256_mul_ps(f, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(sx, cx), _mm256_mul_ps(sy, cy)), _mm256_mul_ps(sz, cz)));
+    valid = _mm256_and_ps(valid, _mm256_cmp_ps(uLanes, _mm256_setzero_ps(), _CMP_GE_OQ));
+    valid = _mm256_and_ps(valid, _mm256_cmp_ps(uLanes, _mm256_set1_ps(1), _CMP_LE_OQ));
+
+    // origin_cross_e1 and the p1-p2 and p2-p3 edges
+    __m256 qx = _mm256_sub_ps(_mm256_mul_ps(sy, e1z), _mm256_mul_ps(sz, e1y));
+    __m256 qy = _mm256_sub_ps(_mm256_mul_ps(sz, e1x), _mm256_mul_ps(sx, e1z));
+    __m256 qz = _mm256_sub_ps(_mm256_mul_ps(sx, e1y), _mm256_mul_ps(sy, e1x));
+    __m256 vLanes = _mm256_mul_ps(f, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, qx), _mm256_mul_ps(dy, qy)), _mm256_mul_ps(dz, qz)));
+    valid = _mm256_and_ps(valid, _mm256_cmp_ps(vLanes, _mm256_setzero_ps(), _CMP_GE_OQ));
+    valid = _mm256_and_ps(valid, _mm256_cmp_ps(_mm256_add_ps(uLanes, vLanes), _mm256_set1_ps(1), _CMP_LE_OQ));
+
+    __m256 tLanes = _mm256_mul_ps(f, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(e2x, qx), _mm256_mul_ps(e2y, qy)), _mm256_mul_ps(e2z, qz)));
+    valid = _mm256_and_ps(valid, _mm256_cmp_ps(tLanes, _mm256_set1_ps(tmin), _CMP_GE_OQ));
+    valid = _mm256_and_ps(valid, _mm256_cmp_ps(tLanes, _mm256_set1_ps(tmax), _CMP_LT_OQ));
+    _mm256_storeu_ps(t, tLanes);
+    _mm256_storeu_ps(u, uLanes);
+    _mm256_storeu_ps(v, vLanes);
+    return _mm256_movemask_ps(valid) & lanes;
+#elif defined(TUPLE_USE_SSE)
+    // Two passes of four without AVX
+    int mask = 0;
+    for(int i = 0; i < count; i += 4){
+        __m128 dx = _mm_set1_ps(direction[0]), dy = _mm_set1_ps(direction[1]), dz = _mm_set1_ps(direction[2]);
+        __m128 e1x = _mm_loadu_ps(&blocks.e1x[first + i]), e1y = _mm_loadu_ps(&blocks.e1y[first + i]), e1z = _mm_loadu_ps(&blocks.e1z[first + i]);
+        __m128 e2x = _mm_loadu_ps(&blocks.e2x[first + i]), e2y = _mm_loadu_ps(&blocks.e2y[first + i]), e2z = _mm_loadu_ps(&blocks.e2z[first + i]);
+
+        __m128 cx = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y));
+        __m128 cy = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z));
+        __m128 cz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+        __m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, cx), _mm_mul_ps(e1y, cy)), _mm_mul_ps(e1z, cz));
+        __m128 valid = _mm_cmpge_ps(_mm_andnot_ps(_mm_set1_ps(-0.0f), det), _mm_set1_ps(EPSILON));
+        __m128 f = _mm_div_ps(_mm_set1_ps(1), det);
+
+        __m128 sx = _mm_sub_ps(_mm_set1_ps(origin[0]), _mm_loadu_ps(&blocks.p1x[first + i]));
+        __m128 sy = _mm_sub_ps(_mm_set1_ps(origin[1]), _mm_loadu_ps(&blocks.p1y[first + i]));
+        __m128 sz = _mm_sub_ps(_mm_set1_ps(origin[2]), _mm_loadu_ps(&blocks.p1z[first + i]));
+        __m128 uLanes = _mm_mul_ps(f, _mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, cx), _mm_mul_ps(sy, cy)), _mm_mul_ps(sz, cz)));
+        valid = _mm_and_ps(valid, _mm_and_ps(_mm_cmpge_ps(uLanes, _mm_setzero_ps()), _mm_cmple_ps(uLanes, _mm_set1_ps(1))));
+
+        __m128 qx = _mm_sub_ps(_mm_mul_ps(sy, e1z), _mm_mul_ps(sz, e1y));
+        __m128 qy = _mm_sub_ps(_mm_mul_ps(sz, e1x), _mm_mul_ps(sx, e1z));
+        __m128 qz = _mm_sub_ps(_mm_mul_ps(sx, e1y), _mm_mul_ps(sy, e1x));
+        __m128 vLanes = _mm_mul_ps(f, _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_mul_ps(dy, qy)), _mm_mul_ps(dz, qz)));
+        valid = _mm_and_ps(valid, _mm_and_ps(_mm_cmpge_ps(vLanes, _mm_setzero_ps()), _mm_cmple_ps(_mm_add_ps(uLanes, vLanes), _mm_set1_ps(1))));
+
+        __m128 tLanes = _mm_mul_ps(f, _mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)));
+        valid = _mm_and_ps(valid, _mm_and_ps(_mm_cmpge_ps(tLanes, _mm_set1_ps(tmin)), _mm_cmplt_ps(tLanes, _mm_set1_ps(tmax))));
+        _mm_storeu_ps(t + i, tLanes);
+        _mm_storeu_ps(u + i, uLanes);
+        _mm_storeu_ps(v + i, vLanes);
+        mask |= _mm_movemask_ps(valid) << i;
+    }
+    return mask & lanes;
+#else
+    int mask = 0;
+    Ray r(Point(origin[0], origin[1], origin[2]), Vector(direction[0], direction[1], direction[2]));
+    for(int i = 0; i < count; i++){
+        int j = first + i;
+        Point p1(blocks.p1x[j], blocks.p1y[j], blocks.p1z[j]);
+        Vector e1(blocks.e1x[j], blocks.e1y[j], blocks.e1z[j]);
+        Vector e2(blocks.e2x[j], blocks.e2y[j], blocks.e2z[j]);
+        if(Triangle::intersectTriangle(r, p1, e1, e2, t[i], u[i], v[i]) && t[i] >= tmin && t[i] < tmax){
+            mask |= 1 << i;
+        }
+    }
+    return mask;
+#endif
+}
+
+int Mesh::closestInBlock(int first, int count, const float origin[3], const float direction[3], float tmin, float tmax, float &t, float &u, float &v){
+    float times[TRIANGLE_BLOCK_SIZE], us[TRIANGLE_BLOCK_SIZE], vs[TRIANGLE_BLOCK_SIZE];
+    int mask = intersectBlock(first, count, origin, direction, tmin, tmax, times, us, vs);
+    int closest = -1;
+    for(int i = 0; i < count; i++){
+        if((mask & (1 << i)) && (closest == -1 || times[i] < times[closest])){
+            closest = i;
+        }
+    }
+    if(closest == -1){
+        return -1;
+    }
+
+    t = times[closest];
+    u = us[closest];
+    v = vs[closest];
+    return blocks.triangle[first + closest];
+}
+
+// Checks equality of meshes, every vertex, normal and triangle has to match
+bool Mesh::childEqual(Shape* s){
+    Mesh* m = dynamic_cast<Mesh*>(s);
+    if(m == nullptr){
+        return false;
+    }
+
+    if(vertices.size() != m->getVertices().size() || normals.size() != m->getNormals().size() || indices != m->getIndices()){
+        return false;
+    }
+
+    for(int i = 0; i < vertices.size(); i++){
+        if(!vertices[i].isEqual(m->getVertices()[i])){
+            return false;
+        }
+    }
+
+    for(int i = 0; i < normals.size(); i++){
+        if(!normals[i].isEqual(m->getNormals()[i])){
+            return false;
+        }
+    }
+
+    for(int i = 0; i < triangleCount(); i++){
+        if(isSmooth(i) != m->isSmooth(i)){
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Every hit is its own run since the hierarchy visits triangles roughly but not exactly in order, the runs are merged at the end
+void Mesh::childIntersections(Ray r, std::vector<Intersection> &intersects){
+    if(!bvhBuilt){
+        buildBVH();
+    }
+
+    Point o = r.getOrigin();
+    Vector d = r.getDirection();
+    const float origin[3] = {o.x, o.y, o.z};
+    const float direction[3] = {d.x, d.y, d.z};
+
+    std::vector<int> &runs = runBuffer();
+    int firstRun = runs.size();
+    bvh.traverseLeaves(r, -INFINITY, INFINITY, [&](int first, int count, float tmax){
+        float t[TRIANGLE_BLOCK_SIZE], u[TRIANGLE_BLOCK_SIZE], v[TRIANGLE_BLOCK_SIZE];
+        int mask = intersectBlock(first, count, origin, direction, -INFINITY, INFINITY, t, u, v);
+        for(int i = 0; i < count; i++){
+            if(mask & (1 << i)){
+                runs.push_back(intersects.size());
+                intersects.push_back(Intersection(t[i], this, u[i], v[i], blocks.triangle[first + i]));
+            }
+        }
+        return tmax;
+    });
+    mergeRuns(intersects, runs, firstRun);
+    runs.resize(firstRun);
+}
+
+// Stops at the first leaf with a triangle that blocks the ray
+bool Mesh::childOccluded(Ray r, float tmax){
+    if(!getMaterial().castsShadow){
+        return false;
+    }
+
+    if(!bvhBuilt){
+        buildBVH();
+    }
+
+    Point o = r.getOrigin();
+    Vector d = r.getDirection();
+    const float origin[3] = {o.x, o.y, o.z};
+    const float direction[3] = {d.x, d.y, d.z};
+
+    bool occluded = false;
+    bvh.traverseLeaves(r, 0, tmax, [&](int first, int count, float t){
+        float times[TRIANGLE_BLOCK_SIZE], u[TRIANGLE_BLOCK_SIZE], v[TRIANGLE_BLOCK_SIZE];
+        if(intersectBlock(first, count, origin, direction, 0, tmax, times, u, v) != 0){
+            occluded = true;
+            return -INFINITY;
+        }
+        return t;
+    });
+
+    return occluded;
+}
+
+// Every hit shrinks tmax so the hierarchy can skip everything behind it
+bool Mesh::childClosestHit(Ray r, float tmin, float tmax, Intersection &hit){
+    if(!bvhBuilt){
+        buildBVH();
+    }
+
+    Point o = r.getOrigin();
+    Vector d = r.getDirection();
+    const float origin[3] = {o.x, o.y, o.z};
+    const float direction[3] = {d.x, d.y, d.z};
+
+    bool found = false;
+    bvh.traverseLeaves(r, tmin, tmax, [&](int first, int count, float tmax){
+        float t, u, v;
+        int triangle = closestInBlock(first, count, origin, direction, tmin, tmax, t, u, v);
+        if(triangle == -1){
+            return tmax;
+        }
+        hit = Intersection(t, this, u, v, triangle);
+        found = true;
+        return t;
+    });
+
+    return found;
+}
+
+// Traces the packet through the hierarchy together and tests each triangle of a leaf against every ray that reaches the leaf
+// at once, the triangle's corner and edges are read from the blocks
+int Mesh::childClosestHitPacket(const RayPacket &p, int mask, float tmin, float tmax[PACKET_SIZE], Intersection hits[PACKET_SIZE]){
+    if(!bvhBuilt){
+        buildBVH();
+    }
+
+    int found = 0;
+    bvh.traversePacketLeaves(p, mask, tmin, tmax, [&](int first, int count, int lanes){
+        for(int i = first; i < first + count; i++){
+            Point p1(blocks.p1x[i], blocks.p1y[i], blocks.p1z[i]);
+            Vector e1(blocks.e1x[i], blocks.e1y[i], blocks.e1z[i]);
+            Vector e2(blocks.e2x[i], blocks.e2y[i], blocks.e2z[i]);
+            float t[PACKET_SIZE], u[PACKET_SIZE], v[PACKET_SIZE];
+            int hit = Triangle::intersectTrianglePacket(p, lanes, p1, e1, e2, tmin, tmax, t, u, v);
+            for(int lane = 0; lane < PACKET_SIZE; lane++){
+                if(hit & (1 << lane)){
+                    hits[lane] = Intersection(t[lane], this, u[lane], v[lane], blocks.triangle[i]);
+                    tmax[lane] = t[lane];
+                }
+            }
+            found |= hit;
+        }
+    });
+
+    return found;
+}
+
+// Interpolates the vertex normals for smooth triangles, otherwise uses the normal of the flat triangle
+Vector Mesh::childNormal(Point p, Intersection hit){
+    int i = hit.getIndex();
+    checkIndex(i, triangleCount(), "childNormal");
+
+    if(isSmooth(i)){
+        Vector n1 = normals[normalIndices[3*i]];
+        Vector n2 = normals[normalIndices[3*i + 1]];
+        Vector n3 = normals[normalIndices[3*i + 2]];
+        return n2*hit.getU() + n3*hit.getV() + n1*(1 - hit.getU() - hit.getV());
+    }
+
+    Point p1;
+    Vector e1, e2;
+    triangleEdges(i, p1, e1, e2);
+    return crossProduct(e2, e1).normalize();
+}
+
+void Mesh::commit(const Matrix4 &parentWorld, const Matrix4 &parentWorldInverse, CommittedLeaves* leaves){
+    buildBVH();
+    Shape::commit(parentWorld, parentWorldInverse, leaves);
+}
+
+BoundingBox Mesh::bounds(){
+    return box;
+}
@@ -1,7 +1,7 @@
 #include "ObjParser.h"
 
 // .obj file parser, takes a string or file path based on isFile
-ObjParser::ObjParser(std::string file_path_or_content, bool isFile){
+ObjParser::ObjParser(std::string file_path_or_content, bool isFile, bool asMesh){
     std::istringstream content_stream(file_path_or_content);
     std::ifstream file_contents(file_path_or_content);
 
@@ -9,6 +9,10 @@ ObjParser::ObjParser(std::string file_path_or_content, bool isFile){
         throw std::invalid_argument("Obj file does not exist");
     }
 
+    if(asMesh){
+        mesh = new Mesh;
+    }
+
     std::string line;
     std::string x_str, y_str, z_str;
     float x, y, z;
@@ -23,7 +27,11 @@ ObjParser::ObjParser(std::string file_path_or_content, bool isFile){
             x = stof(x_str);
             y = stof(y_str);
             z = stof(z_str);
-            vertices.push_back(Point(x, y, z));
+            if(mesh != nullptr){
+                mesh->addVertex(Point(x, y, z));
+            }else{
+                vertices.push_back(Point(x, y, z));
+            }
         }else if(prefix == "f"){
             std::vector<int> vertice_inds = std::vector<int>();
             std::vector<int> normal_inds = std::vector<int>();
@@ -48,6 +56,10 @@ ObjParser::ObjParser(std::string file_path_or_content, bool isFile){
             Vector n1, n2, n3;
             if(vertice_inds.size() < 3){
                 throw std::invalid_argument("f prefix requires at least 3 vertices provided");
+            }else if(mesh != nullptr && vertice_inds.size() == 3 && normal_inds.size() == 3){
+                mesh->addTriangle(vertice_inds.at(0), vertice_inds.at(1), vertice_inds.at(2), normal_inds.at(0), normal_inds.at(1), normal_inds.at(2));
+            }else if(mesh != nullptr && vertice_inds.size() == 3){
+                mesh->addTriangle(vertice_inds.at(0), vertice_inds.at(1), vertice_inds.at(2));
             }else if(vertice_inds.size() == 3 && normal_inds.size() == 3){
                 p1 = vertices.at(vertice_inds.at(0));
                 p2 = vertices.at(vertice_inds.at(1));
@@ -86,7 +98,11 @@ ObjParser::ObjParser(std::string file_path_or_content, bool isFile){
             x = stof(x_str);
             y = stof(y_str);
             z = stof(z_str);
-            normals.push_back(Vector(x, y, z));
+            if(mesh != nullptr){
+                mesh->addNormal(Vector(x, y, z));
+            }else{
+                normals.push_back(Vector(x, y, z));
+            }
         }else{
             continue;
         }
@@ -95,6 +111,10 @@ ObjParser::ObjParser(std::string file_path_or_content, bool isFile){
 
 void ObjParser::fanTriangulation(std::vector<int> vertice_inds){
     for(int ind = 1; ind < vertice_inds.size() - 1; ind++){
+        if(mesh != nullptr){
+            mesh->addTriangle(vertice_inds.at(0), vertice_inds.at(ind), vertice_inds.at(ind + 1));
+            continue;
+        }
         groups.at(groupsInd)->appendShape(new Triangle(vertices.at(vertice_inds.at(0)), vertices.at(vertice_inds.at(ind)), vertices.at(vertice_inds.at(ind + 1))));
     }
 }
@@ -104,9 +124,20 @@ Group* ObjParser::objToGroup(){
 
     for(int i = 0; i < groups.size(); i++){
         if(groups.at(i)->getShapes().size() != 0){
+            groups.at(i)->buildBVH();
             g->appendShape(groups.at(i));
         }
     }
+    g->buildBVH();
 
     return g;
+}
+
+Mesh* ObjParser::objToMesh(){
+    if(mesh == nullptr){
+        throw std::invalid_argument("ObjParser:objToMesh - Parser was not constructed with asMesh");
+    }
+
+    mesh->buildBVH();
+    return mesh;
 }
\ No newline at end of file
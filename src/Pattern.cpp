@@ -1,19 +1,20 @@
 #include "Pattern.h"
 #include "Shape.h"
 
-Matrix Pattern::getTransform(){
+const Matrix4& Pattern::getTransform(){
     return transform;
 }
 
-void Pattern::setTransform(Matrix m){
+void Pattern::setTransform(const Matrix4 &m){
     transform = m;
+    inverseTransform = m.inverse();
 }
 
 Colour Pattern::applyPattern(Shape* s, Point p){
     // Transform the pattern based on how the object is transformed
-    Point object_point = Point(s->getTransform().inverse()*p);
+    Point object_point = Point(s->getInverseTransform()*p);
     // Transform the point based on how we want the pattern to be transformed
-    Point pattern_point = Point(transform.inverse()*object_point);
+    Point pattern_point = Point(inverseTransform*object_point);
     return ChildApplyPattern(pattern_point);
 }
 
@@ -0,0 +1,61 @@
+#include "PrimitiveList.h"
+#include <typeinfo>
+
+void PrimitiveList::clear(){
+    entries.clear();
+    spheres.clear();
+    planes.clear();
+    cubes.clear();
+    others.clear();
+    triangles.clear();
+    smoothTriangles.clear();
+}
+
+// The exact type is checked so classes derived from the primitives keep their own overrides
+void PrimitiveList::add(Shape* s, const Matrix4 &toObject){
+    const std::type_info &type = typeid(*s);
+    if(type == typeid(Sphere)){
+        entries.push_back({SPHERE, (int)spheres.size()});
+        spheres.push_back({toObject, s});
+    }else if(type == typeid(Plane)){
+        entries.push_back({PLANE, (int)planes.size()});
+        planes.push_back({toObject, s});
+    }else if(type == typeid(Cube)){
+        entries.push_back({CUBE, (int)cubes.size()});
+        cubes.push_back({toObject, s});
+    }else if(type == typeid(Triangle) || type == typeid(SmoothTriangle)){
+        Triangle* t = static_cast<Triangle*>(s);
+        bool smooth = type == typeid(SmoothTriangle);
+        std::vector<PlacedTriangle> &list = smooth ? smoothTriangles : triangles;
+        entries.push_back({smooth ? SMOOTH_TRIANGLE : TRIANGLE, (int)list.size()});
+        list.push_back({toObject, t->getP1(), t->getE1(), t->getE2(), s});
+    }else{
+        entries.push_back({OTHER, (int)others.size()});
+        others.push_back({toObject, s});
+    }
+}
+
+Shape* PrimitiveList::getShape(int i) const{
+    const Entry &e = entries.at(i);
+    if(e.type == TRIANGLE || e.type == SMOOTH_TRIANGLE){
+        return placedTriangles(e.type)[e.index].shape;
+    }
+    return placed(e.type)[e.index].shape;
+}
+
+PrimitiveList::Type PrimitiveList::getType(int i) const{
+    return entries.at(i).type;
+}
+
+// Every intersection is only needed for transparent hits and CSGs, so every shape uses its own childIntersections
+void PrimitiveList::intersections(int i, Ray r, std::vector<Intersection> &intersects) const{
+    const Entry &e = entries[i];
+    if(e.type == TRIANGLE || e.type == SMOOTH_TRIANGLE){
+        const PlacedTriangle &tri = placedTriangles(e.type)[e.index];
+        tri.shape->childIntersections(r.transform(tri.toObject), intersects);
+        return;
+    }
+
+    const Placed &s = placed(e.type)[e.index];
+    s.shape->childIntersections(r.transform(s.toObject), intersects);
+}
@@ -26,6 +26,6 @@ Tuple Ray::computePosition(float t){
 }
 
 // Transforms the ray by the matrix m
-Ray Ray::transform(Matrix m){
+Ray Ray::transform(const Matrix4 &m){
     return Ray(Point(m*origin), Vector(m*direction));
 }
\ No newline at end of file
@@ -0,0 +1,58 @@
+#include "RayPacket.h"
+
+RayPacket::RayPacket(){
+    for(int i = 0; i < PACKET_SIZE; i++){
+        ox[i] = oy[i] = oz[i] = 0;
+        dx[i] = dy[i] = dz[i] = 0;
+    }
+}
+
+RayPacket::RayPacket(const Ray rays[PACKET_SIZE]){
+    for(int i = 0; i < PACKET_SIZE; i++){
+        Ray r = rays[i];
+        Point o = r.getOrigin();
+        Vector d = r.getDirection();
+        ox[i] = o.x;
+        oy[i] = o.y;
+        oz[i] = o.z;
+        dx[i] = d.x;
+        dy[i] = d.y;
+        dz[i] = d.z;
+    }
+}
+
+Ray RayPacket::getRay(int i) const{
+    return Ray(Point(ox[i], oy[i], oz[i]), Vector(dx[i], dy[i], dz[i]));
+}
+
+// Origins are points(w = 1) so they are translated, directions are vectors(w = 0) so they are not
+RayPacket RayPacket::transform(const Matrix4 &m) const{
+    RayPacket p;
+    for(int i = 0; i < PACKET_SIZE; i++){
+        p.ox[i] = m(0, 0)*ox[i] + m(0, 1)*oy[i] + m(0, 2)*oz[i] + m(0, 3);
+        p.oy[i] = m(1, 0)*ox[i] + m(1, 1)*oy[i] + m(1, 2)*oz[i] + m(1, 3);
+        p.oz[i] = m(2, 0)*ox[i] + m(2, 1)*oy[i] + m(2, 2)*oz[i] + m(2, 3);
+        p.dx[i] = m(0, 0)*dx[i] + m(0, 1)*dy[i] + m(0, 2)*dz[i];
+        p.dy[i] = m(1, 0)*dx[i] + m(1, 1)*dy[i] + m(1, 2)*dz[i];
+        p.dz[i] = m(2, 0)*dx[i] + m(2, 1)*dy[i] + m(2, 2)*dz[i];
+    }
+    return p;
+}
+
+bool RayPacket::isCoherent(int mask) const{
+    const float* directions[3] = {dx, dy, dz};
+    for(int axis = 0; axis < 3; axis++){
+        int signs = 0;
+        int count = 0;
+        for(int i = 0; i < PACKET_SIZE; i++){
+            if(mask & (1 << i)){
+                signs += std::signbit(directions[axis][i]) ? 1 : 0;
+                count++;
+            }
+        }
+        if(signs != 0 && signs != count){
+            return false;
+        }
+    }
+    return true;
+}
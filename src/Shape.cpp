@@ -1,21 +1,104 @@
 #include "Shape.h"
 #include "Group.h"
 
+// Scratch buffer for the fallback occlusion and closest hit checks, one per render thread. Calls can be nested
+// (eg. a CSG inside a CSG) so each call only uses the part of the buffer after where it started and shrinks it back after
+static std::vector<Intersection>& scratchBuffer(){
+    thread_local std::vector<Intersection> buffer;
+    return buffer;
+}
+
+// Finds the lowest of the times that is between tmin and tmax(including tmin, excluding tmax)
+static bool closestTime(const float* times, int count, float tmin, float tmax, float &closest){
+    bool found = false;
+    closest = tmax;
+    for(int i = 0; i < count; i++){
+        if(times[i] >= tmin && times[i] < closest){
+            closest = times[i];
+            found = true;
+        }
+    }
+
+    return found;
+}
+
+// Stores a hit at times[i] for every lane i in mask, used by the packet closest hit functions
+static int storePacketHits(Shape* s, int mask, const float times[PACKET_SIZE], float tmax[PACKET_SIZE], Intersection hits[PACKET_SIZE]){
+    for(int i = 0; i < PACKET_SIZE; i++){
+        if(mask & (1 << i)){
+            hits[i] = Intersection(times[i], s);
+            tmax[i] = times[i];
+        }
+    }
+    return mask;
+}
+
+#ifndef TUPLE_USE_SSE
+// hitTimePacket without SSE, one lane at a time
+template<typename Primitive>
+static int hitTimePacketScalar(const RayPacket &p, int mask, float tmin, const float tmax[PACKET_SIZE], float t[PACKET_SIZE]){
+    int hit = 0;
+    for(int i = 0; i < PACKET_SIZE; i++){
+        if((mask & (1 << i)) && Primitive::hitTime(p.getRay(i), tmin, tmax[i], t[i])){
+            hit |= 1 << i;
+        }
+    }
+    return hit;
+}
+#endif
+
+#ifdef TUPLE_USE_SSE
+// Takes the lanes of a where mask is set and the lanes of b everywhere else
+static inline __m128 selectLanes(__m128 mask, __m128 a, __m128 b){
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+// Lanes where t is between tmin and tmax(including tmin, excluding tmax), NaN times are never in range
+static inline __m128 inRange(__m128 t, float tmin, const float tmax[PACKET_SIZE]){
+    return _mm_and_ps(_mm_cmpge_ps(t, _mm_set1_ps(tmin)), _mm_cmplt_ps(t, _mm_loadu_ps(tmax)));
+}
+
+static inline __m128 absLanes(__m128 a){
+    return _mm_andnot_ps(_mm_set1_ps(-0.0f), a);
+}
+#endif
+
 // Getter and setter for transform and material
-Matrix Shape::getTransform(){
+const Matrix4& Shape::getTransform(){
     return transform;
 }
 
-void Shape::setTransform(Matrix m){
+const Matrix4& Shape::getInverseTransform(){
+    return inverseTransform;
+}
+
+const Matrix4& Shape::getInverseTranspose(){
+    return inverseTranspose;
+}
+
+// Also caches the inverse and inverse transpose of the transform
+void Shape::setTransform(const Matrix4 &m){
     transform = m;
+    inverseTransform = m.inverse();
+    inverseTranspose = inverseTransform.transpose();
+    updateParentBounds();
 }
 
-Material Shape::getMaterial(){
+const Material& Shape::getMaterial(){
     return material;
 }
 
-void Shape::setMaterial(Material m){
+void Shape::setMaterial(const Material &m){
     material = m;
+    changed();
+}
+
+int Shape::solidOf(int index){
+    return -1;
+}
+
+const Material& Shape::getSolidMaterial(int solid){
+    return getMaterial();
 }
 
 Shape* Shape::getParent(){
@@ -24,29 +107,120 @@ Shape* Shape::getParent(){
 
 void Shape::setParent(Shape* p){
     parent = p;
+    changed();
 }
 
 // Returns a vector of intersections where the ray intersects the surface of the shape
 // findIntersections does some preprocessing that would be done for any shape
 std::vector<Intersection> Shape::findIntersections(Ray r){
+    std::vector<Intersection> intersects;
+    findIntersections(r, intersects);
+    return intersects;
+}
+
+void Shape::findIntersections(Ray r, std::vector<Intersection> &intersects){
     // Any transform that we want to apply to the shape has to be applied inversely to the ray
     // if we want the same result as transforming the shape
-    Ray ray2 = r.transform(transform.inverse());
+    Ray ray2 = r.transform(inverseTransform);
+
+    // If the ray misses the box containing all of the children, none of them need to be checked
+    if(cullWithBounds && !bounds().intersects(ray2)){
+        return;
+    }
 
-    return childIntersections(ray2);
+    childIntersections(ray2, intersects);
 }
 
 // childIntersections executes custom code depending on what child class is being executed
 std::vector<Intersection> Shape::childIntersections(Ray r){
-    return std::vector<Intersection>{};
+    std::vector<Intersection> intersects;
+    childIntersections(r, intersects);
+    return intersects;
+}
+
+void Shape::childIntersections(Ray r, std::vector<Intersection> &intersects){
+}
+
+// Same preprocessing as findIntersections
+bool Shape::isOccluded(Ray r, float tmax){
+    Ray ray2 = r.transform(inverseTransform);
+
+    if(cullWithBounds && !bounds().intersects(ray2)){
+        return false;
+    }
+
+    return childOccluded(ray2, tmax);
+}
+
+// Same preprocessing as findIntersections
+bool Shape::findClosestHit(Ray r, float tmin, float tmax, Intersection &hit){
+    Ray ray2 = r.transform(inverseTransform);
+
+    if(cullWithBounds && !bounds().intersects(ray2)){
+        return false;
+    }
+
+    return childClosestHit(ray2, tmin, tmax, hit);
+}
+
+// Shapes without a faster check look through every intersection. CSGs use this since whether an intersection
+// is part of the CSG depends on every other intersection along the ray
+bool Shape::childClosestHit(Ray r, float tmin, float tmax, Intersection &hit){
+    std::vector<Intersection> &intersects = scratchBuffer();
+    int start = intersects.size();
+    childIntersections(r, intersects);
+
+    bool found = false;
+    for(int i = start; i < intersects.size(); i++){
+        float t = intersects[i].getTime();
+        if(t >= tmin && t < tmax){
+            hit = intersects[i];
+            tmax = t;
+            found = true;
+        }
+    }
+
+    intersects.erase(intersects.begin() + start, intersects.end());
+    return found;
+}
+
+int Shape::childClosestHitPacket(const RayPacket &p, int mask, float tmin, float tmax[PACKET_SIZE], Intersection hits[PACKET_SIZE]){
+    int found = 0;
+    for(int i = 0; i < PACKET_SIZE; i++){
+        if((mask & (1 << i)) && childClosestHit(p.getRay(i), tmin, tmax[i], hits[i])){
+            tmax[i] = hits[i].getTime();
+            found |= 1 << i;
+        }
+    }
+    return found;
+}
+
+// Shapes without a faster check look for any shadow casting intersection in range. CSGs use this since whether an
+// intersection is part of the CSG depends on every other intersection along the ray
+bool Shape::childOccluded(Ray r, float tmax){
+    std::vector<Intersection> &intersects = scratchBuffer();
+    int start = intersects.size();
+    childIntersections(r, intersects);
+
+    bool occluded = false;
+    for(int i = start; i < intersects.size(); i++){
+        float t = intersects[i].getTime();
+        if(t >= 0 && t < tmax && intersects[i].getShape()->getMaterial().castsShadow){
+            occluded = true;
+            break;
+        }
+    }
+
+    intersects.erase(intersects.begin() + start, intersects.end());
+    return occluded;
 }
 
 // Computes the normal vector of a point on the surface of the shape
 // findIntersections does some preprocessing that would be done for any shape
 Vector Shape::computeNormal(Point p, Intersection hit){
-    Point objectPoint = worldToObject(p);
+    Point objectPoint = worldToObject(p, hit.getInstance());
     Vector objectNormal = childNormal(objectPoint, hit);
-    return normalToWorld(objectNormal);
+    return normalToWorld(objectNormal, hit.getInstance());
 }
 
 // childIntersections executes custom code depending on what child class is being executed
@@ -78,22 +252,127 @@ bool Shape::includes(Shape* s){
     return this->isEqual(s);
 }
 
+int Shape::getSubtreeId(){
+    return subtreeId;
+}
+
+void Shape::assignSubtreeIds(int &next){
+    subtreeId = next++;
+}
+
+void Shape::updateSubtreeIds(){
+    if(subtreeId == -1){
+        return;
+    }
+
+    // Every shape in the outermost CSG has an id, so the outermost one is the last ancestor with an id
+    Shape* top = this;
+    while(top->parent != nullptr && top->parent->subtreeId != -1){
+        top = top->parent;
+    }
+
+    int next = top->subtreeId;
+    top->assignSubtreeIds(next);
+}
+
+// Shapes without a custom bounding box are treated as infinite so they are never skipped
+BoundingBox Shape::bounds(){
+    return BoundingBox(Point(-INFINITY, -INFINITY, -INFINITY), Point(INFINITY, INFINITY, INFINITY));
+}
+
+BoundingBox Shape::parentSpaceBounds(){
+    return bounds().transform(transform);
+}
+
+void Shape::childBoundsChanged(){
+}
+
+unsigned int Shape::getVersion(){
+    return version;
+}
+
+void Shape::changed(){
+    for(Shape* s = this; s != nullptr; s = s->parent){
+        s->version++;
+    }
+}
+
+Shape* Shape::getRoot(){
+    Shape* root = this;
+    while(root->parent != nullptr){
+        root = root->parent;
+    }
+    return root;
+}
+
+void Shape::updateParentBounds(){
+    changed();
+    if(parent != nullptr){
+        parent->childBoundsChanged();
+    }
+}
+
+void Shape::bakeWorldTransform(const Matrix4 &parentWorldInverse){
+    worldInverse = inverseTransform*parentWorldInverse;
+    worldInverseTranspose = worldInverse.transpose();
+    committedRoot = getRoot();
+    committedVersion = committedRoot->version;
+}
+
+void Shape::commit(const Matrix4 &parentWorld, const Matrix4 &parentWorldInverse, CommittedLeaves* leaves){
+    bakeWorldTransform(parentWorldInverse);
+    if(leaves != nullptr){
+        leaves->shapes.push_back(this);
+        leaves->boxes.push_back(bounds().transform(parentWorld*transform));
+    }
+}
+
+bool Shape::isCommitted(){
+    Shape* root = getRoot();
+    return root == committedRoot && root->version == committedVersion;
+}
+
+const Matrix4& Shape::getWorldInverse(){
+    return worldInverse;
+}
+
 // Converts a point in the world to a point relative to the shape
 // eg. Converts the point to where it would be if the shape was at the origin
-Point Shape::worldToObject(Point p){
+// The instance takes the place of the parent of the prototype's outermost shape
+Point Shape::worldToObject(Point p, Shape* instance){
+    if(isCommitted()){
+        if(instance != nullptr){
+            p = instance->worldToObject(p);
+        }
+        return worldInverse*p;
+    }
+
     if(parent != nullptr){
-        p = parent->worldToObject(p);
+        p = parent->worldToObject(p, instance);
+    }else if(instance != nullptr){
+        p = instance->worldToObject(p);
     }
 
-    return transform.inverse()*p;
+    return inverseTransform*p;
 }
 
-Vector Shape::normalToWorld(Vector normal){
-    normal = Vector(transform.inverse().transpose()*normal);
+// The baked matrix gives the same direction as normalizing at every level since each level only scales the normal
+Vector Shape::normalToWorld(Vector normal, Shape* instance){
+    if(isCommitted()){
+        normal = Vector(worldInverseTranspose*normal).normalize();
+        if(instance != nullptr){
+            normal = instance->normalToWorld(normal);
+        }
+        return normal;
+    }
+
+    normal = Vector(inverseTranspose*normal);
     normal = normal.normalize();
 
     if(parent != nullptr){
-        normal = parent->normalToWorld(normal);
+        normal = parent->normalToWorld(normal, instance);
+    }else if(instance != nullptr){
+        normal = instance->normalToWorld(normal);
     }
     return normal;
 }
@@ -113,7 +392,7 @@ bool Sphere::childEqual(Shape* s){
 // where time = 2 is when the ray first hits the sphere at (-1, 0 , 0) and
 // exits the sphere at time = 4 at point (1, 0, 0)
 // Search about "Line-sphere intersection" for more info on how the math works
-std::vector<Intersection> Sphere::childIntersections(Ray r){
+void Sphere::childIntersections(Ray r, std::vector<Intersection> &intersects){
     // Vector from spheres center to the ray origin
     Vector sphere_to_ray = Vector(r.getOrigin() - Point());
     float a = dotProduct(r.getDirection(), r.getDirection());
@@ -124,7 +403,7 @@ std::vector<Intersection> Sphere::childIntersections(Ray r){
 
     // If discriminant negative, no intersection
     if(discriminant < 0){
-        return std::vector<Intersection>{};
+        return;
     }
 
     // Otherwise, the result is the two results of the quadratic formula
@@ -133,7 +412,53 @@ std::vector<Intersection> Sphere::childIntersections(Ray r){
     float t1 = (-b - sqrt(discriminant))/(2*a);
     float t2 = (-b + sqrt(discriminant))/(2*a);
 
-    return std::vector<Intersection>{Intersection(t1, this), Intersection(t2, this)};
+    intersects.push_back(Intersection(t1, this));
+    intersects.push_back(Intersection(t2, this));
+}
+
+bool Sphere::childOccluded(Ray r, float tmax){
+    float t;
+    return getMaterial().castsShadow && hitTime(r, 0, tmax, t);
+}
+
+bool Sphere::childClosestHit(Ray r, float tmin, float tmax, Intersection &hit){
+    float t;
+    if(!hitTime(r, tmin, tmax, t)){
+        return false;
+    }
+
+    hit = Intersection(t, this);
+    return true;
+}
+
+// Same math as hitTime for four rays at once
+int Sphere::hitTimePacket(const RayPacket &p, int mask, float tmin, const float tmax[PACKET_SIZE], float t[PACKET_SIZE]){
+#ifdef TUPLE_USE_SSE
+    __m128 ox = _mm_load_ps(p.ox), oy = _mm_load_ps(p.oy), oz = _mm_load_ps(p.oz);
+    __m128 dx = _mm_load_ps(p.dx), dy = _mm_load_ps(p.dy), dz = _mm_load_ps(p.dz);
+    __m128 a = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+    __m128 halfB = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, ox), _mm_mul_ps(dy, oy)), _mm_mul_ps(dz, oz));
+    __m128 b = _mm_add_ps(halfB, halfB);
+    __m128 c = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(ox, ox), _mm_mul_ps(oy, oy)), _mm_mul_ps(oz, oz)), _mm_set1_ps(1));
+    __m128 discriminant = _mm_sub_ps(_mm_mul_ps(b, b), _mm_mul_ps(_mm_set1_ps(4), _mm_mul_ps(a, c)));
+
+    // The square root of a negative discriminant is NaN, which the range check below rejects
+    __m128 root = _mm_sqrt_ps(discriminant);
+    __m128 twoA = _mm_add_ps(a, a);
+    __m128 t1 = _mm_div_ps(_mm_sub_ps(_mm_setzero_ps(), _mm_add_ps(b, root)), twoA);
+    __m128 t2 = _mm_div_ps(_mm_sub_ps(root, b), twoA);
+    __m128 times = selectLanes(_mm_cmpge_ps(t1, _mm_set1_ps(tmin)), t1, t2);
+
+    _mm_storeu_ps(t, times);
+    return _mm_movemask_ps(_mm_and_ps(_mm_cmpge_ps(discriminant, _mm_setzero_ps()), inRange(times, tmin, tmax))) & mask;
+#else
+    return hitTimePacketScalar<Sphere>(p, mask, tmin, tmax, t);
+#endif
+}
+
+int Sphere::childClosestHitPacket(const RayPacket &p, int mask, float tmin, float tmax[PACKET_SIZE], Intersection hits[PACKET_SIZE]){
+    float t[PACKET_SIZE];
+    return storePacketHits(this, hitTimePacket(p, mask, tmin, tmax, t), t, tmax, hits);
 }
 
 // Computes the normal vector at the point p on the surface of the sphere
@@ -145,6 +470,10 @@ Vector Sphere::childNormal(Point p, Intersection hit){
     return sphere_normal;
 }
 
+BoundingBox Sphere::bounds(){
+    return BoundingBox(Point(-1, -1, -1), Point(1, 1, 1));
+}
+
 // Generates a sphere with a glass material
 Sphere* glassSphere(){
     Material m;
@@ -167,18 +496,50 @@ bool Plane::childEqual(Shape* s){
 }
 
 // Computes the point of intersection of a ray on the plane 
-std::vector<Intersection> Plane::childIntersections(Ray r){
+void Plane::childIntersections(Ray r, std::vector<Intersection> &intersects){
     // Since the default plane is an xz plane before transformation, any vector with a y value of ~0(floating-point error) will be parallel to the plane
     // A coplanar ray is a ray that is parallel to the plane and originates on the plane, this ray intersects the plane at every single point
     // This will return zero intersections because if this is the input ray, the camera is viewing the plane edge-on. Since the plane is infinitely thin
     // nothing should be rendered so no need to return any intersections
     if(std::abs(r.getDirection().y) < EPSILON){
-        return std::vector<Intersection>{};
+        return;
     }
 
     // computes the time the ray takes to travel -y units in the y direction(time = distance/speed) so that the ray is on the plane(y value is 0)
     float t = -r.getOrigin().y/r.getDirection().y;
-    return std::vector<Intersection>{Intersection(t, this)};
+    intersects.push_back(Intersection(t, this));
+}
+
+bool Plane::childOccluded(Ray r, float tmax){
+    float t;
+    return getMaterial().castsShadow && hitTime(r, 0, tmax, t);
+}
+
+bool Plane::childClosestHit(Ray r, float tmin, float tmax, Intersection &hit){
+    float t;
+    if(!hitTime(r, tmin, tmax, t)){
+        return false;
+    }
+
+    hit = Intersection(t, this);
+    return true;
+}
+
+int Plane::hitTimePacket(const RayPacket &p, int mask, float tmin, const float tmax[PACKET_SIZE], float t[PACKET_SIZE]){
+#ifdef TUPLE_USE_SSE
+    __m128 dy = _mm_load_ps(p.dy);
+    __m128 parallel = _mm_cmplt_ps(absLanes(dy), _mm_set1_ps(EPSILON));
+    __m128 times = _mm_div_ps(_mm_sub_ps(_mm_setzero_ps(), _mm_load_ps(p.oy)), dy);
+    _mm_storeu_ps(t, times);
+    return _mm_movemask_ps(_mm_andnot_ps(parallel, inRange(times, tmin, tmax))) & mask;
+#else
+    return hitTimePacketScalar<Plane>(p, mask, tmin, tmax, t);
+#endif
+}
+
+int Plane::childClosestHitPacket(const RayPacket &p, int mask, float tmin, float tmax[PACKET_SIZE], Intersection hits[PACKET_SIZE]){
+    float t[PACKET_SIZE];
+    return storePacketHits(this, hitTimePacket(p, mask, tmin, tmax, t), t, tmax, hits);
 }
 
 // The default plane is an xz plane, so the normal vector will be Vector(0, 1, 0)
@@ -186,6 +547,10 @@ Vector Plane::childNormal(Point p, Intersection hit){
     return Vector(0, 1, 0);
 }
 
+BoundingBox Plane::bounds(){
+    return BoundingBox(Point(-INFINITY, 0, -INFINITY), Point(INFINITY, 0, INFINITY));
+}
+
 // Checks equality of cubes
 bool Cube::childEqual(Shape* s){
     Cube* c = dynamic_cast<Cube*>(s);
@@ -197,22 +562,77 @@ bool Cube::childEqual(Shape* s){
 }
 
 // Computes all intersections of a ray and the cube
-std::vector<Intersection> Cube::childIntersections(Ray r){
+void Cube::childIntersections(Ray r, std::vector<Intersection> &intersects){
     // Computes the times when the ray intersected with the corresponding plane of each face of the cube
-    std::vector<float> xt_minmax = check_axis(r.getOrigin().x, r.getDirection().x);
-    std::vector<float> yt_minmax = check_axis(r.getOrigin().y, r.getDirection().y);
-    std::vector<float> zt_minmax = check_axis(r.getOrigin().z, r.getDirection().z);
+    float xtmin, xtmax, ytmin, ytmax, ztmin, ztmax;
+    check_axis(r.getOrigin().x, r.getDirection().x, xtmin, xtmax);
+    check_axis(r.getOrigin().y, r.getDirection().y, ytmin, ytmax);
+    check_axis(r.getOrigin().z, r.getDirection().z, ztmin, ztmax);
 
     // The largest min time and smallest max time will always be the times the ray intersects with the cube
-    float tmin = std::max({xt_minmax.at(0), yt_minmax.at(0), zt_minmax.at(0)});
-    float tmax = std::min({xt_minmax.at(1), yt_minmax.at(1), zt_minmax.at(1)});
+    float tmin = std::max({xtmin, ytmin, ztmin});
+    float tmax = std::min({xtmax, ytmax, ztmax});
 
     // Ray does not intersect with cube
     if(tmin > tmax){
-        return std::vector<Intersection>();
+        return;
+    }
+
+    intersects.push_back(Intersection(tmin, this));
+    intersects.push_back(Intersection(tmax, this));
+}
+
+bool Cube::childOccluded(Ray r, float tmax){
+    float t;
+    return getMaterial().castsShadow && hitTime(r, 0, tmax, t);
+}
+
+bool Cube::childClosestHit(Ray r, float tmin, float tmax, Intersection &hit){
+    float t;
+    if(!hitTime(r, tmin, tmax, t)){
+        return false;
+    }
+
+    hit = Intersection(t, this);
+    return true;
+}
+
+// check_axis on every axis for four rays at once, the cube's times are the largest entry and smallest exit
+int Cube::hitTimePacket(const RayPacket &p, int mask, float tmin, const float tmax[PACKET_SIZE], float t[PACKET_SIZE]){
+#ifdef TUPLE_USE_SSE
+    const float* origins[3] = {p.ox, p.oy, p.oz};
+    const float* directions[3] = {p.dx, p.dy, p.dz};
+    __m128 t0 = _mm_set1_ps(-INFINITY);
+    __m128 t1 = _mm_set1_ps(INFINITY);
+    for(int axis = 0; axis < 3; axis++){
+        __m128 origin = _mm_load_ps(origins[axis]);
+        __m128 direction = _mm_load_ps(directions[axis]);
+        __m128 minNumerator = _mm_sub_ps(_mm_set1_ps(-1), origin);
+        __m128 maxNumerator = _mm_sub_ps(_mm_set1_ps(1), origin);
+        // Directions near 0 multiply by infinity instead of dividing like check_axis
+        __m128 parallel = _mm_cmplt_ps(absLanes(direction), _mm_set1_ps(EPSILON));
+        __m128 infinity = _mm_set1_ps(INFINITY);
+        __m128 axisMin = selectLanes(parallel, _mm_mul_ps(minNumerator, infinity), _mm_div_ps(minNumerator, direction));
+        __m128 axisMax = selectLanes(parallel, _mm_mul_ps(maxNumerator, infinity), _mm_div_ps(maxNumerator, direction));
+        // Swapped with a comparison like check_axis, and _mm_max_ps and _mm_min_ps return their second operand if either is
+        // NaN, so a NaN time(0*infinity when the ray starts on a face it is parallel to) is skipped like std::max and std::min do
+        __m128 swap = _mm_cmpgt_ps(axisMin, axisMax);
+        t0 = _mm_max_ps(selectLanes(swap, axisMax, axisMin), t0);
+        t1 = _mm_min_ps(selectLanes(swap, axisMin, axisMax), t1);
     }
 
-    return std::vector<Intersection>({Intersection(tmin, this), Intersection(tmax, this)});
+    // The entry time is the closest if it is in range, otherwise the exit time(the ray starts inside the cube)
+    __m128 times = selectLanes(_mm_cmpge_ps(t0, _mm_set1_ps(tmin)), t0, t1);
+    _mm_storeu_ps(t, times);
+    return _mm_movemask_ps(_mm_and_ps(_mm_cmple_ps(t0, t1), inRange(times, tmin, tmax))) & mask;
+#else
+    return hitTimePacketScalar<Cube>(p, mask, tmin, tmax, t);
+#endif
+}
+
+int Cube::childClosestHitPacket(const RayPacket &p, int mask, float tmin, float tmax[PACKET_SIZE], Intersection hits[PACKET_SIZE]){
+    float t[PACKET_SIZE];
+    return storePacketHits(this, hitTimePacket(p, mask, tmin, tmax, t), t, tmax, hits);
 }
 
 // Computes the normal vector of a point on the cube. For a cube at the origin with a side length of 2,
@@ -231,29 +651,8 @@ Vector Cube::childNormal(Point p, Intersection hit){
     return Vector(0, 0, p.z);
 }
 
-// Computes the time that the ray hits the plane corresponding to a negative and positive face of a cube using time = distance/speed 
-// where speed is the direction parameter passed in and distance will be calculated using the origin parameter
-// eg. Calculates when a ray hits a plane at x=-1 and x=1 to determine if the intersection was on the cube's surface
-std::vector<float> check_axis(float origin, float direction){
-    // Distance from origin to the plane x = -1 or x = 1 if origin corresponds to the cube's origin.x
-    float tmin_numerator = -1 - origin;
-    float tmax_numerator = 1 - origin;
-
-    float tmin, tmax;
-
-    if(std::abs(direction) >= EPSILON){
-        tmin = tmin_numerator/direction;
-        tmax = tmax_numerator/direction;
-    }else{ // if direction is near 0, handles division by 0
-        tmin = tmin_numerator*INFINITY;
-        tmax = tmax_numerator*INFINITY;
-    }
-
-    if(tmin > tmax){
-        std::swap(tmin, tmax);
-    }
-
-    return std::vector<float>({tmin, tmax});
+BoundingBox Cube::bounds(){
+    return BoundingBox(Point(-1, -1, -1), Point(1, 1, 1));
 }
 
 // Cylinder constructor
@@ -281,6 +680,7 @@ void Cylinder::setMaxH(float h){
         throw std::invalid_argument("Cylinder:setMaxH - Invalid input: " + std::to_string(h));
     }else{
         maxH = h;
+        updateParentBounds();
     }
 }
 
@@ -289,6 +689,7 @@ void Cylinder::setMinH(float h){
         throw std::invalid_argument("Cylinder:setMinH - Invalid input: " + std::to_string(h));
     }else{
         minH = h;
+        updateParentBounds();
     }
 }
 
@@ -306,52 +707,72 @@ bool Cylinder::childEqual(Shape* s){
     return floatIsEqual(maxH, c->getMaxH()) && floatIsEqual(minH, c->getMinH()) && closed == c->getClosed();
 }
 
-// Computes all intersections of a ray and the cylinder
-std::vector<Intersection> Cylinder::childIntersections(Ray r){
-    float a = pow(r.getDirection().x, 2) + pow(r.getDirection().z, 2);
+// Sorts the first count(at most 4) wall and cap times. The unused times are set to infinity so a fixed sorting network
+// of five compare and swaps sorts all four, which leaves them at the end
+static void sortTimes(float times[4], int count){
+    for(int i = count; i < 4; i++){
+        times[i] = INFINITY;
+    }
 
-    std::vector<Intersection> intersects;
-    // If a is approximately 0, ray does not intersect with cylinder walls
-    if(std::abs(a) < EPSILON){
-        intersectCaps(r, intersects);
-        return intersects;
+    const int pairs[5][2] = {{0, 1}, {2, 3}, {0, 2}, {1, 3}, {1, 2}};
+    for(int i = 0; i < 5; i++){
+        float a = times[pairs[i][0]];
+        float b = times[pairs[i][1]];
+        times[pairs[i][0]] = std::min(a, b);
+        times[pairs[i][1]] = std::max(a, b);
     }
+}
 
-    float b = 2*r.getOrigin().x*r.getDirection().x + 2*r.getOrigin().z*r.getDirection().z;
-    float c = pow(r.getOrigin().x, 2) + pow(r.getOrigin().z, 2) - 1;
+// Computes all intersections of a ray and the cylinder, in order of time
+void Cylinder::childIntersections(Ray r, std::vector<Intersection> &intersects){
+    float times[4];
+    int count = wallIntersections(r, times);
+    // Add intersections with cylinder caps
+    count += capIntersections(r, times + count);
 
-    float t0;
-    float t1;
-    float discriminant = pow(b, 2) - 4*a*c;
-    if(floatIsEqual(discriminant, 0)){
-        t0 = -b/(2*a);
-        t1 = -b/(2*a);
-    }else if(discriminant < 0){
-        // Ray does not intersect if discriminant is negative
-        return std::vector<Intersection>();
-    }else{
-        t0 = (-b - sqrt(discriminant))/(2*a);
-        t1 = (-b + sqrt(discriminant))/(2*a);
+    // The wall and cap times are each in order but not with each other
+    sortTimes(times, count);
+    for(int i = 0; i < count; i++){
+        intersects.push_back(Intersection(times[i], this));
     }
+}
 
-    if(t0 > t1){
-        std::swap(t0, t1);
+// The caps are checked first since they need no square root
+bool Cylinder::childOccluded(Ray r, float tmax){
+    if(!getMaterial().castsShadow){
+        return false;
     }
 
-    // Computes y values of intersections and checks if they are within cylinder top and bottom bounds
-    float y0 = r.getOrigin().y + t0*r.getDirection().y;
-    if(minH < y0 && y0 < maxH){
-        intersects.push_back(Intersection(t0, this));
+    float times[2];
+    int count = capIntersections(r, times);
+    for(int i = 0; i < count; i++){
+        if(times[i] >= 0 && times[i] < tmax){
+            return true;
+        }
     }
-    float y1 = r.getOrigin().y + t1*r.getDirection().y;
-    if(minH < y1 && y1 < maxH){
-        intersects.push_back(Intersection(t1, this));
+
+    count = wallIntersections(r, times);
+    for(int i = 0; i < count; i++){
+        if(times[i] >= 0 && times[i] < tmax){
+            return true;
+        }
     }
 
-    // Add intersections with cylinder caps
-    intersectCaps(r, intersects);
+    return false;
+}
 
-    return intersects;
+bool Cylinder::childClosestHit(Ray r, float tmin, float tmax, Intersection &hit){
+    float times[4];
+    int count = wallIntersections(r, times);
+    count += capIntersections(r, times + count);
+
+    float t;
+    if(!closestTime(times, count, tmin, tmax, t)){
+        return false;
+    }
+
+    hit = Intersection(t, this);
+    return true;
 }
 
 // Returns normal vector of a point on the cylinder walls or caps(if closed cylinder)
@@ -370,6 +791,11 @@ Vector Cylinder::childNormal(Point p, Intersection hit){
     return Vector(p.x, 0, p.z);
 }
 
+// Cylinder has a radius of 1 and is cut off at minH and maxH
+BoundingBox Cylinder::bounds(){
+    return BoundingBox(Point(-1, minH, -1), Point(1, maxH, 1));
+}
+
 // Checks if ray r at time t is inside the radius of the cylinder
 bool Cylinder::insideCapRadius(Ray r, float t){
     float x = r.getOrigin().x + t*r.getDirection().x;
@@ -378,25 +804,72 @@ bool Cylinder::insideCapRadius(Ray r, float t){
     return (pow(x, 2) + pow(z, 2)) <= 1;
 }
 
-// Computes ray intersection with cylinder caps
-void Cylinder::intersectCaps(Ray r, std::vector<Intersection> &intersects){
+// Computes the times the ray hits the cylinder walls between minH and maxH, returns how many there are(at most 2)
+int Cylinder::wallIntersections(Ray r, float times[2]){
+    float a = pow(r.getDirection().x, 2) + pow(r.getDirection().z, 2);
+
+    // If a is approximately 0, ray does not intersect with cylinder walls
+    if(std::abs(a) < EPSILON){
+        return 0;
+    }
+
+    float b = 2*r.getOrigin().x*r.getDirection().x + 2*r.getOrigin().z*r.getDirection().z;
+    float c = pow(r.getOrigin().x, 2) + pow(r.getOrigin().z, 2) - 1;
+
+    float t0;
+    float t1;
+    float discriminant = pow(b, 2) - 4*a*c;
+    if(floatIsEqual(discriminant, 0)){
+        t0 = -b/(2*a);
+        t1 = -b/(2*a);
+    }else if(discriminant < 0){
+        // Ray does not intersect if discriminant is negative
+        return 0;
+    }else{
+        t0 = (-b - sqrt(discriminant))/(2*a);
+        t1 = (-b + sqrt(discriminant))/(2*a);
+    }
+
+    if(t0 > t1){
+        std::swap(t0, t1);
+    }
+
+    // Computes y values of intersections and checks if they are within cylinder top and bottom bounds
+    int count = 0;
+    float y0 = r.getOrigin().y + t0*r.getDirection().y;
+    if(minH < y0 && y0 < maxH){
+        times[count++] = t0;
+    }
+    float y1 = r.getOrigin().y + t1*r.getDirection().y;
+    if(minH < y1 && y1 < maxH){
+        times[count++] = t1;
+    }
+
+    return count;
+}
+
+// Computes the times the ray hits the cylinder caps, returns how many there are(at most 2)
+int Cylinder::capIntersections(Ray r, float times[2]){
     // If cylinder is not closed or ray is travelling parallel to y, intersection never happens
     // Ignores case when ray is on cylinder cap as there will be infinite intersections
     if(!closed || floatIsEqual(r.getDirection().y, 0)){
-        return;
+        return 0;
     }
 
+    int count = 0;
     // Calculates time when ray is level with the bottom cap of the cylinder
     float t = (minH - r.getOrigin().y)/r.getDirection().y;
     if(insideCapRadius(r, t)){
-        intersects.push_back(Intersection(t, this));
+        times[count++] = t;
     }
 
     // Calculates time when ray is level with the top cap of the cylinder
     t = (maxH - r.getOrigin().y)/r.getDirection().y;
     if(insideCapRadius(r, t)){
-        intersects.push_back(Intersection(t, this));
+        times[count++] = t;
     }
+
+    return count;
 }
 
 // Cone constructor
@@ -424,6 +897,7 @@ void Cone::setMaxH(float h){
         throw std::invalid_argument("Cone:setMaxH - Invalid input: " + std::to_string(h));
     }else{
         maxH = h;
+        updateParentBounds();
     }
 }
 
@@ -432,6 +906,7 @@ void Cone::setMinH(float h){
         throw std::invalid_argument("Cone:setMinH - Invalid input: " + std::to_string(h));
     }else{
         minH = h;
+        updateParentBounds();
     }
 }
 
@@ -449,55 +924,56 @@ bool Cone::childEqual(Shape* s){
     return floatIsEqual(maxH, c->getMaxH()) && floatIsEqual(minH, c->getMinH()) && closed == c->getClosed();
 }
 
-// Computes all intersections of a ray and the cone
-std::vector<Intersection> Cone::childIntersections(Ray r){
-    float a = pow(r.getDirection().x, 2) - pow(r.getDirection().y, 2) + pow(r.getDirection().z, 2);
-    float b = 2*r.getOrigin().x*r.getDirection().x - 2*r.getOrigin().y*r.getDirection().y + 2*r.getOrigin().z*r.getDirection().z;
-    float c = pow(r.getOrigin().x, 2) - pow(r.getOrigin().y, 2) + pow(r.getOrigin().z, 2);
+// Computes all intersections of a ray and the cone, in order of time
+void Cone::childIntersections(Ray r, std::vector<Intersection> &intersects){
+    float times[4];
+    int count = wallIntersections(r, times);
+    // Add intersections with cone caps
+    count += capIntersections(r, times + count);
 
-    std::vector<Intersection> intersects;
-    // If a is approximately 0, ray does not intersect with cone walls
-    if(std::abs(a) < EPSILON){
-        intersectCaps(r, intersects);
-        if(std::abs(b) < EPSILON){
-            return intersects;
-        }
-        intersects.push_back(Intersection(-c/(2*b), this));
-        return intersects;
+    // The wall and cap times are each in order but not with each other
+    sortTimes(times, count);
+    for(int i = 0; i < count; i++){
+        intersects.push_back(Intersection(times[i], this));
     }
+}
 
-    float t0;
-    float t1;
-    float discriminant = pow(b, 2) - 4*a*c;
-    if(floatIsEqual(discriminant, 0)){
-        t0 = -b/(2*a);
-        t1 = -b/(2*a);
-    }else if(discriminant < 0){
-        // Ray does not intersect if discriminant is negative
-        return std::vector<Intersection>();
-    }else{
-        t0 = (-b - sqrt(discriminant))/(2*a);
-        t1 = (-b + sqrt(discriminant))/(2*a);
+// The caps are checked first since they need no square root
+bool Cone::childOccluded(Ray r, float tmax){
+    if(!getMaterial().castsShadow){
+        return false;
     }
 
-    if(t0 > t1){
-        std::swap(t0, t1);
+    float times[2];
+    int count = capIntersections(r, times);
+    for(int i = 0; i < count; i++){
+        if(times[i] >= 0 && times[i] < tmax){
+            return true;
+        }
     }
 
-    // Computes y values of intersections and checks if they are within cylinder top and bottom bounds
-    float y0 = r.getOrigin().y + t0*r.getDirection().y;
-    if(minH < y0 && y0 < maxH){
-        intersects.push_back(Intersection(t0, this));
-    }
-    float y1 = r.getOrigin().y + t1*r.getDirection().y;
-    if(minH < y1 && y1 < maxH){
-        intersects.push_back(Intersection(t1, this));
+    count = wallIntersections(r, times);
+    for(int i = 0; i < count; i++){
+        if(times[i] >= 0 && times[i] < tmax){
+            return true;
+        }
     }
 
-    // Add intersections with cylinder caps
-    intersectCaps(r, intersects);
+    return false;
+}
 
-    return intersects;
+bool Cone::childClosestHit(Ray r, float tmin, float tmax, Intersection &hit){
+    float times[4];
+    int count = wallIntersections(r, times);
+    count += capIntersections(r, times + count);
+
+    float t;
+    if(!closestTime(times, count, tmin, tmax, t)){
+        return false;
+    }
+
+    hit = Intersection(t, this);
+    return true;
 }
 
 // Returns normal vector of a point on the cone walls or caps(if closed cone)
@@ -520,6 +996,12 @@ Vector Cone::childNormal(Point p, Intersection hit){
     return Vector(p.x, y, p.z);
 }
 
+// The radius of the cone at height y is |y|, so the widest part of the cone is at minH or maxH
+BoundingBox Cone::bounds(){
+    float radius = std::max(std::abs(minH), std::abs(maxH));
+    return BoundingBox(Point(-radius, minH, -radius), Point(radius, maxH, radius));
+}
+
 // Checks if ray r at time t is inside the radius of the cone
 bool Cone::insideCapRadius(Ray r, float t, float radius){
     float x = r.getOrigin().x + t*r.getDirection().x;
@@ -528,25 +1010,75 @@ bool Cone::insideCapRadius(Ray r, float t, float radius){
     return (pow(x, 2) + pow(z, 2)) <= pow(radius, 2);
 }
 
-// Computes ray intersection with cone caps
-void Cone::intersectCaps(Ray r, std::vector<Intersection> &intersects){
+// Computes the times the ray hits the cone walls between minH and maxH, returns how many there are(at most 2)
+int Cone::wallIntersections(Ray r, float times[2]){
+    float a = pow(r.getDirection().x, 2) - pow(r.getDirection().y, 2) + pow(r.getDirection().z, 2);
+    float b = 2*r.getOrigin().x*r.getDirection().x - 2*r.getOrigin().y*r.getDirection().y + 2*r.getOrigin().z*r.getDirection().z;
+    float c = pow(r.getOrigin().x, 2) - pow(r.getOrigin().y, 2) + pow(r.getOrigin().z, 2);
+
+    // If a is approximately 0, the ray is parallel to one of the cone's halves and can only hit the other half once
+    if(std::abs(a) < EPSILON){
+        if(std::abs(b) < EPSILON){
+            return 0;
+        }
+        times[0] = -c/(2*b);
+        return 1;
+    }
+
+    float t0;
+    float t1;
+    float discriminant = pow(b, 2) - 4*a*c;
+    if(floatIsEqual(discriminant, 0)){
+        t0 = -b/(2*a);
+        t1 = -b/(2*a);
+    }else if(discriminant < 0){
+        // Ray does not intersect if discriminant is negative
+        return 0;
+    }else{
+        t0 = (-b - sqrt(discriminant))/(2*a);
+        t1 = (-b + sqrt(discriminant))/(2*a);
+    }
+
+    if(t0 > t1){
+        std::swap(t0, t1);
+    }
+
+    // Computes y values of intersections and checks if they are within cone top and bottom bounds
+    int count = 0;
+    float y0 = r.getOrigin().y + t0*r.getDirection().y;
+    if(minH < y0 && y0 < maxH){
+        times[count++] = t0;
+    }
+    float y1 = r.getOrigin().y + t1*r.getDirection().y;
+    if(minH < y1 && y1 < maxH){
+        times[count++] = t1;
+    }
+
+    return count;
+}
+
+// Computes the times the ray hits the cone caps, returns how many there are(at most 2)
+int Cone::capIntersections(Ray r, float times[2]){
     // If cone is not closed or ray is travelling parallel to y, intersection never happens
     // Ignores case when ray is on cone cap as there will be infinite intersections
     if(!closed || floatIsEqual(r.getDirection().y, 0)){
-        return;
+        return 0;
     }
 
+    int count = 0;
     // Calculates time when ray is level with the bottom cap of the cone
     float t = (minH - r.getOrigin().y)/r.getDirection().y;
     if(insideCapRadius(r, t, minH)){
-        intersects.push_back(Intersection(t, this));
+        times[count++] = t;
     }
 
     // Calculates time when ray is level with the top cap of the cone
     t = (maxH - r.getOrigin().y)/r.getDirection().y;
     if(insideCapRadius(r, t, maxH)){
-        intersects.push_back(Intersection(t, this));
+        times[count++] = t;
     }
+
+    return count;
 }
 
 // Triangle constructor
@@ -602,34 +1134,79 @@ bool Triangle::childEqual(Shape* s){
     return true;
 }
 
-// Moller-Trumbore ray-triangle intersection algorithm
-std::vector<Intersection> Triangle::childIntersections(Ray r){
-    Vector dir_cross_e2 = crossProduct(r.getDirection(), e2);
-    float det = dotProduct(e1, dir_cross_e2);
-
-    // Ray is parallel to triangle
-    if(std::abs(det) < EPSILON){
-        return std::vector<Intersection>();
+// Same steps as intersectTriangle with every ray in its own lane, a lane that fails a step is masked off instead of returning
+int Triangle::intersectTrianglePacket(const RayPacket &p, int mask, const Point &p1, const Vector &e1, const Vector &e2, float tmin,
+                                      const float tmax[PACKET_SIZE], float t[PACKET_SIZE], float u[PACKET_SIZE], float v[PACKET_SIZE]){
+#ifdef TUPLE_USE_SSE
+    __m128 dx = _mm_load_ps(p.dx), dy = _mm_load_ps(p.dy), dz = _mm_load_ps(p.dz);
+    __m128 e1x = _mm_set1_ps(e1.x), e1y = _mm_set1_ps(e1.y), e1z = _mm_set1_ps(e1.z);
+    __m128 e2x = _mm_set1_ps(e2.x), e2y = _mm_set1_ps(e2.y), e2z = _mm_set1_ps(e2.z);
+
+    // dir_cross_e2 and the determinant
+    __m128 cx = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y));
+    __m128 cy = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z));
+    __m128 cz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+    __m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, cx), _mm_mul_ps(e1y, cy)), _mm_mul_ps(e1z, cz));
+    __m128 valid = _mm_cmpge_ps(absLanes(det), _mm_set1_ps(EPSILON));
+    __m128 f = _mm_div_ps(_mm_set1_ps(1), det);
+
+    // p1_to_origin and the p1-p3 edge
+    __m128 sx = _mm_sub_ps(_mm_load_ps(p.ox), _mm_set1_ps(p1.x));
+    __m128 sy = _mm_sub_ps(_mm_load_ps(p.oy), _mm_set1_ps(p1.y));
+    __m128 sz = _mm_sub_ps(_mm_load_ps(p.oz), _mm_set1_ps(p1.z));
+    __m128 uLanes = _mm_mul_ps(f, _mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, cx), _mm_mul_ps(sy, cy)), _mm_mul_ps(sz, cz)));
+    valid = _mm_and_ps(valid, _mm_and_ps(_mm_cmpge_ps(uLanes, _mm_setzero_ps()), _mm_cmple_ps(uLanes, _mm_set1_ps(1))));
+
+    // origin_cross_e1 and the p1-p2 and p2-p3 edges
+    __m128 qx = _mm_sub_ps(_mm_mul_ps(sy, e1z), _mm_mul_ps(sz, e1y));
+    __m128 qy = _mm_sub_ps(_mm_mul_ps(sz, e1x), _mm_mul_ps(sx, e1z));
+    __m128 qz = _mm_sub_ps(_mm_mul_ps(sx, e1y), _mm_mul_ps(sy, e1x));
+    __m128 vLanes = _mm_mul_ps(f, _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_mul_ps(dy, qy)), _mm_mul_ps(dz, qz)));
+    valid = _mm_and_ps(valid, _mm_and_ps(_mm_cmpge_ps(vLanes, _mm_setzero_ps()), _mm_cmple_ps(_mm_add_ps(uLanes, vLanes), _mm_set1_ps(1))));
+
+    __m128 tLanes = _mm_mul_ps(f, _mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)));
+    _mm_storeu_ps(t, tLanes);
+    _mm_storeu_ps(u, uLanes);
+    _mm_storeu_ps(v, vLanes);
+    return _mm_movemask_ps(_mm_and_ps(valid, inRange(tLanes, tmin, tmax))) & mask;
+#else
+    int hit = 0;
+    for(int i = 0; i < PACKET_SIZE; i++){
+        if((mask & (1 << i)) && intersectTriangle(p.getRay(i), p1, e1, e2, t[i], u[i], v[i]) && t[i] >= tmin && t[i] < tmax[i]){
+            hit |= 1 << i;
+        }
     }
+    return hit;
+#endif
+}
 
-    // Ray misses p1-p3 edge
-    float f = 1.0/det;
-    Vector p1_to_origin = r.getOrigin() - p1;
-    float u = f*dotProduct(p1_to_origin, dir_cross_e2);
-    if(u < 0 || u > 1){
-        return std::vector<Intersection>();
+void Triangle::childIntersections(Ray r, std::vector<Intersection> &intersects){
+    float t, u, v;
+    if(intersectTriangle(r, p1, e1, e2, t, u, v)){
+        intersects.push_back(Intersection(t, this));
     }
+}
 
-    // Ray misses p1-p2 edge and ray misses the p2-p3 edge
-    Vector origin_cross_e1 = crossProduct(p1_to_origin, e1);
-    float v = f*dotProduct(r.getDirection(), origin_cross_e1);
-    if(v < 0 || (u + v) > 1){
-        return std::vector<Intersection>();
+// Smooth triangles have the same shape so they also use this
+bool Triangle::childOccluded(Ray r, float tmax){
+    float t, u, v;
+    return getMaterial().castsShadow && intersectTriangle(r, p1, e1, e2, t, u, v) && t >= 0 && t < tmax;
+}
+
+bool Triangle::childClosestHit(Ray r, float tmin, float tmax, Intersection &hit){
+    float t, u, v;
+    if(!intersectTriangle(r, p1, e1, e2, t, u, v) || t < tmin || t >= tmax){
+        return false;
     }
 
-    // Ray hits the triangle
-    float t = f*dotProduct(e2, origin_cross_e1);
-    return std::vector<Intersection>({Intersection(t, this)});
+    hit = Intersection(t, this);
+    return true;
+}
+
+int Triangle::childClosestHitPacket(const RayPacket &p, int mask, float tmin, float tmax[PACKET_SIZE], Intersection hits[PACKET_SIZE]){
+    float t[PACKET_SIZE], u[PACKET_SIZE], v[PACKET_SIZE];
+    int hit = intersectTrianglePacket(p, mask, p1, e1, e2, tmin, tmax, t, u, v);
+    return storePacketHits(this, hit, t, tmax, hits);
 }
 
 // The normal on any point of the triangle is the precomputed normal
@@ -637,6 +1214,14 @@ Vector Triangle::childNormal(Point p, Intersection hit){
     return normal;
 }
 
+BoundingBox Triangle::bounds(){
+    BoundingBox box;
+    box.add(p1);
+    box.add(p2);
+    box.add(p3);
+    return box;
+}
+
 // SmoothTriangle Constructor
 SmoothTriangle::SmoothTriangle(Point p1, Point p2, Point p3, Vector n1, Vector n2, Vector n3): Triangle(p1, p2, p3) {
     this->n1 = n1;
@@ -670,34 +1255,34 @@ bool SmoothTriangle::childEqual(Shape* s){
     return Triangle::isEqual(s);
 }
 
-// Moller-Trumbore ray-triangle intersection algorithm
-std::vector<Intersection> SmoothTriangle::childIntersections(Ray r){
-    Vector dir_cross_e2 = crossProduct(r.getDirection(), e2);
-    float det = dotProduct(e1, dir_cross_e2);
-
-    // Ray is parallel to triangle
-    if(std::abs(det) < EPSILON){
-        return std::vector<Intersection>();
+void SmoothTriangle::childIntersections(Ray r, std::vector<Intersection> &intersects){
+    float t, u, v;
+    if(intersectTriangle(r, p1, e1, e2, t, u, v)){
+        intersects.push_back(Intersection(t, this, u, v));
     }
+}
 
-    // Ray misses p1-p3 edge
-    float f = 1.0/det;
-    Vector p1_to_origin = r.getOrigin() - p1;
-    float u = f*dotProduct(p1_to_origin, dir_cross_e2);
-    if(u < 0 || u > 1){
-        return std::vector<Intersection>();
+// Smooth triangles also store where the triangle was hit for the normal calculation
+bool SmoothTriangle::childClosestHit(Ray r, float tmin, float tmax, Intersection &hit){
+    float t, u, v;
+    if(!intersectTriangle(r, p1, e1, e2, t, u, v) || t < tmin || t >= tmax){
+        return false;
     }
 
-    // Ray misses p1-p2 edge and ray misses the p2-p3 edge
-    Vector origin_cross_e1 = crossProduct(p1_to_origin, e1);
-    float v = f*dotProduct(r.getDirection(), origin_cross_e1);
-    if(v < 0 || (u + v) > 1){
-        return std::vector<Intersection>();
-    }
+    hit = Intersection(t, this, u, v);
+    return true;
+}
 
-    // Ray hits the triangle
-    float t = f*dotProduct(e2, origin_cross_e1);
-    return std::vector<Intersection>({Intersection(t, this, u, v)});
+int SmoothTriangle::childClosestHitPacket(const RayPacket &p, int mask, float tmin, float tmax[PACKET_SIZE], Intersection hits[PACKET_SIZE]){
+    float t[PACKET_SIZE], u[PACKET_SIZE], v[PACKET_SIZE];
+    int hit = intersectTrianglePacket(p, mask, p1, e1, e2, tmin, tmax, t, u, v);
+    for(int i = 0; i < PACKET_SIZE; i++){
+        if(hit & (1 << i)){
+            hits[i] = Intersection(t[i], this, u[i], v[i]);
+            tmax[i] = t[i];
+        }
+    }
+    return hit;
 }
 
 Vector SmoothTriangle::childNormal(Point p, Intersection hit){
@@ -0,0 +1,328 @@
+#include "SphereSet.h"
+#include <cmath>
+#ifdef __AVX__
+#include <immintrin.h>
+#endif
+
+void SphereSet::checkIndex(int i, const std::string &function){
+    if(i < 0 || i >= sphereCount()){
+        throw std::invalid_argument("SphereSet:" + function + " - Invalid input: " + std::to_string(i));
+    }
+}
+
+int SphereSet::addSphere(Point center, float radius){
+    if(!(radius > 0)){
+        throw std::invalid_argument("SphereSet:addSphere - Invalid input: radius must be positive");
+    }
+
+    centerX.push_back(center.x);
+    centerY.push_back(center.y);
+    centerZ.push_back(center.z);
+    radii.push_back(radius);
+    materialIds.push_back(-1);
+
+    // Parents only need to know if the box grew, like Mesh::addTriangle
+    BoundingBox old = box;
+    box.add(BoundingBox(Point(center.x - radius, center.y - radius, center.z - radius), Point(center.x + radius, center.y + radius, center.z + radius)));
+    bvhBuilt = false;
+    if(!old.containsPoint(box.min) || !old.containsPoint(box.max)){
+        updateParentBounds();
+    }else{
+        changed();
+    }
+    return sphereCount() - 1;
+}
+
+int SphereSet::addSphere(Point center, float radius, const Material &m){
+    int i = addSphere(center, radius);
+    setSphereMaterial(i, m);
+    return i;
+}
+
+int SphereSet::sphereCount(){
+    return radii.size();
+}
+
+Point SphereSet::getCenter(int i){
+    checkIndex(i, "getCenter");
+    return Point(centerX[i], centerY[i], centerZ[i]);
+}
+
+float SphereSet::getRadius(int i){
+    checkIndex(i, "getRadius");
+    return radii[i];
+}
+
+const Material& SphereSet::getSphereMaterial(int i){
+    checkIndex(i, "getSphereMaterial");
+    return materialIds[i] == -1 ? getMaterial() : materials.get(materialIds[i]);
+}
+
+void SphereSet::setSphereMaterial(int i, const Material &m){
+    checkIndex(i, "setSphereMaterial");
+    materialIds[i] = materials.add(m);
+    changed();
+}
+
+int SphereSet::sphereMaterialCount(){
+    return materials.size();
+}
+
+// The spheres are put in the order of the leaves of a hierarchy built over the spheres, so each block of consecutive spheres
+// is close together and its box stays small. The hierarchy that is used is then built over the blocks
+void SphereSet::buildBVH(){
+    std::lock_guard<std::mutex> guard(bvhLock);
+    if(bvhBuilt){
+        return;
+    }
+
+    int count = sphereCount();
+    std::vector<BoundingBox> boxes(count);
+    for(int i = 0; i < count; i++){
+        Point center(centerX[i], centerY[i], centerZ[i]);
+        Vector extent(radii[i], radii[i], radii[i]);
+        boxes[i] = BoundingBox(center - extent, center + extent);
+    }
+    BVH sphereBVH;
+    sphereBVH.build(boxes, 2);
+    const std::vector<int> &order = sphereBVH.getOrder();
+
+    // Padding has a NaN center so the quadratic never has a solution
+    int blockCount = (count + SPHERE_BLOCK_SIZE - 1)/SPHERE_BLOCK_SIZE;
+    int size = blockCount*SPHERE_BLOCK_SIZE;
+    blocks.x.assign(size, NAN);
+    blocks.y.assign(size, NAN);
+    blocks.z.assign(size, NAN);
+    blocks.radiusSquared.assign(size, 0);
+    blocks.sphere.assign(size, -1);
+    std::vector<BoundingBox> blockBoxes(blockCount);
+    for(int i = 0; i < count; i++){
+        int s = order[i];
+        blocks.x[i] = centerX[s];
+        blocks.y[i] = centerY[s];
+        blocks.z[i] = centerZ[s];
+        blocks.radiusSquared[i] = radii[s]*radii[s];
+        blocks.sphere[i] = s;
+        blockBoxes[i/SPHERE_BLOCK_SIZE].add(boxes[s]);
+    }
+
+    bvh.build(blockBoxes);
+    bvhBuilt = true;
+}
+
+// Same quadratic as Sphere::hitTime with the sphere moved to the origin and b halved, which cancels the 2s and 4. The
+// discriminant is computed from the distance between the center and the closest point on the ray(b^2 - ac = a(r^2 - l^2))
+// rather than from c, which loses most of its precision for small spheres far from the ray's origin
+int SphereSet::intersectBlock(int block, const float origin[3], const float direction[3], float a, float near[SPHERE_BLOCK_SIZE], float far[SPHERE_BLOCK_SIZE]){
+    int first = block*SPHERE_BLOCK_SIZE;
+#ifdef __AVX__
+    __m256 ocX = _mm256_sub_ps(_mm256_set1_ps(origin[0]), _mm256_loadu_ps(&blocks.x[first]));
+    __m256 ocY = _mm256_sub_ps(_mm256_set1_ps(origin[1]), _mm256_loadu_ps(&blocks.y[first]));
+    __m256 ocZ = _mm256_sub_ps(_mm256_set1_ps(origin[2]), _mm256_loadu_ps(&blocks.z[first]));
+    __m256 dX = _mm256_set1_ps(direction[0]), dY = _mm256_set1_ps(direction[1]), dZ = _mm256_set1_ps(direction[2]);
+    __m256 halfB = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dX, ocX), _mm256_mul_ps(dY, ocY)), _mm256_mul_ps(dZ, ocZ));
+    __m256 invA = _mm256_set1_ps(1/a);
+    __m256 s = _mm256_mul_ps(halfB, invA);
+    __m256 lX = _mm256_sub_ps(ocX, _mm256_mul_ps(s, dX));
+    __m256 lY = _mm256_sub_ps(ocY, _mm256_mul_ps(s, dY));
+    __m256 lZ = _mm256_sub_ps(ocZ, _mm256_mul_ps(s, dZ));
+    __m256 lengthSquared = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(lX, lX), _mm256_mul_ps(lY, lY)), _mm256_mul_ps(lZ, lZ));
+    __m256 discriminant = _mm256_mul_ps(_mm256_set1_ps(a), _mm256_sub_ps(_mm256_loadu_ps(&blocks.radiusSquared[first]), lengthSquared));
+    // NaN for negative discriminants and padding, which the comparison below rejects
+    __m256 root = _mm256_sqrt_ps(discriminant);
+    _mm256_storeu_ps(near, _mm256_mul_ps(_mm256_sub_ps(_mm256_sub_ps(_mm256_setzero_ps(), halfB), root), invA));
+    _mm256_storeu_ps(far, _mm256_mul_ps(_mm256_sub_ps(root, halfB), invA));
+    return _mm256_movemask_ps(_mm256_cmp_ps(discriminant, _mm256_setzero_ps(), _CMP_GE_OQ));
+#elif defined(TUPLE_USE_SSE)
+    // Two passes of four without AVX
+    int mask = 0;
+    for(int i = 0; i < SPHERE_BLOCK_SIZE; i += 4){
+        __m128 ocX = _mm_sub_ps(_mm_set1_ps(origin[0]), _mm_loadu_ps(&blocks.x[first + i]));
+        __m128 ocY = _mm_sub_ps(_mm_set1_ps(origin[1]), _mm_loadu_ps(&blocks.y[first + i]));
+        __m128 ocZ = _mm_sub_ps(_mm_set1_ps(origin[2]), _mm_loadu_ps(&blocks.z[first + i]));
+        __m128 dX = _mm_set1_ps(direction[0]), dY = _mm_set1_ps(direction[1]), dZ = _mm_set1_ps(direction[2]);
+        __m128 halfB = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dX, ocX), _mm_mul_ps(dY, ocY)), _mm_mul_ps(dZ, ocZ));
+        __m128 invA = _mm_set1_ps(1/a);
+        __m128 s = _mm_mul_ps(halfB, invA);
+        __m128 lX = _mm_sub_ps(ocX, _mm_mul_ps(s, dX));
+        __m128 lY = _mm_sub_ps(ocY, _mm_mul_ps(s, dY));
+        __m128 lZ = _mm_sub_ps(ocZ, _mm_mul_ps(s, dZ));
+        __m128 lengthSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(lX, lX), _mm_mul_ps(lY, lY)), _mm_mul_ps(lZ, lZ));
+        __m128 discriminant = _mm_mul_ps(_mm_set1_ps(a), _mm_sub_ps(_mm_loadu_ps(&blocks.radiusSquared[first + i]), lengthSquared));
+        __m128 root = _mm_sqrt_ps(discriminant);
+        _mm_storeu_ps(near + i, _mm_mul_ps(_mm_sub_ps(_mm_sub_ps(_mm_setzero_ps(), halfB), root), invA));
+        _mm_storeu_ps(far + i, _mm_mul_ps(_mm_sub_ps(root, halfB), invA));
+        mask |= _mm_movemask_ps(_mm_cmpge_ps(discriminant, _mm_setzero_ps())) << i;
+    }
+    return mask;
+#else
+    int mask = 0;
+    for(int i = 0; i < SPHERE_BLOCK_SIZE; i++){
+        float ocX = origin[0] - blocks.x[first + i];
+        float ocY = origin[1] - blocks.y[first + i];
+        float ocZ = origin[2] - blocks.z[first + i];
+        float halfB = direction[0]*ocX + direction[1]*ocY + direction[2]*ocZ;
+        float s = halfB/a;
+        float lX = ocX - s*direction[0];
+        float lY = ocY - s*direction[1];
+        float lZ = ocZ - s*direction[2];
+        float discriminant = a*(blocks.radiusSquared[first + i] - (lX*lX + lY*lY + lZ*lZ));
+        if(discriminant >= 0){
+            float root = std::sqrt(discriminant);
+            near[i] = (-halfB - root)/a;
+            far[i] = (root - halfB)/a;
+            mask |= 1 << i;
+        }
+    }
+    return mask;
+#endif
+}
+
+// Checks equality of sphere sets, every sphere and its material has to match
+bool SphereSet::childEqual(Shape* s){
+    SphereSet* set = dynamic_cast<SphereSet*>(s);
+    if(set == nullptr || sphereCount() != set->sphereCount()){
+        return false;
+    }
+
+    for(int i = 0; i < sphereCount(); i++){
+        if(!getCenter(i).isEqual(set->getCenter(i)) || !floatIsEqual(radii[i], set->getRadius(i))){
+            return false;
+        }
+        if(!getSphereMaterial(i).isEqual(set->getSphereMaterial(i))){
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Each sphere's two intersections are a run, the runs are merged at the end like Mesh's triangles
+void SphereSet::childIntersections(Ray r, std::vector<Intersection> &intersects){
+    if(!bvhBuilt){
+        buildBVH();
+    }
+
+    Point o = r.getOrigin();
+    Vector d = r.getDirection();
+    const float origin[3] = {o.x, o.y, o.z};
+    const float direction[3] = {d.x, d.y, d.z};
+    float a = dotProduct(d, d);
+
+    std::vector<int> &runs = runBuffer();
+    int firstRun = runs.size();
+    bvh.traverse(r, -INFINITY, INFINITY, [&](int block, float tmax){
+        float near[SPHERE_BLOCK_SIZE], far[SPHERE_BLOCK_SIZE];
+        int mask = intersectBlock(block, origin, direction, a, near, far);
+        for(int i = 0; i < SPHERE_BLOCK_SIZE; i++){
+            if(mask & (1 << i)){
+                int sphere = blocks.sphere[block*SPHERE_BLOCK_SIZE + i];
+                runs.push_back(intersects.size());
+                intersects.push_back(Intersection(near[i], this, -1, -1, sphere));
+                intersects.push_back(Intersection(far[i], this, -1, -1, sphere));
+            }
+        }
+        return tmax;
+    });
+    mergeRuns(intersects, runs, firstRun);
+    runs.resize(firstRun);
+}
+
+// Stops at the first shadow casting sphere that blocks the ray
+bool SphereSet::childOccluded(Ray r, float tmax){
+    if(!bvhBuilt){
+        buildBVH();
+    }
+
+    Point o = r.getOrigin();
+    Vector d = r.getDirection();
+    const float origin[3] = {o.x, o.y, o.z};
+    const float direction[3] = {d.x, d.y, d.z};
+    float a = dotProduct(d, d);
+
+    bool occluded = false;
+    bvh.traverse(r, 0, tmax, [&](int block, float t){
+        float near[SPHERE_BLOCK_SIZE], far[SPHERE_BLOCK_SIZE];
+        int mask = intersectBlock(block, origin, direction, a, near, far);
+        for(int i = 0; i < SPHERE_BLOCK_SIZE; i++){
+            if(!(mask & (1 << i))){
+                continue;
+            }
+            bool inRange = (near[i] >= 0 && near[i] < tmax) || (far[i] >= 0 && far[i] < tmax);
+            if(inRange && getSphereMaterial(blocks.sphere[block*SPHERE_BLOCK_SIZE + i]).castsShadow){
+                occluded = true;
+                return -INFINITY;
+            }
+        }
+        return t;
+    });
+
+    return occluded;
+}
+
+// Every hit shrinks tmax so the hierarchy can skip everything behind it
+bool SphereSet::childClosestHit(Ray r, float tmin, float tmax, Intersection &hit){
+    if(!bvhBuilt){
+        buildBVH();
+    }
+
+    Point o = r.getOrigin();
+    Vector d = r.getDirection();
+    const float origin[3] = {o.x, o.y, o.z};
+    const float direction[3] = {d.x, d.y, d.z};
+    float a = dotProduct(d, d);
+
+    bool found = false;
+    bvh.traverse(r, tmin, tmax, [&](int block, float tmax){
+        float near[SPHERE_BLOCK_SIZE], far[SPHERE_BLOCK_SIZE];
+        int mask = intersectBlock(block, origin, direction, a, near, far);
+        for(int i = 0; i < SPHERE_BLOCK_SIZE; i++){
+            if(!(mask & (1 << i))){
+                continue;
+            }
+            // The exit time is only the closest if the ray starts inside the sphere
+            float t = near[i] >= tmin ? near[i] : far[i];
+            if(t >= tmin && t < tmax){
+                hit = Intersection(t, this, -1, -1, blocks.sphere[block*SPHERE_BLOCK_SIZE + i]);
+                tmax = t;
+                found = true;
+            }
+        }
+        return tmax;
+    });
+
+    return found;
+}
+
+Vector SphereSet::childNormal(Point p, Intersection hit){
+    int i = hit.getIndex();
+    checkIndex(i, "childNormal");
+    return Vector(p - Point(centerX[i], centerY[i], centerZ[i]))/radii[i];
+}
+
+int SphereSet::solidOf(int index){
+    return index;
+}
+
+const Material& SphereSet::getSolidMaterial(int solid){
+    return solid < 0 ? getMaterial() : getSphereMaterial(solid);
+}
+
+// Materials that were replaced by setSphereMaterial are still in the table, it is rebuilt with only the materials
+// the spheres use so changing materials over and over does not keep growing it
+void SphereSet::commit(const Matrix4 &parentWorld, const Matrix4 &parentWorldInverse, CommittedLeaves* leaves){
+    MaterialTable used;
+    for(int &id : materialIds){
+        if(id != -1){
+            id = used.add(materials.get(id));
+        }
+    }
+    materials = std::move(used);
+
+    buildBVH();
+    Shape::commit(parentWorld, parentWorldInverse, leaves);
+}
+
+BoundingBox SphereSet::bounds(){
+    return box;
+}
@@ -0,0 +1,91 @@
+#include "TileScheduler.h"
+
+// TileScheduler constructor
+TileScheduler::TileScheduler(int width, int height, int tileSize, int threads){
+    this->width = width;
+    this->height = height;
+    this->tileSize = tileSize < 1 ? 1 : tileSize;
+    tilesX = (width + this->tileSize - 1)/this->tileSize;
+    tilesY = (height + this->tileSize - 1)/this->tileSize;
+
+    if(threads < 1){
+        threads = std::thread::hardware_concurrency();
+    }
+    // hardware_concurrency can return 0 if it is unknown, never use more threads than there are tiles
+    threadCount = std::max(1, std::min(threads, getTileCount()));
+}
+
+int TileScheduler::getThreadCount(){
+    return threadCount;
+}
+
+int TileScheduler::getTileCount(){
+    return tilesX*tilesY;
+}
+
+bool TileScheduler::nextTile(std::vector<TileQueue> &queues, int thread, int &tile){
+    // Own queue, taken from the front
+    {
+        std::lock_guard<std::mutex> guard(queues[thread].lock);
+        if(!queues[thread].tiles.empty()){
+            tile = queues[thread].tiles.front();
+            queues[thread].tiles.pop_front();
+            return true;
+        }
+    }
+
+    // Steals from the back of the other queues, starting at the next thread so thieves spread out
+    for(int i = 1; i < threadCount; i++){
+        TileQueue &victim = queues[(thread + i) % threadCount];
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if(!victim.tiles.empty()){
+            tile = victim.tiles.back();
+            victim.tiles.pop_back();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void TileScheduler::run(std::function<void(int, int, int, int)> renderTile){
+    // Deals out contiguous runs of tiles so neighbouring tiles(which usually cost about the same) start on the same thread
+    std::vector<TileQueue> queues(threadCount);
+    int tileCount = getTileCount();
+    for(int t = 0; t < tileCount; t++){
+        queues[(long long)t*threadCount/tileCount].tiles.push_back(t);
+    }
+
+    std::exception_ptr error = nullptr;
+    std::mutex errorLock;
+
+    auto worker = [&](int thread){
+        int tile;
+        while(nextTile(queues, thread, tile)){
+            int x = (tile % tilesX)*tileSize;
+            int y = (tile/tilesX)*tileSize;
+            try{
+                renderTile(x, y, std::min(tileSize, width - x), std::min(tileSize, height - y));
+            }catch(...){
+                std::lock_guard<std::mutex> guard(errorLock);
+                if(error == nullptr){
+                    error = std::current_exception();
+                }
+            }
+        }
+    };
+
+    // The calling thread works as thread 0
+    std::vector<std::thread> threads;
+    for(int i = 1; i < threadCount; i++){
+        threads.push_back(std::thread(worker, i));
+    }
+    worker(0);
+    for(int i = 0; i < threads.size(); i++){
+        threads.at(i).join();
+    }
+
+    if(error != nullptr){
+        std::rethrow_exception(error);
+    }
+}
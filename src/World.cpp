@@ -1,10 +1,23 @@
 #include "World.h"
+#include <unordered_set>
 
 // World constructor
 World::World(){
     light = LightSource();
 }
 
+World::World(const World &w){
+    objects = w.objects;
+    light = w.light;
+}
+
+World& World::operator=(const World &w){
+    objects = w.objects;
+    light = w.light;
+    committed = false;
+    return *this;
+}
+
 // Gets the list of objects in the world
 std::vector<Shape*> World::getObjects(){
     return objects;
@@ -18,6 +31,7 @@ LightSource World::getLight(){
 // Adds an object to the world
 void World::appendObject(Shape* s){
     objects.push_back(s);
+    committed = false;
 }
 
 // Sets the light source
@@ -28,36 +42,183 @@ void World::setLight(LightSource l){
 // Sets the objects in the world
 void World::setObjects(std::vector<Shape*> obj){
     objects = obj;
+    committed = false;
+}
+
+// Locked so threads sharing a world can each commit it before rendering
+void World::commit(){
+    std::lock_guard<std::mutex> guard(commitLock);
+    if(isCommitted()){
+        return;
+    }
+
+    committed = false;
+    committedVersions.clear();
+    CommittedLeaves leaves;
+    for(int i = 0; i < objects.size(); i++){
+        objects.at(i)->commit(Matrix4(), Matrix4(), &leaves);
+        committedVersions.push_back(objects.at(i)->getVersion());
+    }
+
+    // Prototypes are baked relative to themselves, which a prototype in the world would overwrite. Each distinct prototype
+    // is committed once however many instances place it
+    std::unordered_set<Shape*> objectSet(objects.begin(), objects.end());
+    std::unordered_set<Shape*> prototypes;
+    for(int i = 0; i < leaves.prototypes.size(); i++){
+        if(objectSet.count(leaves.prototypes[i])){
+            throw std::invalid_argument("World:commit - Invalid input: an instance's prototype can not also be an object of the world");
+        }
+        if(prototypes.insert(leaves.prototypes[i]).second){
+            leaves.prototypes[i]->commit(Matrix4(), Matrix4(), nullptr);
+        }
+    }
+
+    bvhLeaves.clear();
+    unboundedLeaves.clear();
+    std::vector<BoundingBox> boxes;
+    for(int i = 0; i < leaves.shapes.size(); i++){
+        // Shapes with empty bounds(eg. empty meshes) can never be hit
+        if(leaves.boxes[i].isUnbounded()){
+            unboundedLeaves.add(leaves.shapes[i], leaves.shapes[i]->getWorldInverse());
+        }else if(!leaves.boxes[i].isEmpty()){
+            bvhLeaves.add(leaves.shapes[i], leaves.shapes[i]->getWorldInverse());
+            boxes.push_back(leaves.boxes[i]);
+        }
+    }
+
+    bvh.build(boxes);
+    committed = true;
+}
+
+bool World::isCommitted(){
+    if(!committed){
+        return false;
+    }
+
+    for(int i = 0; i < objects.size(); i++){
+        if(objects.at(i)->getVersion() != committedVersions[i]){
+            return false;
+        }
+    }
+    return true;
 }
 
 // Returns a vector of intersections where the ray intersects the surface of the objects in the world
 std::vector<Intersection> World::RayIntersection(Ray r){
-    // Initializes the intersection vectors needed to compute the intersections
     std::vector<Intersection> intersects;
-    std::vector<Intersection> temp;
+    RayIntersection(r, intersects);
+    return intersects;
+}
 
-    // Adds the intersections of all the objects with the ray into
-    // the intersects vector
-    for(int i = 0; i < objects.size(); i++){
-        temp = objects.at(i)->findIntersections(r);
-        for(int j = 0; j < temp.size(); j++){
-            intersects.push_back(temp.at(j));
+void World::RayIntersection(Ray r, std::vector<Intersection> &intersects){
+    if(!committed){
+        commit();
+    }
+
+    // Adds the intersections of all the leaves with the ray into
+    // the intersects vector, planes first and then every leaf whose box the ray passes through
+    // Each leaf's intersections are already sorted and all of them are merged together at the end
+    std::vector<int> &runs = runBuffer();
+    int firstRun = runs.size();
+    for(int i = 0; i < unboundedLeaves.size(); i++){
+        runs.push_back(intersects.size());
+        unboundedLeaves.intersections(i, r, intersects);
+    }
+
+    bvh.traverse(r, -INFINITY, INFINITY, [&](int i, float tmax){
+        runs.push_back(intersects.size());
+        bvhLeaves.intersections(i, r, intersects);
+        return tmax;
+    });
+    mergeRuns(intersects, runs, firstRun);
+    runs.resize(firstRun);
+}
+
+// Every hit shrinks tmax so the hierarchy can skip everything behind it
+bool World::findClosestHit(Ray r, float tmin, float tmax, Intersection &hit){
+    if(!committed){
+        commit();
+    }
+
+    bool found = false;
+    for(int i = 0; i < unboundedLeaves.size(); i++){
+        if(unboundedLeaves.closestHit(i, r, tmin, tmax, hit)){
+            tmax = hit.getTime();
+            found = true;
         }
     }
 
-    std::sort(intersects.begin(), intersects.end(), compareIntersections);
+    bvh.traverse(r, tmin, tmax, [&](int i, float t){
+        if(bvhLeaves.closestHit(i, r, tmin, t, hit)){
+            found = true;
+            return hit.getTime();
+        }
+        return t;
+    });
 
-    return intersects;
+    return found;
+}
+
+// Every leaf is given the packet moved into its space, which only tests the rays that reach it
+int World::findClosestHitPacket(const RayPacket &p, int mask, float tmin, float tmax[PACKET_SIZE], Intersection hits[PACKET_SIZE]){
+    if(!committed){
+        commit();
+    }
+
+    int found = 0;
+    if(!p.isCoherent(mask)){
+        for(int i = 0; i < PACKET_SIZE; i++){
+            if((mask & (1 << i)) && findClosestHit(p.getRay(i), tmin, tmax[i], hits[i])){
+                tmax[i] = hits[i].getTime();
+                found |= 1 << i;
+            }
+        }
+        return found;
+    }
+
+    for(int i = 0; i < unboundedLeaves.size(); i++){
+        found |= unboundedLeaves.closestHitPacket(i, p, mask, tmin, tmax, hits);
+    }
+
+    bvh.traversePacket(p, mask, tmin, tmax, [&](int i, int lanes){
+        found |= bvhLeaves.closestHitPacket(i, p, lanes, tmin, tmax, hits);
+    });
+
+    return found;
+}
+
+// Checks the planes first and then every object whose box the ray passes through before tmax
+bool World::isOccluded(Ray r, float tmax){
+    if(!committed){
+        commit();
+    }
+
+    for(int i = 0; i < unboundedLeaves.size(); i++){
+        if(unboundedLeaves.occluded(i, r, tmax)){
+            return true;
+        }
+    }
+
+    bool occluded = false;
+    bvh.traverse(r, 0, tmax, [&](int i, float t){
+        if(bvhLeaves.occluded(i, r, tmax)){
+            occluded = true;
+            return -INFINITY;
+        }
+        return t;
+    });
+
+    return occluded;
 }
 
 // Returns the computed colour of a hit using the world light source and the LightData data structure
-Colour World::shadeHit(LightData data, int remaining){
-    bool shadowed = data.object->getMaterial().castsShadow && hasShadow(data.overPoint);
-    Colour surfaceCol = computeLighting(data.object->getMaterial(), data.object, light, data.overPoint, data.camera, data.normal, shadowed);
+Colour World::shadeHit(const LightData &data, int remaining){
+    bool shadowed = hasShadow(data.overPoint);
+    const Material &m = data.getMaterial();
+    Colour surfaceCol = computeLighting(m, data.object, light, data.overPoint, data.camera, data.normal, shadowed);
     Colour reflectedCol = reflectedColour(data, remaining);
     Colour refractedCol = refractedColour(data, remaining);
 
-    Material m = data.object->getMaterial();
     if(m.reflective > 0 && m.transparency > 0){
         float reflectance = schlickApproximation(data);
         return surfaceCol + reflectedCol*reflectance + refractedCol*(1 - reflectance);
@@ -68,27 +229,50 @@ Colour World::shadeHit(LightData data, int remaining){
 
 // Computes the colour at the first point hit by the ray r
 Colour World::colourAtHit(Ray r, int remaining){
-    // Find intersections of ray at hit
-    std::vector<Intersection> intersects = this->RayIntersection(r);
-
-    if(intersects.size() == 0){
+    // Find the object that is hit first
+    Intersection closest(0, nullptr);
+    if(!findClosestHit(r, 0, INFINITY, closest)){
         return Colour();
     }
 
-    int ind = -1;
-    for(int i = 0; i < intersects.size(); i++){
-        if(intersects.at(i).getTime() >= 0){
-            ind = i;
-            break;
-        }
+    return shadeClosestHit(r, closest, remaining);
+}
+
+// Only the first hit is traced as a packet, the shadow, reflected and refracted rays are traced one at a time
+void World::colourAtHitPacket(const Ray rays[PACKET_SIZE], Colour colours[PACKET_SIZE], int remaining){
+    RayPacket p(rays);
+    float tmax[PACKET_SIZE];
+    Intersection hits[PACKET_SIZE];
+    for(int i = 0; i < PACKET_SIZE; i++){
+        tmax[i] = INFINITY;
     }
 
-    if(ind == -1){
-        return Colour();
+    int found = findClosestHitPacket(p, PACKET_ALL, 0, tmax, hits);
+    for(int i = 0; i < PACKET_SIZE; i++){
+        colours[i] = (found & (1 << i)) ? shadeClosestHit(rays[i], hits[i], remaining) : Colour();
+    }
+}
+
+Colour World::shadeClosestHit(Ray r, const Intersection &closest, int remaining){
+    // The refractive indices are only used when the object hit is transparent, which is the only time
+    // every intersection along the ray is needed
+    // The buffer is only used until the light data is prepared, so the recursive calls in shadeHit can reuse it
+    // The list is sorted so the hit is the first intersection that is not behind the ray
+    if(closest.getMaterial().transparency > 0){
+        thread_local std::vector<Intersection> intersects;
+        intersects.clear();
+        this->RayIntersection(r, intersects);
+        int ind = 0;
+        while(ind < intersects.size() && intersects[ind].getTime() < 0){
+            ind++;
+        }
+        if(ind < intersects.size()){
+            LightData data = prepareLightData(intersects, ind, r);
+            return this->shadeHit(data, remaining);
+        }
     }
 
-    // Uses object that is hit first
-    LightData data = prepareLightData(intersects.at(ind), r, intersects);
+    LightData data = prepareLightData(closest, r);
     return this->shadeHit(data, remaining);
 }
 
@@ -103,31 +287,24 @@ bool World::hasShadow(Point p){
     Vector direction = v.normalize();
 
     Ray r(p, direction);
-    std::vector<Intersection> intersects = this->RayIntersection(r);
-
-    int ind = hit(intersects);
-    if(ind != -1 && intersects.at(ind).getTime() < distance){
-        return true;
-    }else{
-        return false;
-    }
+    return isOccluded(r, distance);
 }
 
 // Computes colour of a reflective surface in the world when it is hit by a ray
-Colour World::reflectedColour(LightData data, int remaining){
-    if(data.object->getMaterial().reflective == 0 || remaining <= 0){
+Colour World::reflectedColour(const LightData &data, int remaining){
+    if(data.getMaterial().reflective == 0 || remaining <= 0){
         return BLACK;
     }
 
     Ray reflectRay(data.overPoint, data.reflect);
     Colour c = colourAtHit(reflectRay, remaining - 1);
 
-    return c*data.object->getMaterial().reflective;
+    return c*data.getMaterial().reflective;
 }
 
 // Computes colour of a surface when hit by a ray based on the material's transparency and refractive properties
-Colour World::refractedColour(LightData data, int remaining){
-    if(data.object->getMaterial().transparency == 0 || remaining == 0){
+Colour World::refractedColour(const LightData &data, int remaining){
+    if(data.getMaterial().transparency == 0 || remaining == 0){
         return BLACK;
     }
 
@@ -151,7 +328,7 @@ Colour World::refractedColour(LightData data, int remaining){
     Vector direction = data.normal*(n_ratio*cos_i - cos_t) - data.camera*n_ratio;
     Ray refractedRay(data.underPoint, direction);
     // Finds colour of refracted ray
-    Colour c = colourAtHit(refractedRay, remaining - 1)*data.object->getMaterial().transparency;
+    Colour c = colourAtHit(refractedRay, remaining - 1)*data.getMaterial().transparency;
 
     // Multiplies by transparency value to account for any opacity
     return c;
@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+#include "BoundingBox.h"
+#include "Matrix.h"
+#include "Ray.h"
+#include "common.h"
+
+TEST(BoundingBoxTest, BasicTest){
+    BoundingBox empty;
+    EXPECT_TRUE(empty.isEmpty());
+    EXPECT_FALSE(empty.isUnbounded());
+
+    BoundingBox b(Point(-1, -2, -3), Point(3, 2, 1));
+    EXPECT_FALSE(b.isEmpty());
+    EXPECT_TRUE(b.min.isEqual(Point(-1, -2, -3)));
+    EXPECT_TRUE(b.max.isEqual(Point(3, 2, 1)));
+
+    BoundingBox infinite(Point(-INFINITY, 0, -INFINITY), Point(INFINITY, 0, INFINITY));
+    EXPECT_TRUE(infinite.isUnbounded());
+}
+
+TEST(BoundingBoxTest, AddPointsAndBoxes){
+    BoundingBox b;
+    b.add(Point(-5, 2, 0));
+    b.add(Point(7, 0, -3));
+    EXPECT_TRUE(b.min.isEqual(Point(-5, 0, -3)));
+    EXPECT_TRUE(b.max.isEqual(Point(7, 2, 0)));
+
+    b.add(BoundingBox(Point(8, -7, -2), Point(14, 4, 8)));
+    EXPECT_TRUE(b.min.isEqual(Point(-5, -7, -3)));
+    EXPECT_TRUE(b.max.isEqual(Point(14, 4, 8)));
+
+    // Adding an empty box does nothing
+    b.add(BoundingBox());
+    EXPECT_TRUE(b.min.isEqual(Point(-5, -7, -3)));
+    EXPECT_TRUE(b.max.isEqual(Point(14, 4, 8)));
+}
+
+TEST(BoundingBoxTest, ContainsPoint){
+    BoundingBox b(Point(5, -2, 0), Point(11, 4, 7));
+    EXPECT_TRUE(b.containsPoint(Point(5, -2, 0)));
+    EXPECT_TRUE(b.containsPoint(Point(11, 4, 7)));
+    EXPECT_TRUE(b.containsPoint(Point(8, 1, 3)));
+    EXPECT_FALSE(b.containsPoint(Point(3, 0, 3)));
+    EXPECT_FALSE(b.containsPoint(Point(8, -4, 3)));
+    EXPECT_FALSE(b.containsPoint(Point(8, 1, 8)));
+}
+
+TEST(BoundingBoxTest, TransformBox){
+    BoundingBox b(Point(-1, -1, -1), Point(1, 1, 1));
+    BoundingBox result = b.transform(xRotationMatrix(PI/4)*yRotationMatrix(PI/4));
+    EXPECT_TRUE(result.min.isEqual(Point(-1.41421, -1.70710, -1.70710)));
+    EXPECT_TRUE(result.max.isEqual(Point(1.41421, 1.70710, 1.70710)));
+
+    // Unbounded boxes stay unbounded
+    BoundingBox infinite(Point(-INFINITY, 0, -INFINITY), Point(INFINITY, 0, INFINITY));
+    EXPECT_TRUE(infinite.transform(translationMatrix(0, 1, 0)).isUnbounded());
+    EXPECT_TRUE(BoundingBox().transform(translationMatrix(0, 1, 0)).isEmpty());
+}
+
+TEST(BoundingBoxTest, RayIntersectsBox){
+    BoundingBox b(Point(5, -2, 0), Point(11, 4, 7));
+    EXPECT_TRUE(b.intersects(Ray(Point(15, 1, 2), Vector(-1, 0, 0))));
+    EXPECT_TRUE(b.intersects(Ray(Point(-5, -1, 4), Vector(1, 0, 0))));
+    EXPECT_TRUE(b.intersects(Ray(Point(7, 6, 5), Vector(0, -1, 0))));
+    EXPECT_TRUE(b.intersects(Ray(Point(9, -5, 6), Vector(0, 1, 0))));
+    EXPECT_TRUE(b.intersects(Ray(Point(8, 2, 12), Vector(0, 0, -1))));
+    EXPECT_TRUE(b.intersects(Ray(Point(6, 0, -5), Vector(0, 0, 1))));
+    EXPECT_TRUE(b.intersects(Ray(Point(8, 1, 3.5), Vector(0, 0, 1))));
+    EXPECT_FALSE(b.intersects(Ray(Point(9, -1, -8), Vector(2, 4, 6))));
+    EXPECT_FALSE(b.intersects(Ray(Point(8, 3, -4), Vector(6, 2, 4))));
+    EXPECT_FALSE(b.intersects(Ray(Point(9, -1, -2), Vector(4, 6, 2))));
+    EXPECT_FALSE(b.intersects(Ray(Point(4, 0, 9), Vector(0, 0, -1))));
+    EXPECT_FALSE(b.intersects(Ray(Point(8, 6, -1), Vector(0, -1, 0))));
+    EXPECT_FALSE(b.intersects(Ray(Point(12, 5, 4), Vector(1, 0, 0))));
+
+    EXPECT_FALSE(BoundingBox().intersects(Ray(Point(), Vector(0, 0, 1))));
+}
@@ -0,0 +1,356 @@
+#include <gtest/gtest.h>
+#include "BVH.h"
+#include "Group.h"
+#include "Shape.h"
+#include <random>
+#include <set>
+#include <algorithm>
+
+// Boxes scattered randomly in a 20x20x20 cube
+static std::vector<BoundingBox> randomBoxes(int n){
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> position(-10, 10);
+    std::uniform_real_distribution<float> size(0.1, 1);
+    std::vector<BoundingBox> boxes;
+    for(int i = 0; i < n; i++){
+        Point p(position(rng), position(rng), position(rng));
+        boxes.push_back(BoundingBox(p, Point(p + Vector(size(rng), size(rng), size(rng)))));
+    }
+    return boxes;
+}
+
+TEST(BVHTest, BasicTest){
+    BVH bvh;
+    EXPECT_TRUE(bvh.isEmpty());
+
+    std::vector<BoundingBox> boxes = randomBoxes(1000);
+    bvh.build(boxes, 2);
+    EXPECT_FALSE(bvh.isEmpty());
+    EXPECT_EQ(bvh.getWidth(), 2);
+    EXPECT_LE(bvh.getNodes().size(), 2*boxes.size() - 1);
+
+    // Every primitive is in exactly one leaf and every leaf box contains its primitives
+    std::vector<int> seen(boxes.size(), 0);
+    for(const BVH::Node &n : bvh.getNodes()){
+        BoundingBox nodeBox(Point(n.min[0], n.min[1], n.min[2]), Point(n.max[0], n.max[1], n.max[2]));
+        for(int i = 0; i < n.count; i++){
+            int p = bvh.getOrder().at(n.offset + i);
+            seen.at(p)++;
+            EXPECT_TRUE(nodeBox.containsPoint(boxes.at(p).min));
+            EXPECT_TRUE(nodeBox.containsPoint(boxes.at(p).max));
+        }
+    }
+    for(int count : seen){
+        EXPECT_EQ(count, 1);
+    }
+
+    bvh.clear();
+    EXPECT_TRUE(bvh.isEmpty());
+}
+
+TEST(BVHTest, TraversalVisitsEveryBoxTheRayHits){
+    std::vector<BoundingBox> boxes = randomBoxes(1000);
+    BVH bvh;
+    bvh.build(boxes);
+
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<float> dist(-1, 1);
+    for(int i = 0; i < 200; i++){
+        Ray r(Point(0, 0, -20), Vector(dist(rng), dist(rng), 1).normalize());
+        std::set<int> visited;
+        bvh.traverse(r, -INFINITY, INFINITY, [&](int p, float tmax){
+            visited.insert(p);
+            return tmax;
+        });
+
+        for(int p = 0; p < boxes.size(); p++){
+            if(boxes.at(p).intersects(r)){
+                EXPECT_EQ(visited.count(p), 1);
+            }
+        }
+    }
+}
+
+TEST(BVHTest, ClosestHitPrunesFartherNodes){
+    // A row of unit boxes along z, the ray hits all of them
+    std::vector<BoundingBox> boxes;
+    for(int i = 0; i < 64; i++){
+        boxes.push_back(BoundingBox(Point(-0.5, -0.5, 2*i), Point(0.5, 0.5, 2*i + 1)));
+    }
+    BVH bvh;
+    bvh.build(boxes);
+    Ray r(Point(0, 0, -5), Vector(0, 0, 1));
+
+    int visitedAll = 0;
+    bvh.traverse(r, 0, INFINITY, [&](int p, float tmax){
+        visitedAll++;
+        return tmax;
+    });
+    EXPECT_EQ(visitedAll, 64);
+
+    // Treats the entry of each box as a hit, after the nearest box is found the rest of the tree is skipped
+    int visitedClosest = 0;
+    float closest = INFINITY;
+    bvh.traverse(r, 0, INFINITY, [&](int p, float tmax){
+        visitedClosest++;
+        float t = boxes.at(p).min.z + 5;
+        closest = std::min(closest, t);
+        return std::min(t, tmax);
+    });
+    EXPECT_TRUE(floatIsEqual(closest, 5));
+    EXPECT_LE(visitedClosest, BVH_MAX_LEAF_SIZE);
+}
+
+TEST(BVHTest, GroupWithBVHMatchesEveryChild){
+    Group* g = new Group;
+    std::vector<Shape*> spheres;
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> position(-10, 10);
+    for(int i = 0; i < 500; i++){
+        Sphere* s = new Sphere;
+        s->setTransform(translationMatrix(position(rng), position(rng), position(rng))*scalingMatrix(0.3, 0.3, 0.3));
+        g->appendShape(s);
+        spheres.push_back(s);
+    }
+    Plane* p = new Plane;
+    p->setTransform(translationMatrix(0, -11, 0));
+    g->appendShape(p);
+    spheres.push_back(p);
+    g->buildBVH();
+
+    std::uniform_real_distribution<float> dist(-0.6, 0.6);
+    for(int i = 0; i < 100; i++){
+        Ray r(Point(0, 0, -20), Vector(dist(rng), dist(rng), 1));
+        std::vector<Intersection> expected;
+        for(Shape* s : spheres){
+            std::vector<Intersection> temp = s->findIntersections(r);
+            expected.insert(expected.end(), temp.begin(), temp.end());
+        }
+        std::sort(expected.begin(), expected.end(), compareIntersections);
+
+        std::vector<Intersection> result = g->findIntersections(r);
+        ASSERT_EQ(result.size(), expected.size());
+        for(int j = 0; j < result.size(); j++){
+            EXPECT_EQ(result.at(j).getTime(), expected.at(j).getTime());
+        }
+    }
+}
+
+// Every primitive should be in exactly one leaf child and every child box should contain what is below it
+template<int N>
+static void checkWideNode(const std::vector<WideNode<N>> &nodes, const BVH &bvh, const std::vector<BoundingBox> &boxes, int index, BoundingBox parent, std::vector<int> &seen){
+    const WideNode<N> &n = nodes.at(index);
+    EXPECT_GE(n.size, 1);
+    EXPECT_LE(n.size, N);
+    for(int i = 0; i < n.size; i++){
+        BoundingBox childBox(Point(n.bounds[0][i], n.bounds[1][i], n.bounds[2][i]), Point(n.bounds[3][i], n.bounds[4][i], n.bounds[5][i]));
+        EXPECT_TRUE(parent.containsPoint(childBox.min));
+        EXPECT_TRUE(parent.containsPoint(childBox.max));
+        if(n.count[i] > 0){
+            for(int j = 0; j < n.count[i]; j++){
+                int p = bvh.getOrder().at(n.child[i] + j);
+                seen.at(p)++;
+                EXPECT_TRUE(childBox.containsPoint(boxes.at(p).min));
+                EXPECT_TRUE(childBox.containsPoint(boxes.at(p).max));
+            }
+        }else{
+            checkWideNode(nodes, bvh, boxes, n.child[i], childBox, seen);
+        }
+    }
+}
+
+TEST(BVHTest, WideNodesCollapseBinaryTree){
+    std::vector<BoundingBox> boxes = randomBoxes(1000);
+    BoundingBox all;
+    for(const BoundingBox &b : boxes){
+        all.add(b);
+    }
+
+    BVH bvh4;
+    bvh4.build(boxes, 4);
+    EXPECT_EQ(bvh4.getWidth(), 4);
+    EXPECT_TRUE(bvh4.getNodes().empty());
+    std::vector<int> seen(boxes.size(), 0);
+    checkWideNode(bvh4.getWideNodes4(), bvh4, boxes, 0, all, seen);
+    for(int count : seen){
+        EXPECT_EQ(count, 1);
+    }
+
+    BVH bvh8;
+    bvh8.build(boxes, 8);
+    EXPECT_FALSE(bvh8.isEmpty());
+    EXPECT_LT(bvh8.getWideNodes8().size(), bvh4.getWideNodes4().size());
+    seen.assign(boxes.size(), 0);
+    checkWideNode(bvh8.getWideNodes8(), bvh8, boxes, 0, all, seen);
+    for(int count : seen){
+        EXPECT_EQ(count, 1);
+    }
+
+    EXPECT_THROW(bvh8.build(boxes, 3), std::invalid_argument);
+}
+
+// Every width should visit the same primitives and find the same closest box
+TEST(BVHTest, WideTraversalMatchesBinary){
+    std::vector<BoundingBox> boxes = randomBoxes(2000);
+    BVH bvhs[3];
+    bvhs[0].build(boxes, 2);
+    bvhs[1].build(boxes, 4);
+    bvhs[2].build(boxes, 8);
+
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> dist(-1, 1);
+    for(int i = 0; i < 200; i++){
+        // Some rays are parallel to an axis
+        Vector d = i % 10 == 0 ? Vector(0, 0, 1) : Vector(dist(rng), dist(rng), 1).normalize();
+        Ray r(Point(dist(rng)*5, dist(rng)*5, -20), d);
+
+        std::set<int> visited[3];
+        float closest[3];
+        for(int b = 0; b < 3; b++){
+            bvhs[b].traverse(r, -INFINITY, INFINITY, [&](int p, float tmax){
+                visited[b].insert(p);
+                return tmax;
+            });
+
+            closest[b] = INFINITY;
+            bvhs[b].traverse(r, 0, INFINITY, [&](int p, float tmax){
+                // Uses the time the ray enters the box as the hit
+                float t0 = (boxes.at(p).min.x - r.getOrigin().x)/r.getDirection().x;
+                float t1 = (boxes.at(p).max.x - r.getOrigin().x)/r.getDirection().x;
+                float t2 = (boxes.at(p).min.y - r.getOrigin().y)/r.getDirection().y;
+                float t3 = (boxes.at(p).max.y - r.getOrigin().y)/r.getDirection().y;
+                float t4 = (boxes.at(p).min.z - r.getOrigin().z)/r.getDirection().z;
+                float t5 = (boxes.at(p).max.z - r.getOrigin().z)/r.getDirection().z;
+                float t = std::max({std::min(t0, t1), std::min(t2, t3), std::min(t4, t5)});
+                float exit = std::min({std::max(t0, t1), std::max(t2, t3), std::max(t4, t5)});
+                if(std::isnan(t) || t > exit || t < 0){
+                    return tmax;
+                }
+                closest[b] = std::min(closest[b], t);
+                return std::min(t, tmax);
+            });
+        }
+
+        for(int p = 0; p < boxes.size(); p++){
+            if(boxes.at(p).intersects(r)){
+                EXPECT_EQ(visited[1].count(p), 1);
+                EXPECT_EQ(visited[2].count(p), 1);
+            }
+        }
+        EXPECT_EQ(closest[0], closest[1]);
+        EXPECT_EQ(closest[0], closest[2]);
+    }
+}
+
+// Every ray of a packet should reach the same primitives as when it is traversed on its own, at every width
+TEST(BVHTest, PacketTraversalMatchesSingleRays){
+    std::vector<BoundingBox> boxes = randomBoxes(2000);
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<float> dist(-1, 1);
+    for(int width : {2, 4, 8}){
+        BVH bvh;
+        bvh.build(boxes, width);
+        for(int i = 0; i < 100; i++){
+            Point from(dist(rng)*5, dist(rng)*5, -20);
+            Ray rays[PACKET_SIZE];
+            for(int j = 0; j < PACKET_SIZE; j++){
+                rays[j] = Ray(from, Vector(dist(rng)*0.2, dist(rng)*0.2, 1).normalize());
+            }
+
+            float tmax[PACKET_SIZE];
+            std::fill(tmax, tmax + PACKET_SIZE, INFINITY);
+            std::set<int> visited[PACKET_SIZE];
+            bvh.traversePacket(RayPacket(rays), PACKET_ALL, -INFINITY, tmax, [&](int p, int lanes){
+                for(int j = 0; j < PACKET_SIZE; j++){
+                    if(lanes & (1 << j)){
+                        visited[j].insert(p);
+                    }
+                }
+            });
+
+            for(int j = 0; j < PACKET_SIZE; j++){
+                std::set<int> expected;
+                bvh.traverse(rays[j], -INFINITY, INFINITY, [&](int p, float tmax){
+                    expected.insert(p);
+                    return tmax;
+                });
+                EXPECT_EQ(visited[j], expected);
+            }
+        }
+    }
+}
+
+// A ray parallel to an axis that starts exactly on a face gets a NaN slab bound(0*infinity), which must leave that axis
+// unconstrained instead of culling the box in the scalar, SSE and AVX kernels
+TEST(BVHTest, RayParallelToAndOnAFaceHitsTheBox){
+    std::vector<BoundingBox> boxes;
+    for(int i = 0; i < 16; i++){
+        boxes.push_back(BoundingBox(Point(i, 0, 0), Point(i + 1, 1, 1)));
+    }
+    Ray rays[PACKET_SIZE] = {Ray(Point(-1, 0, 0.5), Vector(1, 0, 0)), Ray(Point(-1, 1, 0.5), Vector(1, 0, 0)),
+                             Ray(Point(-1, 0.5, 0), Vector(1, 0, 0)), Ray(Point(-1, 0, 1), Vector(1, 0, 0))};
+    for(int width : {2, 4, 8}){
+        BVH bvh;
+        bvh.build(boxes, width);
+        for(int j = 0; j < PACKET_SIZE; j++){
+            std::set<int> visited;
+            bvh.traverse(rays[j], 0, INFINITY, [&](int p, float tmax){
+                visited.insert(p);
+                return tmax;
+            });
+            EXPECT_EQ(visited.size(), boxes.size()) << "width " << width << " ray " << j;
+        }
+
+        float tmax[PACKET_SIZE];
+        std::fill(tmax, tmax + PACKET_SIZE, INFINITY);
+        std::set<int> visited[PACKET_SIZE];
+        bvh.traversePacket(RayPacket(rays), PACKET_ALL, 0, tmax, [&](int p, int lanes){
+            for(int j = 0; j < PACKET_SIZE; j++){
+                if(lanes & (1 << j)){
+                    visited[j].insert(p);
+                }
+            }
+        });
+        for(int j = 0; j < PACKET_SIZE; j++){
+            EXPECT_EQ(visited[j].size(), boxes.size()) << "width " << width << " packet lane " << j;
+        }
+    }
+}
+
+// Number of primitives under node i of a binary tree
+static int subtreeSize(const BVH &bvh, int i){
+    const BVH::Node &n = bvh.getNodes().at(i);
+    return n.count > 0 ? n.count : subtreeSize(bvh, i + 1) + subtreeSize(bvh, n.offset);
+}
+
+// Only nodes with more than minLeafSize primitives are split, and leaf traversal visits the primitives of each leaf once
+TEST(BVHTest, MinLeafSizeAndLeafTraversal){
+    std::vector<BoundingBox> boxes = randomBoxes(1000);
+    BVH bvh;
+    bvh.build(boxes, 2, BVH_MAX_LEAF_SIZE);
+    for(int i = 0; i < bvh.getNodes().size(); i++){
+        if(bvh.getNodes().at(i).count == 0){
+            EXPECT_GT(subtreeSize(bvh, i), BVH_MAX_LEAF_SIZE);
+        }
+    }
+    EXPECT_THROW(bvh.build(boxes, 2, 0), std::invalid_argument);
+    EXPECT_THROW(bvh.build(boxes, 2, BVH_MAX_LEAF_SIZE + 1), std::invalid_argument);
+
+    BVH wide;
+    wide.build(boxes, 8, BVH_MAX_LEAF_SIZE);
+    Ray r(Point(0, 0, -20), Vector(0.1, 0.2, 1).normalize());
+    std::set<int> visited;
+    wide.traverseLeaves(r, -INFINITY, INFINITY, [&](int first, int count, float tmax){
+        EXPECT_LE(count, BVH_MAX_LEAF_SIZE);
+        for(int i = 0; i < count; i++){
+            EXPECT_EQ(visited.count(wide.getOrder().at(first + i)), 0);
+            visited.insert(wide.getOrder().at(first + i));
+        }
+        return tmax;
+    });
+    for(int p = 0; p < boxes.size(); p++){
+        if(boxes.at(p).intersects(r)){
+            EXPECT_EQ(visited.count(p), 1);
+        }
+    }
+}
@@ -31,6 +31,30 @@ TEST(CameraTest, RayToPixelTest){
     EXPECT_TRUE(r.getDirection().isEqual(Vector(sqrt(2)/2, 0, -sqrt(2)/2)));
 }
 
+TEST(CameraTest, RaysForTileMatchRayToPixel){
+    Camera c(201, 101, PI/2);
+    c.setTransform(yRotationMatrix(PI/4)*translationMatrix(0, -2, 5));
+    std::vector<Ray> rays;
+
+    c.raysForTile(96, 48, 8, 4, rays);
+    EXPECT_EQ(rays.size(), 32);
+    for(int j = 0; j < 4; j++){
+        for(int i = 0; i < 8; i++){
+            Ray r = c.rayToPixel(96 + i, 48 + j);
+            EXPECT_TRUE(rays.at(j*8 + i).getOrigin().isEqual(r.getOrigin()));
+            EXPECT_TRUE(rays.at(j*8 + i).getDirection().isEqual(r.getDirection()));
+        }
+    }
+    EXPECT_TRUE(rays.at(2*8 + 4).getOrigin().isEqual(Point(0, 2, -5)));
+    EXPECT_TRUE(rays.at(2*8 + 4).getDirection().isEqual(Vector(sqrt(2)/2, 0, -sqrt(2)/2)));
+
+    // Scanline
+    c.raysForTile(0, 0, 201, 1, rays);
+    EXPECT_EQ(rays.size(), 201);
+    EXPECT_TRUE(rays.at(200).getDirection().isEqual(c.rayToPixel(200, 0).getDirection()));
+    EXPECT_THROW(c.rayToPixel(201, 0), std::invalid_argument);
+}
+
 TEST(CameraTest, RenderTest){
     World w = defaultWorld();
     Camera c(11, 11, PI/2);
@@ -42,4 +66,26 @@ TEST(CameraTest, RenderTest){
     Canvas image = c.render(w);
     Colour a = image.pixelColour(5, 5);
     EXPECT_TRUE(a.isEqual(Colour(0.38066, 0.47583, 0.2855)));
-}
\ No newline at end of file
+}
+
+TEST(CameraTest, ParallelRenderMatchesSerialRender){
+    World w = defaultWorld();
+    Plane *floor = new Plane;
+    floor->setTransform(translationMatrix(0, -1, 0));
+    w.appendObject(floor);
+
+    Camera c(37, 23, PI/2);
+    c.setTransform(viewTransformationMatrix(Point(0, 1, -5), Point(), Vector(0, 1, 0)));
+
+    Canvas serial = c.render(w, 1);
+    Canvas parallel = c.render(w, 4);
+    for(int y = 0; y < 23; y++){
+        for(int x = 0; x < 37; x++){
+            Colour a = serial.pixelColour(x, y);
+            Colour b = parallel.pixelColour(x, y);
+            EXPECT_EQ(a.r, b.r);
+            EXPECT_EQ(a.g, b.g);
+            EXPECT_EQ(a.b, b.b);
+        }
+    }
+}
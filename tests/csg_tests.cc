@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 #include "CSG.h"
+#include "Group.h"
 
 TEST(CSGTest, BasicTest){
     Sphere* l = new Sphere;
@@ -129,4 +130,61 @@ TEST(CSGTest, childIntersectionsRayHitsCSGTest){
     EXPECT_TRUE(result.at(0).getShape()->isEqual(s1));
     EXPECT_TRUE(floatIsEqual(result.at(1).getTime(), 6.5));
     EXPECT_TRUE(result.at(1).getShape()->isEqual(s2));
-}
\ No newline at end of file
+}
+
+TEST(CSGTest, CSGBoundsContainChildren){
+    Sphere* s = new Sphere;
+    Cube* c = new Cube;
+    c->setTransform(translationMatrix(2, 3, 4));
+    CSG* csg = new CSG(DIFFERENCE, s, c);
+
+    EXPECT_TRUE(csg->bounds().min.isEqual(Point(-1, -1, -1)));
+    EXPECT_TRUE(csg->bounds().max.isEqual(Point(3, 4, 5)));
+}
+
+TEST(CSGTest, childIntersectionsAppendsToBuffer){
+    Sphere* s1 = new Sphere;
+    Sphere* s2 = new Sphere;
+    s2->setTransform(translationMatrix(0, 0, 0.5));
+    CSG* csg = new CSG(UNION, s1, s2);
+    Ray r(Point(0, 0, -5), Vector(0, 0, 1));
+
+    std::vector<Intersection> buffer{Intersection(-1, s2)};
+    csg->childIntersections(r, buffer);
+
+    ASSERT_EQ(buffer.size(), 3);
+    EXPECT_EQ(buffer.at(0).getShape(), s2);
+    EXPECT_TRUE(floatIsEqual(buffer.at(1).getTime(), 4));
+    EXPECT_TRUE(floatIsEqual(buffer.at(2).getTime(), 6.5));
+}
+
+TEST(CSGTest, SubtreeIdsIdentifyLeftShapes){
+    // Identical shapes on both sides can still be told apart
+    Sphere* s1 = new Sphere;
+    Group* g = new Group;
+    Sphere* s3 = new Sphere;
+    g->appendShape(s3);
+    CSG* inner = new CSG(UNION, s1, g);
+    Sphere* s4 = new Sphere;
+    CSG* outer = new CSG(DIFFERENCE, inner, s4);
+
+    EXPECT_TRUE(outer->inLeft(inner));
+    EXPECT_TRUE(outer->inLeft(s1));
+    EXPECT_TRUE(outer->inLeft(s3));
+    EXPECT_FALSE(outer->inLeft(s4));
+    EXPECT_TRUE(inner->inLeft(s1));
+    EXPECT_FALSE(inner->inLeft(s3));
+    // The whole tree is numbered depth first from the outer CSG, so inner's left subtree is the single id after inner's
+    // and s4, numbered by outer after all of inner's subtree, falls outside that range
+    EXPECT_EQ(s1->getSubtreeId(), inner->getSubtreeId() + 1);
+    EXPECT_GT(s4->getSubtreeId(), s3->getSubtreeId());
+    EXPECT_FALSE(inner->inLeft(s4));
+
+    // Shapes added to a group after the CSG was made are numbered too
+    Sphere* s5 = new Sphere;
+    g->appendShape(s5);
+    EXPECT_TRUE(outer->inLeft(s5));
+    EXPECT_FALSE(inner->inLeft(s5));
+    EXPECT_FALSE(outer->inLeft(s4));
+    EXPECT_NE(s5->getSubtreeId(), s4->getSubtreeId());
+}
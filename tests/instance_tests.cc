@@ -0,0 +1,195 @@
+#include <gtest/gtest.h>
+#include "Instance.h"
+#include "Group.h"
+#include "CSG.h"
+#include "World.h"
+#include "LightData.h"
+
+// Group with a sphere at x = 2 and a cube at x = -2
+static Group* prototypeGroup(){
+    Group* g = new Group;
+    Sphere* s = new Sphere;
+    s->setTransform(translationMatrix(2, 0, 0));
+    Cube* c = new Cube;
+    c->setTransform(translationMatrix(-2, 0, 0));
+    g->appendShape(s);
+    g->appendShape(c);
+    return g;
+}
+
+TEST(InstanceTest, InvalidPrototypes){
+    EXPECT_THROW(Instance(nullptr), std::invalid_argument);
+
+    Group g;
+    Sphere* s = new Sphere;
+    g.appendShape(s);
+    EXPECT_THROW(Instance i(s), std::invalid_argument);
+
+    Group* outer = new Group;
+    outer->appendShape(new Instance(prototypeGroup()));
+    EXPECT_THROW(Instance i(outer), std::invalid_argument);
+}
+
+// An instance should act exactly like a copy of the prototype placed with the instance's transform
+TEST(InstanceTest, MatchesTransformedCopy){
+    Group* prototype = prototypeGroup();
+    Matrix4 transform = translationMatrix(0, 0, 5)*yRotationMatrix(PI/3)*scalingMatrix(2, 1, 1);
+    Instance instance(prototype);
+    instance.setTransform(transform);
+    Instance other(prototype);
+    other.setTransform(translationMatrix(0, 10, 0));
+
+    Group* copy = prototypeGroup();
+    copy->setTransform(transform);
+
+    for(int i = -6; i <= 6; i++){
+        Ray r(Point(i, 0, -20), Vector(0, 0, 1));
+        std::vector<Intersection> instanceHits = instance.findIntersections(r);
+        std::vector<Intersection> copyHits = copy->findIntersections(r);
+        ASSERT_EQ(instanceHits.size(), copyHits.size());
+        for(int j = 0; j < instanceHits.size(); j++){
+            EXPECT_TRUE(floatIsEqual(instanceHits.at(j).getTime(), copyHits.at(j).getTime()));
+            EXPECT_EQ(instanceHits.at(j).getInstance(), &instance);
+            EXPECT_EQ(instanceHits.at(j).getShape()->getParent(), prototype);
+        }
+
+        Intersection instanceHit(0, nullptr);
+        Intersection copyHit(0, nullptr);
+        ASSERT_EQ(instance.findClosestHit(r, 0, INFINITY, instanceHit), copy->findClosestHit(r, 0, INFINITY, copyHit));
+        if(copyHit.getShape() != nullptr){
+            EXPECT_EQ(instanceHit.getInstance(), &instance);
+            Point p = r.computePosition(copyHit.getTime());
+            EXPECT_TRUE(instanceHit.getShape()->computeNormal(p, instanceHit).isEqual(copyHit.getShape()->computeNormal(p, copyHit)));
+        }
+        EXPECT_EQ(instance.isOccluded(r, INFINITY), copy->isOccluded(r, INFINITY));
+    }
+
+    // The second instance is somewhere else
+    EXPECT_EQ(other.findIntersections(Ray(Point(2, 0, -20), Vector(0, 0, 1))).size(), 0);
+    EXPECT_EQ(other.findIntersections(Ray(Point(2, 10, -20), Vector(0, 0, 1))).size(), 2);
+    EXPECT_TRUE(other.bounds().min.isEqual(Point(-3, -1, -1)));
+    EXPECT_TRUE(other.parentSpaceBounds().max.isEqual(Point(3, 11, 1)));
+}
+
+TEST(InstanceTest, MaterialOverride){
+    Sphere* prototype = new Sphere;
+    Material red;
+    red.colour = Colour(1, 0, 0);
+    prototype->setMaterial(red);
+
+    Instance plain(prototype);
+    Instance blue(prototype);
+    Material m;
+    m.colour = Colour(0, 0, 1);
+    blue.setMaterialOverride(m);
+    EXPECT_TRUE(blue.hasMaterialOverride());
+
+    Ray r(Point(0, 0, -5), Vector(0, 0, 1));
+    EXPECT_TRUE(plain.findIntersections(r).at(0).getMaterial().colour.isEqual(Colour(1, 0, 0)));
+    EXPECT_TRUE(blue.findIntersections(r).at(0).getMaterial().colour.isEqual(Colour(0, 0, 1)));
+    LightData data = prepareLightData(blue.findIntersections(r).at(0), r);
+    EXPECT_TRUE(data.getMaterial().colour.isEqual(Colour(0, 0, 1)));
+
+    // Shadows follow the override
+    m.castsShadow = false;
+    blue.setMaterialOverride(m);
+    EXPECT_TRUE(plain.isOccluded(r, INFINITY));
+    EXPECT_FALSE(blue.isOccluded(r, INFINITY));
+
+    blue.clearMaterialOverride();
+    EXPECT_FALSE(blue.hasMaterialOverride());
+    EXPECT_TRUE(blue.findIntersections(r).at(0).getMaterial().colour.isEqual(Colour(1, 0, 0)));
+}
+
+TEST(InstanceTest, RenderedInWorld){
+    World w = defaultWorld();
+    Group* prototype = prototypeGroup();
+    Instance* i = new Instance(prototype);
+    i->setTransform(translationMatrix(0, 0, 10));
+    w.appendObject(i);
+
+    // Hits the sphere in the prototype placed behind the default world
+    Ray r(Point(2, 0, -5), Vector(0, 0, 1));
+    Intersection hit(0, nullptr);
+    EXPECT_TRUE(w.findClosestHit(r, 0, INFINITY, hit));
+    EXPECT_EQ(hit.getInstance(), i);
+    EXPECT_TRUE(floatIsEqual(hit.getTime(), 14));
+
+    LightData data = prepareLightData(hit, r);
+    EXPECT_TRUE(data.normal.isEqual(Vector(0, 0, -1)));
+    EXPECT_TRUE(w.colourAtHit(r).isEqual(w.shadeHit(data)));
+
+    // Changing the prototype changes every instance of it
+    prototype->getShapes().at(0)->setTransform(translationMatrix(0, 0, 1));
+    EXPECT_FALSE(w.isCommitted());
+}
+
+// Many instances share one committed prototype, including instances in a CSG which have no leaves to record it into
+TEST(InstanceTest, SharedPrototypeIsCommitted){
+    Group* prototype = prototypeGroup();
+    World w;
+    for(int i = 0; i < 10; i++){
+        Instance* instance = new Instance(prototype);
+        instance->setTransform(translationMatrix(0, 3*i, 0));
+        w.appendObject(instance);
+    }
+    w.commit();
+    EXPECT_TRUE(prototype->isCommitted());
+    EXPECT_TRUE(prototype->getShapes().at(0)->isCommitted());
+
+    Ray r(Point(2, 27, -5), Vector(0, 0, 1));
+    Intersection hit(0, nullptr);
+    EXPECT_TRUE(w.findClosestHit(r, 0, INFINITY, hit));
+    EXPECT_EQ(hit.getInstance(), w.getObjects().at(9));
+    EXPECT_TRUE(floatIsEqual(hit.getTime(), 4));
+
+    Sphere* sphere = new Sphere;
+    Instance* inCSG = new Instance(sphere);
+    inCSG->setTransform(translationMatrix(0, -10, 0));
+    w.appendObject(new CSG(UNION, inCSG, new Cube));
+    w.commit();
+    EXPECT_TRUE(sphere->isCommitted());
+    r = Ray(Point(0, -10, -5), Vector(0, 0, 1));
+    EXPECT_TRUE(w.findClosestHit(r, 0, INFINITY, hit));
+    EXPECT_TRUE(floatIsEqual(hit.getTime(), 4));
+}
+
+// The prototype is baked relative to itself, so it can not also be placed in the world directly or in a group
+TEST(InstanceTest, PrototypeCanNotAlsoBeInTheWorld){
+    Group* prototype = prototypeGroup();
+    World w;
+    w.appendObject(new Instance(prototype));
+    w.appendObject(prototype);
+    EXPECT_THROW(w.commit(), std::invalid_argument);
+    EXPECT_FALSE(w.isCommitted());
+
+    w.setObjects({w.getObjects().at(0)});
+    Group* g = new Group;
+    g->appendShape(prototype);
+    w.appendObject(g);
+    EXPECT_THROW(w.commit(), std::invalid_argument);
+}
+
+// The same shape hit through two instances is two different objects for refraction
+TEST(InstanceTest, RefractiveIndicesSeparateInstances){
+    Sphere* prototype = glassSphere();
+    Instance a(prototype);
+    a.setTransform(scalingMatrix(2, 2, 2));
+    Material m = glassSphere()->getMaterial();
+    m.refractiveIndex = 2.0;
+    Instance b(prototype);
+    b.setMaterialOverride(m);
+
+    Ray r(Point(0, 0, -4), Vector(0, 0, 1));
+    std::vector<Intersection> xs = a.findIntersections(r);
+    std::vector<Intersection> inner = b.findIntersections(r);
+    xs.insert(xs.end(), inner.begin(), inner.end());
+    mergeIntersections(xs, 0, 2);
+
+    LightData data = prepareLightData(xs, 1, r);
+    EXPECT_TRUE(floatIsEqual(data.n1, 1.5));
+    EXPECT_TRUE(floatIsEqual(data.n2, 2.0));
+    data = prepareLightData(xs, 2, r);
+    EXPECT_TRUE(floatIsEqual(data.n1, 2.0));
+    EXPECT_TRUE(floatIsEqual(data.n2, 1.5));
+}
@@ -3,6 +3,8 @@
 #include "Shape.h"
 #include "common.h"
 #include "Intersection.h"
+#include <random>
+#include <algorithm>
 
 TEST(IntersectionTest, BasicTest){
     Sphere* s = new Sphere;
@@ -58,4 +60,65 @@ TEST(IntersectionTest, FindingHits){
     ind = hit(intersects);
     EXPECT_EQ(ind, 3);
     delete s;
-}
\ No newline at end of file
+}
+
+TEST(IntersectionTest, mergeIntersections){
+    std::vector<Intersection> intersects{Intersection(-7, nullptr), Intersection(1, nullptr), Intersection(4, nullptr), Intersection(9, nullptr),
+        Intersection(-2, nullptr), Intersection(4, nullptr), Intersection(5, nullptr)};
+
+    // Everything before start is left alone
+    mergeIntersections(intersects, 1, 4);
+    std::vector<float> expected{-7, -2, 1, 4, 4, 5, 9};
+    ASSERT_EQ(intersects.size(), expected.size());
+    for(int i = 0; i < expected.size(); i++){
+        EXPECT_EQ(intersects.at(i).getTime(), expected.at(i));
+    }
+
+    // Lists already in order and empty lists are unchanged
+    mergeIntersections(intersects, 0, 3);
+    mergeIntersections(intersects, 0, 7);
+    mergeIntersections(intersects, 2, 2);
+    for(int i = 0; i < expected.size(); i++){
+        EXPECT_EQ(intersects.at(i).getTime(), expected.at(i));
+    }
+}
+
+TEST(IntersectionTest, mergeRuns){
+    Sphere s1, s2;
+    // Runs starting at 1, 3, 3(empty) and 6, everything before the first run is left alone
+    std::vector<Intersection> intersects{Intersection(-7, nullptr), Intersection(2, &s1), Intersection(8, nullptr),
+        Intersection(-1, nullptr), Intersection(2, &s2), Intersection(3, nullptr), Intersection(0, nullptr), Intersection(9, nullptr)};
+    mergeRuns(intersects, {1, 3, 3, 6});
+    std::vector<float> expected{-7, -1, 0, 2, 2, 3, 8, 9};
+    ASSERT_EQ(intersects.size(), expected.size());
+    for(int i = 0; i < expected.size(); i++){
+        EXPECT_EQ(intersects.at(i).getTime(), expected.at(i));
+    }
+    // Equal times keep the earlier run first
+    EXPECT_EQ(intersects.at(3).getShape(), &s1);
+    EXPECT_EQ(intersects.at(4).getShape(), &s2);
+
+    // Many single hit runs in random order are sorted like std::sort
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> time(-10, 10);
+    std::vector<Intersection> single;
+    std::vector<int> runs;
+    std::vector<float> times;
+    for(int i = 0; i < 100; i++){
+        runs.push_back(single.size());
+        times.push_back(time(rng));
+        single.push_back(Intersection(times.back(), nullptr));
+    }
+    mergeRuns(single, runs);
+    std::sort(times.begin(), times.end());
+    for(int i = 0; i < times.size(); i++){
+        EXPECT_EQ(single.at(i).getTime(), times.at(i));
+    }
+
+    // Runs before firstRun belong to an outer caller and are ignored
+    std::vector<Intersection> nested{Intersection(5, nullptr), Intersection(4, nullptr), Intersection(1, nullptr)};
+    mergeRuns(nested, {0, 1, 2}, 1);
+    EXPECT_EQ(nested.at(0).getTime(), 5);
+    EXPECT_EQ(nested.at(1).getTime(), 1);
+    EXPECT_EQ(nested.at(2).getTime(), 4);
+}
@@ -57,6 +57,32 @@ TEST(MaterialTest, BasicTest){
     EXPECT_TRUE(s.getMaterial().isEqual(m));
 }
 
+TEST(MaterialTableTest, IdenticalMaterialsShareAnEntry){
+    MaterialTable table;
+    Material m;
+    m.ambient = 0.37;
+    m.colour = Colour(0.2, 0.4, 0.6);
+    int id = table.add(m);
+    EXPECT_EQ(table.add(Material()), 1);
+    EXPECT_EQ(table.add(m), id);
+    EXPECT_EQ(table.size(), 2);
+    EXPECT_TRUE(table.get(id).isEqual(m));
+
+    // References stay valid while materials are added
+    const Material &first = table.get(id);
+    for(int i = 0; i < 1000; i++){
+        m.shininess = 1000 + i;
+        table.add(m);
+    }
+    EXPECT_EQ(table.size(), 1002);
+    EXPECT_EQ(&first, &table.get(id));
+    EXPECT_TRUE(floatIsEqual(first.ambient, 0.37));
+
+    table.clear();
+    EXPECT_EQ(table.size(), 0);
+    EXPECT_EQ(table.add(m), 0);
+}
+
 // Light       Camera         ||
 TEST(LightingTest, CameraBetweenSurfaceAndLight){
     // Material of surface
@@ -335,4 +361,37 @@ TEST(LightDataTest, SchlickApproximationWhenRayHitsSurfaceAtASmallAngle){
     float reflectance = schlickApproximation(data);
 
     EXPECT_TRUE(floatIsEqual(reflectance, 0.48873));
-}
\ No newline at end of file
+}
+
+TEST(FindRefractiveIndicesTest, HitGivenByIndex){
+    Material m;
+    m.refractiveIndex = 1.5;
+    Sphere* A = glassSphere();
+    A->setMaterial(m);
+    m.refractiveIndex = 2;
+    Sphere* B = glassSphere();
+    B->setMaterial(m);
+    // Ray enters A, enters B, leaves A, enters A again and then leaves B and A
+    std::vector<Intersection> RayIntersects({Intersection(1, A), Intersection(2, B), Intersection(3, A), Intersection(4, A), Intersection(5, B), Intersection(6, A)});
+    std::vector<float> n1{1.0, 1.5, 2.0, 2.0, 1.5, 1.5};
+    std::vector<float> n2{1.5, 2.0, 2.0, 1.5, 1.5, 1.0};
+
+    for(int i = 0; i < RayIntersects.size(); i++){
+        LightData byIndex;
+        LightData byIntersection;
+        findRefractiveIndices(byIndex, i, RayIntersects);
+        findRefractiveIndices(byIntersection, RayIntersects.at(i), RayIntersects);
+
+        EXPECT_EQ(byIndex.n1, n1.at(i));
+        EXPECT_EQ(byIndex.n2, n2.at(i));
+        EXPECT_EQ(byIntersection.n1, n1.at(i));
+        EXPECT_EQ(byIntersection.n2, n2.at(i));
+    }
+}
+
+TEST(LightDataTest, DefaultLightDataDoesNotAllocate){
+    LightData data;
+    EXPECT_EQ(data.object, nullptr);
+    EXPECT_EQ(data.n1, 1);
+    EXPECT_EQ(data.n2, 1);
+}
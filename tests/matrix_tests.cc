@@ -269,4 +269,84 @@ TEST(MatrixTransformations, ChainingTest){
     Matrix transform = chainTransformationMatrices({A, B, C});
     EXPECT_TRUE((transform*p).isEqual(p4));
     EXPECT_TRUE(transform.isEqual((C*B*A)));
-}
\ No newline at end of file
+}
+
+TEST(Matrix4Tests, BasicTest){
+    // Default constructor is the identity matrix
+    Matrix4 a;
+    EXPECT_TRUE(Matrix(a).isEqual(Matrix(4)));
+
+    std::vector<std::vector<float>> v1 = {{1, 2, 3, 4}, {5.5, 6.5, 7.5, 8.5}, {9, 10, 11, 12}, {13.5, 14.5, 15.5, 16.5}};
+    Matrix4 b(Matrix(4, 4, v1));
+    EXPECT_TRUE(floatIsEqual(b.getElement(0, 3), 4));
+    EXPECT_TRUE(floatIsEqual(b.getElement(1, 2), 7.5));
+    EXPECT_TRUE(floatIsEqual(b(3, 0), 13.5));
+    EXPECT_TRUE(Matrix(b).isEqual(Matrix(4, 4, v1)));
+
+    b.setElement(2, 1, -3);
+    EXPECT_TRUE(floatIsEqual(b.getElement(2, 1), -3));
+    EXPECT_THROW(b.getElement(4, 0), std::invalid_argument);
+    EXPECT_THROW(Matrix4(Matrix(3, 3)), std::invalid_argument);
+}
+
+TEST(Matrix4Tests, OperationsMatchGenericMatrix){
+    std::vector<std::vector<float>> v1 = {{1, 2, 3, 4}, {5, 6, 7, 8}, {9, 8, 7, 6}, {5, 4, 3, 2}};
+    std::vector<std::vector<float>> v2 = {{-2, 1, 2, 3}, {3, 2, 1, -1}, {4, 3, 6, 5}, {1, 2, 7, 8}};
+    Matrix a(4, 4, v1);
+    Matrix b(4, 4, v2);
+    Matrix4 a4(a);
+    Matrix4 b4(b);
+
+    EXPECT_TRUE((a4*b4).isEqual(a*b));
+    EXPECT_TRUE(a4.transpose().isEqual(a.transpose()));
+    EXPECT_TRUE((a4*Tuple(1, 2, 3, 1)).isEqual(a*Tuple(1, 2, 3, 1)));
+}
+
+TEST(Matrix4Tests, ClosedFormInverse){
+    std::vector<std::vector<float>> v1 = {{-5, 2, 6, -8}, {1, -5, 1, 8}, {7, 7, -6, -7}, {1, -3, 7, 4}};
+    std::vector<std::vector<float>> v2 = {{0.21805, 0.45113, 0.24060, -0.04511}, {-0.80827, -1.45677, -0.44361, 0.52068}, {-0.07895, -0.22368, -0.05263, 0.19737}, {-0.52256, -0.81391, -0.30075, 0.30639}};
+    Matrix4 a(Matrix(4, 4, v1));
+    EXPECT_FALSE(a.isAffine());
+    EXPECT_TRUE(floatIsEqual(a.determinant(), 532));
+    EXPECT_TRUE(a.inverse().isEqual(Matrix(4, 4, v2)));
+}
+
+TEST(Matrix4Tests, AffineInverse){
+    Matrix4 a = chainTransformationMatrices({xRotationMatrix(PI/3), scalingMatrix(2, 0.5, 4), shearingMatrix(1, 0, 0.5, 0, 0, 2), translationMatrix(10, -5, 7)});
+    EXPECT_TRUE(a.isAffine());
+    EXPECT_TRUE(floatIsEqual(a.determinant(), Matrix(a).submatrix(3, 3).determinant()));
+    EXPECT_TRUE((a*a.inverse()).isEqual(Matrix4()));
+    EXPECT_TRUE((a.inverse()*a).isEqual(Matrix4()));
+}
+
+TEST(Matrix4Tests, NonInvertableMatrixReportedWithoutThrowing){
+    std::vector<std::vector<float>> v1 = {{-4, 2, -2, -3}, {9, 6, 2, 6}, {0, -5, 1, -5}, {0, 0, 0, 0}};
+    Matrix4 a(Matrix(4, 4, v1));
+    Matrix4 result;
+    EXPECT_FALSE(a.isInvertable());
+    EXPECT_FALSE(a.tryInverse(result));
+    EXPECT_FALSE(scalingMatrix(1, 0, 1).tryInverse(result));
+    EXPECT_THROW(a.inverse(), std::invalid_argument);
+}
+
+// Small scales have tiny determinants but are still invertable, the singularity test is relative to the size of the matrix
+TEST(Matrix4Tests, SmallScalesAreInvertable){
+    Matrix4 a = scalingMatrix(0.04, 0.04, 0.04);
+    EXPECT_TRUE(a.isInvertable());
+    EXPECT_TRUE((a*a.inverse()).isEqual(Matrix4()));
+
+    Matrix4 b = translationMatrix(1, 2, 3)*scalingMatrix(0.01, 0.02, 0.01);
+    EXPECT_TRUE(b.isInvertable());
+    EXPECT_TRUE((b*b.inverse()).isEqual(Matrix4()));
+
+    // Two equal rows are singular at any scale
+    std::vector<std::vector<float>> v1 = {{0.01, 0.02, 0.03, 0}, {0.01, 0.02, 0.03, 0}, {0, 0, 0.01, 0}, {0, 0, 0, 1}};
+    EXPECT_FALSE(Matrix4(Matrix(4, 4, v1)).isInvertable());
+    EXPECT_FALSE(Matrix(4, 4, v1).isInvertable());
+
+    // Matrix agrees with Matrix4 since its 4x4 inverse is computed by Matrix4
+    std::vector<std::vector<float>> v2 = {{0.04, 0, 0, 0}, {0, 0.04, 0, 0}, {0, 0, 0.04, 0}, {0, 0, 0, 1}};
+    Matrix c(4, 4, v2);
+    EXPECT_TRUE(c.isInvertable());
+    EXPECT_TRUE((c*c.inverse()).isEqual(Matrix(4)));
+}
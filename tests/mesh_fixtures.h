@@ -0,0 +1,27 @@
+#pragma once
+#include "Mesh.h"
+#include <random>
+#include <vector>
+
+// Grid of n by n quads in the xy plane, each split into two triangles, with the z of every vertex jittered
+// points gets every vertex in the order they were added
+inline Mesh* gridMesh(int n, std::vector<Point> &points, unsigned int seed = 3){
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> jitter(-0.3, 0.3);
+    Mesh* m = new Mesh;
+    for(int y = 0; y <= n; y++){
+        for(int x = 0; x <= n; x++){
+            points.push_back(Point(x, y, jitter(rng)));
+            m->addVertex(points.back());
+        }
+    }
+
+    for(int y = 0; y < n; y++){
+        for(int x = 0; x < n; x++){
+            int i = y*(n + 1) + x;
+            m->addTriangle(i, i + 1, i + n + 2);
+            m->addTriangle(i, i + n + 2, i + n + 1);
+        }
+    }
+    return m;
+}
\ No newline at end of file
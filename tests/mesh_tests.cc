@@ -0,0 +1,181 @@
+#include <gtest/gtest.h>
+#include "Mesh.h"
+#include "mesh_fixtures.h"
+#include "Group.h"
+#include "Shape.h"
+#include <random>
+#include <algorithm>
+
+TEST(MeshTest, BasicTest){
+    Mesh m;
+    EXPECT_EQ(m.triangleCount(), 0);
+    EXPECT_TRUE(m.bounds().isEmpty());
+
+    m.addVertex(Point(0, 1, 0));
+    m.addVertex(Point(-1, 0, 0));
+    m.addVertex(Point(1, 0, 0));
+    EXPECT_EQ(m.addVertex(Point(0, 0, 2)), 3);
+    m.addTriangle(0, 1, 2);
+    m.addTriangle(0, 2, 3);
+    EXPECT_EQ(m.triangleCount(), 2);
+    EXPECT_FALSE(m.isSmooth(0));
+    EXPECT_TRUE(m.bounds().min.isEqual(Point(-1, 0, 0)));
+    EXPECT_TRUE(m.bounds().max.isEqual(Point(1, 1, 2)));
+
+    EXPECT_THROW(m.addTriangle(0, 1, 4), std::invalid_argument);
+    EXPECT_THROW(m.addTriangle(0, 1, 2, 0, 0, 0), std::invalid_argument);
+    EXPECT_EQ(m.triangleCount(), 2);
+}
+
+TEST(MeshTest, HitStoresTriangleIndexAndUV){
+    Mesh m;
+    m.addVertex(Point(0, 1, 0));
+    m.addVertex(Point(-1, 0, 0));
+    m.addVertex(Point(1, 0, 0));
+    m.addVertex(Point(0, -1, 0));
+    m.addTriangle(0, 1, 2);
+    m.addTriangle(1, 3, 2);
+
+    Intersection hit(0, nullptr);
+    EXPECT_TRUE(m.findClosestHit(Ray(Point(0.2, -0.3, -2), Vector(0, 0, 1)), 0, INFINITY, hit));
+    EXPECT_EQ(hit.getShape(), &m);
+    EXPECT_EQ(hit.getIndex(), 1);
+    EXPECT_TRUE(floatIsEqual(hit.getTime(), 2));
+
+    Triangle t(Point(-1, 0, 0), Point(0, -1, 0), Point(1, 0, 0));
+    std::vector<Intersection> xs = m.findIntersections(Ray(Point(0.2, -0.3, -2), Vector(0, 0, 1)));
+    ASSERT_EQ(xs.size(), 1);
+    EXPECT_EQ(xs.at(0).getIndex(), 1);
+    EXPECT_TRUE(floatIsEqual(xs.at(0).getU(), hit.getU()));
+    EXPECT_TRUE(floatIsEqual(xs.at(0).getV(), hit.getV()));
+    EXPECT_TRUE(m.computeNormal(Point(0.2, -0.3, 0), hit).isEqual(t.computeNormal(Point(0.2, -0.3, 0))));
+
+    EXPECT_FALSE(m.findClosestHit(Ray(Point(2, 2, -2), Vector(0, 0, 1)), 0, INFINITY, hit));
+    EXPECT_TRUE(m.isOccluded(Ray(Point(0, 0.5, -2), Vector(0, 0, 1)), 3));
+    EXPECT_FALSE(m.isOccluded(Ray(Point(0, 0.5, -2), Vector(0, 0, 1)), 1));
+}
+
+TEST(MeshTest, SmoothTrianglesInterpolateNormals){
+    Mesh m;
+    m.addVertex(Point(0, 1, 0));
+    m.addVertex(Point(-1, 0, 0));
+    m.addVertex(Point(1, 0, 0));
+    m.addNormal(Vector(0, 1, 0));
+    m.addNormal(Vector(-1, 0, 0));
+    m.addNormal(Vector(1, 0, 0));
+    m.addTriangle(0, 1, 2, 0, 1, 2);
+    EXPECT_TRUE(m.isSmooth(0));
+
+    SmoothTriangle t(Point(0, 1, 0), Point(-1, 0, 0), Point(1, 0, 0), Vector(0, 1, 0), Vector(-1, 0, 0), Vector(1, 0, 0));
+    Intersection i(1, &m, 0.45, 0.25, 0);
+    Intersection j(1, &t, 0.45, 0.25);
+    EXPECT_TRUE(m.computeNormal(Point(0, 0, 0), i).isEqual(t.computeNormal(Point(0, 0, 0), j)));
+    EXPECT_THROW(m.computeNormal(Point(0, 0, 0), Intersection(1, &m)), std::invalid_argument);
+}
+
+// The mesh should find exactly what a group of separate triangles finds
+TEST(MeshTest, MatchesGroupOfTriangles){
+    std::vector<Point> points;
+    Mesh* m = gridMesh(20, points);
+    m->setTransform(scalingMatrix(0.5, 0.5, 0.5));
+    Group g;
+    g.setTransform(scalingMatrix(0.5, 0.5, 0.5));
+    const std::vector<int> &indices = m->getIndices();
+    for(int i = 0; i < indices.size(); i += 3){
+        g.appendShape(new Triangle(points.at(indices.at(i)), points.at(indices.at(i + 1)), points.at(indices.at(i + 2))));
+    }
+
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<float> position(-1, 11);
+    for(int i = 0; i < 200; i++){
+        Point from(position(rng), position(rng), -5);
+        Point to(position(rng), position(rng), 5);
+        Ray r(from, Vector(to - from).normalize());
+
+        std::vector<Intersection> meshHits = m->findIntersections(r);
+        std::vector<Intersection> groupHits = g.findIntersections(r);
+        ASSERT_EQ(meshHits.size(), groupHits.size());
+        for(int j = 0; j < meshHits.size(); j++){
+            EXPECT_TRUE(floatIsEqual(meshHits.at(j).getTime(), groupHits.at(j).getTime()));
+        }
+
+        Intersection meshHit(0, nullptr);
+        Intersection groupHit(0, nullptr);
+        ASSERT_EQ(m->findClosestHit(r, 0, INFINITY, meshHit), g.findClosestHit(r, 0, INFINITY, groupHit));
+        if(groupHit.getShape() != nullptr){
+            EXPECT_TRUE(floatIsEqual(meshHit.getTime(), groupHit.getTime()));
+            Point p = r.computePosition(meshHit.getTime());
+            EXPECT_TRUE(m->computeNormal(p, meshHit).isEqual(groupHit.getShape()->computeNormal(p, groupHit)));
+        }
+    }
+    delete m;
+}
+
+// Blocks of triangles, including the padded last block, should find every triangle intersectTriangle finds with the same u and v
+TEST(MeshTest, BlocksMatchSingleTriangles){
+    Mesh m;
+    std::mt19937 rng(13);
+    std::uniform_real_distribution<float> position(-2, 2);
+    int count = 37;
+    for(int i = 0; i < 3*count; i++){
+        m.addVertex(Point(position(rng), position(rng), position(rng)));
+    }
+    for(int i = 0; i < count; i++){
+        m.addTriangle(3*i, 3*i + 1, 3*i + 2);
+    }
+    const std::vector<Point> &vertices = m.getVertices();
+
+    for(int i = 0; i < 200; i++){
+        Point from(position(rng), position(rng), -5);
+        Point to(position(rng), position(rng), 5);
+        Ray r(from, Vector(to - from).normalize());
+
+        std::vector<Intersection> expected;
+        for(int j = 0; j < count; j++){
+            float t, u, v;
+            if(Triangle::intersectTriangle(r, vertices[3*j], vertices[3*j + 1] - vertices[3*j], vertices[3*j + 2] - vertices[3*j], t, u, v)){
+                expected.push_back(Intersection(t, &m, u, v, j));
+            }
+        }
+        std::sort(expected.begin(), expected.end(), [](const Intersection &a, const Intersection &b){
+            return a.getTime() < b.getTime();
+        });
+
+        std::vector<Intersection> hits = m.findIntersections(r);
+        ASSERT_EQ(hits.size(), expected.size());
+        for(int j = 0; j < hits.size(); j++){
+            EXPECT_EQ(hits.at(j).getIndex(), expected.at(j).getIndex());
+            EXPECT_TRUE(floatIsEqual(hits.at(j).getTime(), expected.at(j).getTime()));
+            EXPECT_TRUE(floatIsEqual(hits.at(j).getU(), expected.at(j).getU()));
+            EXPECT_TRUE(floatIsEqual(hits.at(j).getV(), expected.at(j).getV()));
+        }
+
+        // The ray starts at z = -5 so only hits in front of it count for the closest hit and shadows
+        int first = 0;
+        while(first < expected.size() && expected.at(first).getTime() < 0){
+            first++;
+        }
+        Intersection hit(0, nullptr);
+        ASSERT_EQ(m.findClosestHit(r, 0, INFINITY, hit), first < expected.size());
+        EXPECT_EQ(m.isOccluded(r, INFINITY), first < expected.size());
+        if(first < expected.size()){
+            EXPECT_EQ(hit.getIndex(), expected.at(first).getIndex());
+            EXPECT_TRUE(floatIsEqual(hit.getTime(), expected.at(first).getTime()));
+            EXPECT_TRUE(floatIsEqual(hit.getU(), expected.at(first).getU()));
+            EXPECT_TRUE(floatIsEqual(hit.getV(), expected.at(first).getV()));
+            EXPECT_EQ(m.isOccluded(r, expected.at(first).getTime()), false);
+        }
+    }
+}
+
+TEST(MeshTest, MeshInGroupUpdatesGroupBounds){
+    Group g;
+    Mesh* m = new Mesh;
+    g.appendShape(m);
+    m->addVertex(Point(0, 0, 0));
+    m->addVertex(Point(1, 0, 0));
+    m->addVertex(Point(0, 4, 0));
+    m->addTriangle(0, 1, 2);
+    EXPECT_TRUE(g.bounds().max.isEqual(Point(1, 4, 0)));
+    EXPECT_EQ(g.findIntersections(Ray(Point(0.2, 3, -1), Vector(0, 0, 1))).size(), 1);
+}
@@ -124,4 +124,23 @@ TEST(ObjParserTest, FaceRecordsCorrectlyParsedWithVertexNormals){
     EXPECT_TRUE(t2->getN1().isEqual(parser.normals.at(2)));
     EXPECT_TRUE(t2->getN2().isEqual(parser.normals.at(0)));
     EXPECT_TRUE(t2->getN3().isEqual(parser.normals.at(1)));
-}
\ No newline at end of file
+}
+
+TEST(ObjParser_ObjToMeshTest, FacesAreAddedToOneMesh){
+    ObjParser parser("v 0 1 0\nv -1 0 0\nv 1 0 0\nv 0 2 0\n\nvn -1 0 0\nvn 1 0 0\nvn 0 1 0\n\ng First\nf 1//3 2//1 3//2\ng Second\nf 1 3 4 2", false, true);
+    Mesh* m = parser.objToMesh();
+
+    EXPECT_EQ(parser.vertices.size(), 0);
+    EXPECT_EQ(parser.groups.at(0)->getShapes().size(), 0);
+    EXPECT_EQ(m->getVertices().size(), 4);
+    EXPECT_EQ(m->getNormals().size(), 3);
+    EXPECT_EQ(m->triangleCount(), 3);
+    EXPECT_TRUE(m->isSmooth(0));
+    EXPECT_FALSE(m->isSmooth(1));
+    EXPECT_EQ(m->getIndices(), std::vector<int>({0, 1, 2, 0, 2, 3, 0, 3, 1}));
+    EXPECT_TRUE(m->getVertices().at(3).isEqual(Point(0, 2, 0)));
+
+    ObjParser groupParser("v 0 1 0\nv -1 0 0\nv 1 0 0\nf 1 2 3", false);
+    EXPECT_THROW(groupParser.objToMesh(), std::invalid_argument);
+    delete m;
+}
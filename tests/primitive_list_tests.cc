@@ -0,0 +1,102 @@
+#include <gtest/gtest.h>
+#include "PrimitiveList.h"
+#include "Shape.h"
+#include "Group.h"
+#include <random>
+#include <algorithm>
+
+// Sphere that is twice as big, the list should keep calling its own functions
+class BigSphere : public Sphere{
+public:
+    bool childClosestHit(Ray r, float tmin, float tmax, Intersection &hit){
+        Ray scaled = r.transform(scalingMatrix(0.5, 0.5, 0.5));
+        return Sphere::childClosestHit(scaled, tmin, tmax, hit);
+    }
+};
+
+TEST(PrimitiveListTest, SortsShapesByType){
+    PrimitiveList list;
+    std::vector<Shape*> shapes = {new Sphere, new Triangle(Point(0, 1, 0), Point(-1, 0, 0), Point(1, 0, 0)), new Plane, new Cube,
+                                  new SmoothTriangle(Point(0, 1, 0), Point(-1, 0, 0), Point(1, 0, 0), Vector(0, 1, 0), Vector(-1, 0, 0), Vector(1, 0, 0)),
+                                  new Cylinder, new Sphere, new BigSphere, new Group};
+    for(int i = 0; i < shapes.size(); i++){
+        list.add(shapes[i], Matrix4());
+    }
+
+    PrimitiveList::Type types[] = {PrimitiveList::SPHERE, PrimitiveList::TRIANGLE, PrimitiveList::PLANE, PrimitiveList::CUBE,
+                                   PrimitiveList::SMOOTH_TRIANGLE, PrimitiveList::OTHER, PrimitiveList::SPHERE, PrimitiveList::OTHER,
+                                   PrimitiveList::OTHER};
+    ASSERT_EQ(list.size(), shapes.size());
+    for(int i = 0; i < shapes.size(); i++){
+        EXPECT_EQ(list.getType(i), types[i]);
+        EXPECT_EQ(list.getShape(i), shapes[i]);
+    }
+
+    // Derived classes are called through their own functions
+    Intersection hit(0, nullptr);
+    EXPECT_TRUE(list.closestHit(7, Ray(Point(0, 0, -5), Vector(0, 0, 1)), 0, INFINITY, hit));
+    EXPECT_TRUE(floatIsEqual(hit.getTime(), 3));
+
+    list.clear();
+    EXPECT_EQ(list.size(), 0);
+}
+
+// Every query should give the same result as the shape's own functions on the transformed ray
+TEST(PrimitiveListTest, MatchesShapeFunctions){
+    Matrix4 transform = translationMatrix(1, -0.5, 2)*yRotationMatrix(PI/5)*scalingMatrix(1.5, 1, 0.75);
+    std::vector<Shape*> shapes = {new Sphere, new Plane, new Cube, new Triangle(Point(0, 1, 0), Point(-1, 0, 0), Point(1, 0, 0)),
+                                  new SmoothTriangle(Point(0, 1, 0), Point(-1, 0, 0), Point(1, 0, 0), Vector(0, 1, 0), Vector(-1, 0, 0), Vector(1, 0, 0)),
+                                  new Cylinder};
+    Material noShadow;
+    noShadow.castsShadow = false;
+    Sphere* hidden = new Sphere;
+    hidden->setMaterial(noShadow);
+    shapes.push_back(hidden);
+
+    PrimitiveList list;
+    for(int i = 0; i < shapes.size(); i++){
+        shapes[i]->setTransform(transform);
+        list.add(shapes[i], shapes[i]->getInverseTransform());
+    }
+
+    std::mt19937 rng(9);
+    std::uniform_real_distribution<float> position(-4, 4);
+    for(int n = 0; n < 100; n++){
+        Ray rays[PACKET_SIZE];
+        for(int j = 0; j < PACKET_SIZE; j++){
+            Point from(position(rng), position(rng), -6);
+            Point to(position(rng)/2 + 1, position(rng)/2, 2);
+            rays[j] = Ray(from, Vector(to - from).normalize());
+        }
+        RayPacket p(rays);
+
+        for(int i = 0; i < shapes.size(); i++){
+            float tmax[PACKET_SIZE];
+            std::fill(tmax, tmax + PACKET_SIZE, INFINITY);
+            Intersection hits[PACKET_SIZE];
+            int found = list.closestHitPacket(i, p, PACKET_ALL, 0, tmax, hits);
+
+            for(int j = 0; j < PACKET_SIZE; j++){
+                Intersection expected(0, nullptr);
+                Intersection hit(0, nullptr);
+                bool hitShape = shapes[i]->findClosestHit(rays[j], 0, INFINITY, expected);
+                ASSERT_EQ(list.closestHit(i, rays[j], 0, INFINITY, hit), hitShape);
+                ASSERT_EQ((found & (1 << j)) != 0, hitShape);
+                if(hitShape){
+                    EXPECT_TRUE(hit.isEqual(expected));
+                    EXPECT_TRUE(floatIsEqual(hit.getU(), expected.getU()));
+                    EXPECT_TRUE(hits[j].isEqual(expected));
+                }
+                EXPECT_EQ(list.occluded(i, rays[j], 10), shapes[i]->isOccluded(rays[j], 10));
+
+                std::vector<Intersection> xs;
+                list.intersections(i, rays[j], xs);
+                EXPECT_EQ(xs.size(), shapes[i]->findIntersections(rays[j]).size());
+            }
+        }
+    }
+
+    for(int i = 0; i < shapes.size(); i++){
+        delete shapes[i];
+    }
+}
@@ -0,0 +1,153 @@
+#include <gtest/gtest.h>
+#include "RayPacket.h"
+#include "Shape.h"
+#include "Mesh.h"
+#include "mesh_fixtures.h"
+#include "Group.h"
+#include "World.h"
+#include "Camera.h"
+#include <random>
+#include <algorithm>
+
+// Four rays from near from towards random points around to
+static void randomRays(std::mt19937 &rng, Point from, Point to, float spread, Ray rays[PACKET_SIZE]){
+    std::uniform_real_distribution<float> offset(-spread, spread);
+    for(int i = 0; i < PACKET_SIZE; i++){
+        Point target(to.x + offset(rng), to.y + offset(rng), to.z + offset(rng));
+        rays[i] = Ray(from, Vector(target - from).normalize());
+    }
+}
+
+// The packet closest hit should find the same hit as childClosestHit for every ray
+static void expectPacketMatches(Shape* s, const Ray rays[PACKET_SIZE], float tmin, int mask){
+    RayPacket p(rays);
+    float tmax[PACKET_SIZE] = {INFINITY, INFINITY, 3, INFINITY};
+    float limits[PACKET_SIZE] = {INFINITY, INFINITY, 3, INFINITY};
+    Intersection hits[PACKET_SIZE];
+    int found = s->childClosestHitPacket(p, mask, tmin, tmax, hits);
+
+    for(int i = 0; i < PACKET_SIZE; i++){
+        Intersection hit(0, nullptr);
+        bool expected = (mask & (1 << i)) && s->childClosestHit(rays[i], tmin, limits[i], hit);
+        ASSERT_EQ((found & (1 << i)) != 0, expected);
+        if(expected){
+            EXPECT_TRUE(floatIsEqual(hits[i].getTime(), hit.getTime()));
+            EXPECT_TRUE(floatIsEqual(tmax[i], hit.getTime()));
+            EXPECT_EQ(hits[i].getShape(), hit.getShape());
+            EXPECT_EQ(hits[i].getIndex(), hit.getIndex());
+            EXPECT_TRUE(floatIsEqual(hits[i].getU(), hit.getU()));
+            EXPECT_TRUE(floatIsEqual(hits[i].getV(), hit.getV()));
+        }else{
+            EXPECT_EQ(tmax[i], limits[i]);
+        }
+    }
+}
+
+TEST(RayPacketTest, BasicTest){
+    Ray rays[PACKET_SIZE] = {Ray(Point(1, 2, 3), Vector(0, 0, 1)), Ray(Point(0, 0, 0), Vector(0.5, 0, 1)),
+                             Ray(Point(-1, 0, 0), Vector(0, -0.5, 1)), Ray(Point(0, 4, 0), Vector(-1, 0, 1))};
+    RayPacket p(rays);
+    for(int i = 0; i < PACKET_SIZE; i++){
+        EXPECT_TRUE(p.getRay(i).getOrigin().isEqual(rays[i].getOrigin()));
+        EXPECT_TRUE(p.getRay(i).getDirection().isEqual(rays[i].getDirection()));
+    }
+
+    Matrix4 m = translationMatrix(1, 2, 3)*yRotationMatrix(PI/4)*scalingMatrix(2, 2, 2);
+    RayPacket moved = p.transform(m);
+    for(int i = 0; i < PACKET_SIZE; i++){
+        EXPECT_TRUE(moved.getRay(i).getOrigin().isEqual(rays[i].transform(m).getOrigin()));
+        EXPECT_TRUE(moved.getRay(i).getDirection().isEqual(rays[i].transform(m).getDirection()));
+    }
+
+    // The last two rays point in different directions on x and y
+    EXPECT_TRUE(p.isCoherent(0b0011));
+    EXPECT_FALSE(p.isCoherent(0b0110));
+    EXPECT_FALSE(p.isCoherent(PACKET_ALL));
+    EXPECT_TRUE(p.isCoherent(0b1000));
+}
+
+TEST(RayPacketTest, PrimitivesMatchSingleRays){
+    std::vector<Shape*> shapes = {new Sphere, new Plane, new Cube, new Triangle(Point(0, 1, 0), Point(-1, 0, 0), Point(1, 0, 0)),
+                                  new SmoothTriangle(Point(0, 1, 0), Point(-1, 0, 0), Point(1, 0, 0), Vector(0, 1, 0), Vector(-1, 0, 0), Vector(1, 0, 0)),
+                                  new Cylinder};
+
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> position(-3, 3);
+    for(int i = 0; i < 200; i++){
+        Ray rays[PACKET_SIZE];
+        randomRays(rng, Point(position(rng), position(rng), -5), Point(0, 0, 0), 1.5, rays);
+        // Also rays starting inside the shapes
+        Ray inside[PACKET_SIZE];
+        randomRays(rng, Point(0.1, 0.2, 0), Point(position(rng), position(rng), position(rng)), 1, inside);
+
+        for(int j = 0; j < shapes.size(); j++){
+            expectPacketMatches(shapes[j], rays, 0, PACKET_ALL);
+            expectPacketMatches(shapes[j], rays, 0, 0b1010);
+            expectPacketMatches(shapes[j], inside, 0, PACKET_ALL);
+        }
+    }
+
+    // Parallel to the plane and the triangles
+    Ray parallel[PACKET_SIZE] = {Ray(Point(0, 1, 0), Vector(1, 0, 0)), Ray(Point(0, 0.5, -1), Vector(0, 0, 1)),
+                                 Ray(Point(0, 0.5, -1), Vector(1, 0, 0)), Ray(Point(0.1, 0.2, -1), Vector(0, 0, 1))};
+    for(int j = 0; j < shapes.size(); j++){
+        expectPacketMatches(shapes[j], parallel, 0, PACKET_ALL);
+        delete shapes[j];
+    }
+}
+
+TEST(RayPacketTest, MeshMatchesSingleRays){
+    std::vector<Point> points;
+    Mesh* m = gridMesh(16, points, 7);
+    m->buildBVH();
+
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> position(-1, 17);
+    for(int i = 0; i < 200; i++){
+        Ray rays[PACKET_SIZE];
+        randomRays(rng, Point(8, 8, -10), Point(position(rng), position(rng), 0), 0.5, rays);
+        expectPacketMatches(m, rays, 0, PACKET_ALL);
+        expectPacketMatches(m, rays, 0, 0b0110);
+    }
+    delete m;
+}
+
+// The camera's rays traced as packets should colour the world exactly like single rays
+TEST(RayPacketTest, WorldMatchesSingleRays){
+    World w = defaultWorld();
+    Plane* floor = new Plane;
+    floor->setTransform(translationMatrix(0, -1, 0));
+    w.appendObject(floor);
+    Group* g = new Group;
+    for(int i = 0; i < 4; i++){
+        Cube* c = new Cube;
+        c->setTransform(translationMatrix(3*i - 4.5, 0, 3)*scalingMatrix(0.5, 0.5, 0.5));
+        g->appendShape(c);
+    }
+    w.appendObject(g);
+
+    Camera c(33, 21, PI/2);
+    c.setTransform(viewTransformationMatrix(Point(0, 1.5, -5), Point(0, 0, 0), Vector(0, 1, 0)));
+    std::vector<Ray> rays;
+    c.raysForTile(0, 0, 33, 21, rays);
+
+    for(int i = 0; i + PACKET_SIZE <= rays.size(); i += PACKET_SIZE){
+        RayPacket p(&rays[i]);
+        float tmax[PACKET_SIZE];
+        std::fill(tmax, tmax + PACKET_SIZE, INFINITY);
+        Intersection hits[PACKET_SIZE];
+        int found = w.findClosestHitPacket(p, PACKET_ALL, 0, tmax, hits);
+
+        Colour colours[PACKET_SIZE];
+        w.colourAtHitPacket(&rays[i], colours);
+        for(int j = 0; j < PACKET_SIZE; j++){
+            Intersection hit(0, nullptr);
+            ASSERT_EQ((found & (1 << j)) != 0, w.findClosestHit(rays[i + j], 0, INFINITY, hit));
+            if(found & (1 << j)){
+                EXPECT_TRUE(hits[j].isEqual(hit));
+                EXPECT_TRUE(floatIsEqual(hits[j].getTime(), hit.getTime()));
+            }
+            EXPECT_TRUE(colours[j].isEqual(w.colourAtHit(rays[i + j])));
+        }
+    }
+}
@@ -21,6 +21,25 @@ TEST(ShapeTest, BasicTest){
     EXPECT_EQ(s.getParent(), nullptr);
 }
 
+TEST(ShapeTest, SetTransformCachesInverseAndInverseTranspose){
+    Shape s;
+    EXPECT_TRUE(s.getInverseTransform().isEqual(Matrix(4)));
+    EXPECT_TRUE(s.getInverseTranspose().isEqual(Matrix(4)));
+
+    Matrix4 m = translationMatrix(2, 3, 4)*scalingMatrix(1, 2, 3);
+    s.setTransform(m);
+    EXPECT_TRUE(s.getInverseTransform().isEqual(Matrix(m).inverse()));
+    EXPECT_TRUE(s.getInverseTranspose().isEqual(Matrix(m).inverse().transpose()));
+
+    // A small uniform scale is a valid transform
+    Sphere small;
+    small.setTransform(scalingMatrix(0.04, 0.04, 0.04));
+    std::vector<Intersection> xs = small.findIntersections(Ray(Point(0, 0, -5), Vector(0, 0, 1)));
+    ASSERT_EQ(xs.size(), 2);
+    EXPECT_TRUE(floatIsEqual(xs.at(0).getTime(), 4.96));
+    EXPECT_THROW(small.setTransform(scalingMatrix(0, 1, 1)), std::invalid_argument);
+}
+
 TEST(PlaneChildNormalTest, AllNormalVectorsAreTheSame){
     Plane* p = new Plane;
     Vector n1 = p->childNormal(Point());
@@ -242,14 +261,15 @@ TEST(CylinderChildIntersectionsTest, RayIntersectsWithCylinderCaps){
     EXPECT_EQ(result3.size(), 2);
     EXPECT_EQ(result4.size(), 2);
     EXPECT_EQ(result5.size(), 2);
-    EXPECT_EQ(result1.at(0).getTime(), 2);
-    EXPECT_EQ(result1.at(1).getTime(), 1);
-    EXPECT_EQ(result2.at(0).getTime(), 1.5);
-    EXPECT_EQ(result2.at(1).getTime(), 1);
-    EXPECT_EQ(result3.at(0).getTime(), 3);
-    EXPECT_EQ(result3.at(1).getTime(), 2);
-    EXPECT_EQ(result4.at(0).getTime(), 1.5);
-    EXPECT_EQ(result4.at(1).getTime(), 1);
+    // Intersections are in order of time
+    EXPECT_EQ(result1.at(0).getTime(), 1);
+    EXPECT_EQ(result1.at(1).getTime(), 2);
+    EXPECT_EQ(result2.at(0).getTime(), 1);
+    EXPECT_EQ(result2.at(1).getTime(), 1.5);
+    EXPECT_EQ(result3.at(0).getTime(), 2);
+    EXPECT_EQ(result3.at(1).getTime(), 3);
+    EXPECT_EQ(result4.at(0).getTime(), 1);
+    EXPECT_EQ(result4.at(1).getTime(), 1.5);
     EXPECT_EQ(result5.at(0).getTime(), 2);
     EXPECT_EQ(result5.at(1).getTime(), 3);
 }
@@ -644,4 +664,211 @@ TEST(PrepareLightDataTest, NormalVectorComputedForSmoothTriangles){
     LightData data = prepareLightData(i, r, intersects);
 
     EXPECT_TRUE(data.normal.isEqual(Vector(-0.5547, 0.83205, 0)));
-}
\ No newline at end of file
+}
+
+TEST(ShapeTest, PrimitiveBounds){
+    Sphere s;
+    EXPECT_TRUE(s.bounds().min.isEqual(Point(-1, -1, -1)));
+    EXPECT_TRUE(s.bounds().max.isEqual(Point(1, 1, 1)));
+
+    Plane p;
+    EXPECT_TRUE(p.bounds().isUnbounded());
+    EXPECT_TRUE(floatIsEqual(p.bounds().min.y, 0));
+    EXPECT_TRUE(floatIsEqual(p.bounds().max.y, 0));
+
+    Cube c;
+    EXPECT_TRUE(c.bounds().min.isEqual(Point(-1, -1, -1)));
+    EXPECT_TRUE(c.bounds().max.isEqual(Point(1, 1, 1)));
+
+    Cylinder cyl;
+    EXPECT_TRUE(cyl.bounds().isUnbounded());
+    cyl.setMinH(-5);
+    cyl.setMaxH(3);
+    EXPECT_TRUE(cyl.bounds().min.isEqual(Point(-1, -5, -1)));
+    EXPECT_TRUE(cyl.bounds().max.isEqual(Point(1, 3, 1)));
+
+    Cone cone;
+    EXPECT_TRUE(cone.bounds().isUnbounded());
+    cone.setMinH(-5);
+    cone.setMaxH(3);
+    EXPECT_TRUE(cone.bounds().min.isEqual(Point(-5, -5, -5)));
+    EXPECT_TRUE(cone.bounds().max.isEqual(Point(5, 3, 5)));
+
+    Triangle t(Point(-3, 7, 2), Point(6, 2, -4), Point(2, -1, -1));
+    EXPECT_TRUE(t.bounds().min.isEqual(Point(-3, -1, -4)));
+    EXPECT_TRUE(t.bounds().max.isEqual(Point(6, 7, 2)));
+}
+
+TEST(ShapeTest, ParentSpaceBounds){
+    Sphere s;
+    s.setTransform(translationMatrix(1, -3, 5)*scalingMatrix(0.5, 2, 4));
+    BoundingBox b = s.parentSpaceBounds();
+    EXPECT_TRUE(b.min.isEqual(Point(0.5, -5, 1)));
+    EXPECT_TRUE(b.max.isEqual(Point(1.5, -1, 9)));
+}
+
+TEST(GroupTest, GroupBoundsContainChildren){
+    Group* g = new Group;
+    Sphere* s = new Sphere;
+    s->setTransform(translationMatrix(2, 5, -3)*scalingMatrix(2, 2, 2));
+    Cylinder* c = new Cylinder;
+    c->setMinH(-2);
+    c->setMaxH(2);
+    c->setTransform(translationMatrix(-4, -1, 4)*scalingMatrix(0.5, 1, 0.5));
+    g->appendShape(s);
+    g->appendShape(c);
+
+    EXPECT_TRUE(g->bounds().min.isEqual(Point(-4.5, -3, -5)));
+    EXPECT_TRUE(g->bounds().max.isEqual(Point(4, 7, 4.5)));
+
+    // Changing a child after it was added updates the group and its parents
+    Group* outer = new Group;
+    outer->appendShape(g);
+    c->setMaxH(10);
+    EXPECT_TRUE(g->bounds().max.isEqual(Point(4, 9, 4.5)));
+    EXPECT_TRUE(outer->bounds().max.isEqual(Point(4, 9, 4.5)));
+}
+
+TEST(GroupTest, RayMissingGroupBoundsSkipsChildren){
+    Group* g = new Group;
+    Sphere* s = new Sphere;
+    s->setTransform(translationMatrix(0, 0, 5));
+    g->appendShape(s);
+
+    EXPECT_EQ(g->findIntersections(Ray(Point(0, 0, -5), Vector(0, 0, 1))).size(), 2);
+    EXPECT_EQ(g->findIntersections(Ray(Point(0, 3, -5), Vector(0, 0, 1))).size(), 0);
+
+    // Groups containing planes are never skipped
+    g->appendShape(new Plane);
+    EXPECT_TRUE(g->bounds().isUnbounded());
+    EXPECT_EQ(g->findIntersections(Ray(Point(0, 3, -5), Vector(0, -1, 1))).size(), 1);
+}
+
+TEST(ShapeTest, isOccludedMatchesFindIntersections){
+    std::vector<Shape*> shapes;
+    shapes.push_back(new Sphere);
+    shapes.push_back(new Plane);
+    shapes.push_back(new Cube);
+    Cylinder* cyl = new Cylinder;
+    cyl->setMinH(-1);
+    cyl->setMaxH(1);
+    cyl->setClosed(true);
+    shapes.push_back(cyl);
+    Cone* cone = new Cone;
+    cone->setMinH(-1);
+    cone->setMaxH(0.5);
+    cone->setClosed(true);
+    shapes.push_back(cone);
+    shapes.push_back(new Triangle(Point(0, 1, 0), Point(-1, 0, 0), Point(1, 0, 0)));
+    Group* g = new Group;
+    Sphere* s = new Sphere;
+    s->setTransform(translationMatrix(0.5, 0, 0));
+    g->appendShape(s);
+    shapes.push_back(g);
+
+    std::vector<Ray> rays{Ray(Point(0, 0.5, -5), Vector(0, 0, 1)), Ray(Point(0.3, 2, -5), Vector(0, -0.3, 1)),
+        Ray(Point(0, 5, 0), Vector(0, -1, 0)), Ray(Point(0, 0.2, 0), Vector(0, 0, 1)), Ray(Point(3, 3, -5), Vector(0, 0, 1))};
+    std::vector<float> distances{3, 4.5, 5.5, 100};
+
+    for(Shape* shape : shapes){
+        for(Ray r : rays){
+            std::vector<Intersection> intersects = shape->findIntersections(r);
+            for(float d : distances){
+                int ind = hit(intersects);
+                bool expected = ind != -1 && intersects.at(ind).getTime() < d;
+                EXPECT_EQ(shape->isOccluded(r, d), expected);
+            }
+        }
+    }
+}
+
+TEST(ShapeTest, findClosestHitMatchesFindIntersections){
+    std::vector<Shape*> shapes;
+    shapes.push_back(new Sphere);
+    shapes.push_back(new Plane);
+    shapes.push_back(new Cube);
+    Cylinder* cyl = new Cylinder;
+    cyl->setMinH(-1);
+    cyl->setMaxH(1);
+    cyl->setClosed(true);
+    shapes.push_back(cyl);
+    Cone* cone = new Cone;
+    cone->setMinH(-1);
+    cone->setMaxH(0.5);
+    cone->setClosed(true);
+    shapes.push_back(cone);
+    shapes.push_back(new Triangle(Point(0, 1, 0), Point(-1, 0, 0), Point(1, 0, 0)));
+    shapes.push_back(new SmoothTriangle(Point(0, 1, 0), Point(-1, 0, 0), Point(1, 0, 0), Vector(0, 1, 0), Vector(-1, 0, 0), Vector(1, 0, 0)));
+    Group* g = new Group;
+    Sphere* s1 = new Sphere;
+    s1->setTransform(translationMatrix(0.5, 0, 0));
+    Sphere* s2 = new Sphere;
+    s2->setTransform(translationMatrix(0, 0, 3));
+    g->appendShape(s1);
+    g->appendShape(s2);
+    shapes.push_back(g);
+
+    std::vector<Ray> rays{Ray(Point(0, 0.5, -5), Vector(0, 0, 1)), Ray(Point(0.3, 2, -5), Vector(0, -0.3, 1)),
+        Ray(Point(0, 5, 0), Vector(0, -1, 0)), Ray(Point(0, 0.2, 0), Vector(0, 0, 1)), Ray(Point(3, 3, -5), Vector(0, 0, 1))};
+    std::vector<float> tmins{0, 4.5, 5.5};
+
+    for(Shape* shape : shapes){
+        for(Ray r : rays){
+            std::vector<Intersection> intersects = shape->findIntersections(r);
+            for(float tmin : tmins){
+                // Lowest time that is at least tmin
+                int ind = -1;
+                for(int i = 0; i < intersects.size(); i++){
+                    float t = intersects.at(i).getTime();
+                    if(t >= tmin && (ind == -1 || t < intersects.at(ind).getTime())){
+                        ind = i;
+                    }
+                }
+
+                Intersection closest(0, nullptr);
+                bool found = shape->findClosestHit(r, tmin, INFINITY, closest);
+                ASSERT_EQ(found, ind != -1);
+                if(found){
+                    EXPECT_TRUE(closest.isEqual(intersects.at(ind)));
+                    EXPECT_TRUE(floatIsEqual(closest.getU(), intersects.at(ind).getU()));
+                    // Nothing is found when tmax is before the closest hit
+                    Intersection none(0, nullptr);
+                    EXPECT_FALSE(shape->findClosestHit(r, tmin, closest.getTime(), none));
+                    EXPECT_EQ(none.getShape(), nullptr);
+                }
+            }
+        }
+    }
+}
+
+TEST(ShapeTest, findIntersectionsAppendsToBuffer){
+    Sphere s;
+    Group* g = new Group;
+    Sphere* s1 = new Sphere;
+    Sphere* s2 = new Sphere;
+    s2->setTransform(translationMatrix(0, 0, -3));
+    g->appendShape(s1);
+    g->appendShape(s2);
+    Ray r(Point(0, 0, -5), Vector(0, 0, 1));
+
+    // Intersections already in the buffer are kept and are not sorted with the new ones
+    std::vector<Intersection> buffer{Intersection(100, nullptr)};
+    s.findIntersections(r, buffer);
+    g->findIntersections(r, buffer);
+
+    ASSERT_EQ(buffer.size(), 7);
+    EXPECT_EQ(buffer.at(0).getTime(), 100);
+    EXPECT_TRUE(floatIsEqual(buffer.at(1).getTime(), 4));
+    EXPECT_TRUE(floatIsEqual(buffer.at(2).getTime(), 6));
+    EXPECT_EQ(buffer.at(3).getShape(), s2);
+    EXPECT_EQ(buffer.at(4).getShape(), s2);
+    EXPECT_EQ(buffer.at(5).getShape(), s1);
+    EXPECT_EQ(buffer.at(6).getShape(), s1);
+
+    // Reusing the buffer does not need to allocate once it is large enough
+    size_t capacity = buffer.capacity();
+    buffer.clear();
+    g->findIntersections(r, buffer);
+    EXPECT_EQ(buffer.size(), 4);
+    EXPECT_EQ(buffer.capacity(), capacity);
+}
@@ -0,0 +1,151 @@
+#include <gtest/gtest.h>
+#include "SphereSet.h"
+#include "Group.h"
+#include "World.h"
+#include "LightData.h"
+#include <random>
+
+// Set of count random spheres and a group of the same spheres as Sphere objects
+static SphereSet* randomSpheres(int count, Group &g){
+    std::mt19937 rng(13);
+    std::uniform_real_distribution<float> position(-5, 5);
+    std::uniform_real_distribution<float> radius(0.1, 0.8);
+    SphereSet* set = new SphereSet;
+    for(int i = 0; i < count; i++){
+        Point center(position(rng), position(rng), position(rng));
+        float r = radius(rng);
+        set->addSphere(center, r);
+        Sphere* s = new Sphere;
+        s->setTransform(translationMatrix(center.x, center.y, center.z)*scalingMatrix(r, r, r));
+        g.appendShape(s);
+    }
+    return set;
+}
+
+TEST(SphereSetTest, BasicTest){
+    SphereSet s;
+    EXPECT_EQ(s.sphereCount(), 0);
+    EXPECT_TRUE(s.bounds().isEmpty());
+    Intersection hit(0, nullptr);
+    EXPECT_FALSE(s.findClosestHit(Ray(Point(0, 0, -5), Vector(0, 0, 1)), 0, INFINITY, hit));
+
+    EXPECT_EQ(s.addSphere(Point(1, 2, 3), 0.5), 0);
+    EXPECT_EQ(s.addSphere(Point(-1, 0, 0), 2), 1);
+    EXPECT_EQ(s.sphereCount(), 2);
+    EXPECT_TRUE(s.getCenter(0).isEqual(Point(1, 2, 3)));
+    EXPECT_TRUE(floatIsEqual(s.getRadius(1), 2));
+    EXPECT_TRUE(s.bounds().min.isEqual(Point(-3, -2, -2)));
+    EXPECT_TRUE(s.bounds().max.isEqual(Point(1.5, 2.5, 3.5)));
+
+    EXPECT_THROW(s.addSphere(Point(0, 0, 0), 0), std::invalid_argument);
+    EXPECT_THROW(s.addSphere(Point(0, 0, 0), -1), std::invalid_argument);
+    EXPECT_THROW(s.getCenter(2), std::invalid_argument);
+    EXPECT_EQ(s.sphereCount(), 2);
+
+    // The hit stores which sphere was hit and the normal is that sphere's
+    EXPECT_TRUE(s.findClosestHit(Ray(Point(-1, 0, -5), Vector(0, 0, 1)), 0, INFINITY, hit));
+    EXPECT_EQ(hit.getIndex(), 1);
+    EXPECT_TRUE(floatIsEqual(hit.getTime(), 3));
+    EXPECT_TRUE(s.computeNormal(Point(-1, 0, -2), hit).isEqual(Vector(0, 0, -1)));
+    EXPECT_THROW(s.computeNormal(Point(0, 0, 0), Intersection(1, &s)), std::invalid_argument);
+}
+
+// The set should find exactly what a group of the same spheres finds, including with a partly filled last block
+TEST(SphereSetTest, MatchesGroupOfSpheres){
+    Group g;
+    SphereSet* set = randomSpheres(203, g);
+    set->setTransform(yRotationMatrix(PI/7)*scalingMatrix(1, 2, 1));
+    g.setTransform(yRotationMatrix(PI/7)*scalingMatrix(1, 2, 1));
+
+    std::mt19937 rng(17);
+    std::uniform_real_distribution<float> position(-6, 6);
+    for(int i = 0; i < 300; i++){
+        Point from(position(rng), position(rng), -15);
+        Point to(position(rng), position(rng), 5);
+        // Every tenth ray starts in the middle of the spheres
+        if(i % 10 == 0){
+            from = Point(0, 0, 0);
+        }
+        Ray r(from, Vector(to - from).normalize());
+
+        std::vector<Intersection> setHits = set->findIntersections(r);
+        std::vector<Intersection> groupHits = g.findIntersections(r);
+        ASSERT_EQ(setHits.size(), groupHits.size());
+        // Sphere objects lose precision for rays that barely touch a small sphere far from the ray's origin(the set
+        // does not), so the times are only compared closely enough to know the same sphere was hit
+        for(int j = 0; j < setHits.size(); j++){
+            EXPECT_NEAR(setHits.at(j).getTime(), groupHits.at(j).getTime(), 0.01);
+        }
+
+        Intersection setHit(0, nullptr);
+        Intersection groupHit(0, nullptr);
+        ASSERT_EQ(set->findClosestHit(r, 0, INFINITY, setHit), g.findClosestHit(r, 0, INFINITY, groupHit));
+        if(groupHit.getShape() != nullptr){
+            EXPECT_NEAR(setHit.getTime(), groupHit.getTime(), 0.01);
+            Point p = r.computePosition(setHit.getTime());
+            EXPECT_TRUE(set->computeNormal(p, setHit).isEqual(groupHit.getShape()->computeNormal(p, groupHit)));
+        }
+        EXPECT_EQ(set->isOccluded(r, 8), g.isOccluded(r, 8));
+    }
+    delete set;
+}
+
+TEST(SphereSetTest, MaterialPerSphere){
+    SphereSet* s = new SphereSet;
+    Material red;
+    red.colour = Colour(1, 0, 0);
+    s->setMaterial(red);
+    Material glass = glassSphere()->getMaterial();
+    Material hidden;
+    hidden.castsShadow = false;
+    s->addSphere(Point(0, 0, 0), 1);
+    s->addSphere(Point(0, 0, 4), 1, glass);
+    s->addSphere(Point(0, 0, 8), 1, hidden);
+    EXPECT_TRUE(s->getSphereMaterial(0).isEqual(red));
+    EXPECT_TRUE(s->getSphereMaterial(1).isEqual(glass));
+
+    // Hits are shaded with the material of the sphere that was hit
+    std::vector<Intersection> xs = s->findIntersections(Ray(Point(0, 0, -5), Vector(0, 0, 1)));
+    ASSERT_EQ(xs.size(), 6);
+    EXPECT_TRUE(xs.at(0).getMaterial().isEqual(red));
+    EXPECT_TRUE(xs.at(2).getMaterial().isEqual(glass));
+    LightData data = prepareLightData(xs, 2, Ray(Point(0, 0, -5), Vector(0, 0, 1)));
+    EXPECT_TRUE(data.getMaterial().isEqual(glass));
+    // Each sphere is a separate object for refraction, the ray left the first sphere before entering the second
+    EXPECT_TRUE(floatIsEqual(data.n1, 1));
+    EXPECT_TRUE(floatIsEqual(data.n2, 1.5));
+
+    // Only the third sphere does not cast shadows
+    EXPECT_TRUE(s->isOccluded(Ray(Point(0, 0, 2), Vector(0, 0, 1)), 3));
+    EXPECT_FALSE(s->isOccluded(Ray(Point(0, 0, 6), Vector(0, 0, 1)), 3));
+
+    World w = defaultWorld();
+    w.setObjects({s});
+    Ray r(Point(0, 0, -5), Vector(0, 0, 1));
+    Intersection hit(0, nullptr);
+    ASSERT_TRUE(w.findClosestHit(r, 0, INFINITY, hit));
+    EXPECT_EQ(hit.getIndex(), 0);
+    EXPECT_TRUE(w.colourAtHit(r).isEqual(w.shadeHit(prepareLightData(hit, r))));
+    EXPECT_THROW(s->setSphereMaterial(3, red), std::invalid_argument);
+}
+
+TEST(SphereSetTest, CommitKeepsOnlyUsedMaterials){
+    SphereSet s;
+    Material m;
+    for(int i = 0; i < 4; i++){
+        s.addSphere(Point(3*i, 0, 0), 1, m);
+    }
+    EXPECT_EQ(s.sphereMaterialCount(), 1);
+
+    // Every replaced material stays in the table until the set is committed
+    for(int i = 0; i < 50; i++){
+        m.ambient = 0.5 + i/100.0;
+        s.setSphereMaterial(i % 2, m);
+    }
+    EXPECT_EQ(s.sphereMaterialCount(), 51);
+    s.commit(Matrix4(), Matrix4(), nullptr);
+    EXPECT_EQ(s.sphereMaterialCount(), 3);
+    EXPECT_TRUE(floatIsEqual(s.getSphereMaterial(0).ambient, 0.98));
+    EXPECT_TRUE(floatIsEqual(s.getSphereMaterial(1).ambient, 0.99));
+    EXPECT_TRUE(s.getSphereMaterial(3).isEqual(Material()));
+}
@@ -0,0 +1,50 @@
+#include <gtest/gtest.h>
+#include "TileScheduler.h"
+#include <atomic>
+#include <stdexcept>
+
+TEST(TileSchedulerTest, BasicTest){
+    TileScheduler s(100, 50, 16, 4);
+    EXPECT_EQ(s.getTileCount(), 7*4);
+    EXPECT_EQ(s.getThreadCount(), 4);
+
+    // Never more threads than tiles
+    TileScheduler small(10, 10, 16, 8);
+    EXPECT_EQ(small.getTileCount(), 1);
+    EXPECT_EQ(small.getThreadCount(), 1);
+
+    TileScheduler automatic(100, 50, 16, 0);
+    EXPECT_GE(automatic.getThreadCount(), 1);
+}
+
+TEST(TileSchedulerTest, EveryPixelRenderedOnce){
+    const int width = 101, height = 67;
+    std::vector<std::atomic<int>> counts(width*height);
+    for(std::atomic<int> &c : counts){
+        c = 0;
+    }
+
+    TileScheduler s(width, height, 16, 4);
+    s.run([&](int x, int y, int w, int h){
+        EXPECT_LE(x + w, width);
+        EXPECT_LE(y + h, height);
+        for(int j = y; j < y + h; j++){
+            for(int i = x; i < x + w; i++){
+                counts[j*width + i]++;
+            }
+        }
+    });
+
+    for(std::atomic<int> &c : counts){
+        EXPECT_EQ(c, 1);
+    }
+}
+
+TEST(TileSchedulerTest, ExceptionsPropagate){
+    TileScheduler s(64, 64, 8, 4);
+    EXPECT_THROW(s.run([](int x, int y, int w, int h){
+        if(x == 32 && y == 32){
+            throw std::invalid_argument("tile failed");
+        }
+    }), std::invalid_argument);
+}
@@ -120,4 +120,26 @@ TEST(VectorOperations, VectorCrossProduct){
   Vector b(2, 3, 4);
   EXPECT_TRUE(crossProduct(a, b).isEqual(Vector(-1, 2, -1)));
   EXPECT_TRUE(crossProduct(b, a).isEqual(Vector(1, -2, 1)));
-}
\ No newline at end of file
+}
+
+TEST(TupleOperations, TuplesAreAlignedForSSE){
+  EXPECT_EQ(alignof(Tuple), 16);
+  EXPECT_EQ(sizeof(Tuple), 16);
+  EXPECT_EQ(sizeof(Point), 16);
+  EXPECT_EQ(sizeof(Vector), 16);
+}
+
+TEST(VectorOperations, OperationsIncludeAllFourComponents){
+  Tuple a(1, -2, 3, 4);
+  Tuple b(0.5, 2, -1, 2);
+  EXPECT_TRUE((a + b).isEqual(Tuple(1.5, 0, 2, 6)));
+  EXPECT_TRUE((a - b).isEqual(Tuple(0.5, -4, 4, 2)));
+  EXPECT_TRUE((a*2).isEqual(Tuple(2, -4, 6, 8)));
+  EXPECT_TRUE((a/4).isEqual(Tuple(0.25, -0.5, 0.75, 1)));
+  EXPECT_TRUE(a.negateTuple().isEqual(Tuple(-1, 2, -3, -4)));
+
+  Vector v(2, -3, 6);
+  EXPECT_TRUE(floatIsEqual(dotProduct(v, Vector(1, 1, 1)), 5));
+  EXPECT_TRUE(floatIsEqual(v.magnitude(), 7));
+  EXPECT_TRUE(crossProduct(v, Vector(1, 0, 0)).isEqual(Vector(0, 6, 3)));
+}
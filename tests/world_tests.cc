@@ -2,6 +2,8 @@
 #include "World.h"
 #include "Ray.h"
 #include "Shape.h"
+#include "Group.h"
+#include "CSG.h"
 
 TEST(WorldTest, BasicTest){
     World w;
@@ -370,4 +372,209 @@ TEST(WorldTest, ShadeHitUsesReflectanceWhenCombiningReflectionAndRefraction){
 
     Colour c = w.shadeHit(data, 5);
     EXPECT_TRUE(c.isEqual(Colour(0.93391, 0.69643, 0.69243)));
-}
\ No newline at end of file
+}
+
+TEST(WorldTest, RayIntersectionWithManyObjects){
+    World w;
+    std::vector<Shape*> objects;
+    for(int x = -10; x <= 10; x++){
+        for(int y = -10; y <= 10; y++){
+            Sphere* s = new Sphere;
+            s->setTransform(translationMatrix(x, y, 0)*scalingMatrix(0.4, 0.4, 0.4));
+            objects.push_back(s);
+        }
+    }
+    Plane* p = new Plane;
+    p->setTransform(translationMatrix(0, -11, 0));
+    objects.push_back(p);
+    w.setObjects(objects);
+
+    for(float x = -10; x <= 10; x += 0.7){
+        Ray r(Point(x, 0.1*x, -5), Vector(0, -0.02, 1));
+        std::vector<Intersection> expected;
+        for(Shape* s : objects){
+            std::vector<Intersection> temp = s->findIntersections(r);
+            expected.insert(expected.end(), temp.begin(), temp.end());
+        }
+        std::sort(expected.begin(), expected.end(), compareIntersections);
+
+        std::vector<Intersection> result = w.RayIntersection(r);
+        ASSERT_EQ(result.size(), expected.size());
+        for(int i = 0; i < result.size(); i++){
+            EXPECT_EQ(result.at(i).getTime(), expected.at(i).getTime());
+            EXPECT_EQ(result.at(i).getShape(), expected.at(i).getShape());
+        }
+    }
+}
+
+TEST(WorldTest, RayIntersectionSeesObjectsMovedAfterAppending){
+    World w = defaultWorld();
+    Ray r(Point(0, 5, -5), Vector(0, 0, 1));
+    EXPECT_EQ(w.RayIntersection(r).size(), 0);
+
+    // Moving a shape after the world was intersected has to be committed, changing the object list is committed by the
+    // next query
+    w.getObjects().at(1)->setTransform(translationMatrix(0, 5, 0));
+    w.commit();
+    EXPECT_EQ(w.RayIntersection(r).size(), 2);
+
+    Sphere* s = new Sphere;
+    s->setTransform(translationMatrix(0, 5, 5));
+    w.appendObject(s);
+    EXPECT_EQ(w.RayIntersection(r).size(), 4);
+}
+
+TEST(WorldTest, ObjectsThatDoNotCastShadowsAreIgnored){
+    World w = defaultWorld();
+    Point p(10, -10, 10);
+    EXPECT_TRUE(w.hasShadow(p));
+
+    for(Shape* s : w.getObjects()){
+        Material m = s->getMaterial();
+        m.castsShadow = false;
+        s->setMaterial(m);
+    }
+    EXPECT_FALSE(w.hasShadow(p));
+}
+
+TEST(WorldTest, isOccludedOnlyChecksUpToTmax){
+    World w = defaultWorld();
+    Ray r(Point(0, 0, -5), Vector(0, 0, 1));
+
+    EXPECT_TRUE(w.isOccluded(r, 10));
+    EXPECT_TRUE(w.isOccluded(r, 4.1));
+    EXPECT_FALSE(w.isOccluded(r, 3.9));
+    // Intersections behind the ray do not count
+    EXPECT_FALSE(w.isOccluded(Ray(Point(0, 0, 5), Vector(0, 0, 1)), 10));
+}
+
+// Nested groups with a sphere and a CSG at the bottom
+static Group* nestedGroups(Sphere* &s, CSG* &c){
+    Group* outer = new Group;
+    outer->setTransform(translationMatrix(0, 0, 5)*xRotationMatrix(PI/2));
+    Group* middle = new Group;
+    middle->setTransform(scalingMatrix(1, 2, 3));
+    Group* inner = new Group;
+    inner->setTransform(yRotationMatrix(PI/4));
+    s = new Sphere;
+    s->setTransform(translationMatrix(5, 0, 0));
+    Cube* cube = new Cube;
+    cube->setTransform(translationMatrix(0.5, 0, 0));
+    c = new CSG(DIFFERENCE, new Sphere, cube);
+    c->setTransform(translationMatrix(-5, 0, 0));
+    inner->appendShape(s);
+    inner->appendShape(c);
+    middle->appendShape(inner);
+    outer->appendShape(middle);
+    return outer;
+}
+
+TEST(WorldTest, CommitBakesWorldTransforms){
+    Sphere* s;
+    CSG* c;
+    Group* g = nestedGroups(s, c);
+    World w;
+    w.appendObject(g);
+
+    Point p(1, 2, 3);
+    Point objectPoint = s->worldToObject(p);
+    Vector normal = s->normalToWorld(Vector(1, 1, 0));
+    Vector csgNormal = c->getLeft()->normalToWorld(Vector(0, 1, 1));
+    EXPECT_FALSE(s->isCommitted());
+    EXPECT_FALSE(w.isCommitted());
+
+    w.commit();
+    EXPECT_TRUE(w.isCommitted());
+    EXPECT_TRUE(s->isCommitted());
+    EXPECT_TRUE(c->getLeft()->isCommitted());
+    EXPECT_TRUE(s->worldToObject(p).isEqual(objectPoint));
+    EXPECT_TRUE(s->normalToWorld(Vector(1, 1, 0)).isEqual(normal));
+    EXPECT_TRUE(c->getLeft()->normalToWorld(Vector(0, 1, 1)).isEqual(csgNormal));
+}
+
+// The committed world should find the same hits as intersecting the groups directly
+TEST(WorldTest, CommittedWorldMatchesHierarchy){
+    Sphere* s;
+    CSG* c;
+    Group* g = nestedGroups(s, c);
+    World w;
+    w.appendObject(g);
+    w.appendObject(new Plane);
+
+    // The sphere ends up around (3.5, 10.6, 5) and the CSG around (-3.5, -10.6, 5)
+    int hits = 0;
+    for(int i = -20; i <= 20; i++){
+        Ray r(Point(i*0.5, i > 0 ? 10 : -10, -20), Vector(0, i > 0 ? 0.02 : -0.02, 1).normalize());
+        std::vector<Intersection> expected = g->findIntersections(r);
+        std::vector<Intersection> planeHits = Plane().findIntersections(r);
+        std::vector<Intersection> xs = w.RayIntersection(r);
+        ASSERT_EQ(xs.size(), expected.size() + planeHits.size());
+
+        int e = 0;
+        for(int j = 0; j < xs.size(); j++){
+            if(xs.at(j).getShape() == s || xs.at(j).getShape()->getParent() == c){
+                EXPECT_TRUE(xs.at(j).isEqual(expected.at(e++)));
+            }
+        }
+        EXPECT_EQ(e, expected.size());
+        hits += expected.size();
+
+        Intersection closest(0, nullptr);
+        if(w.findClosestHit(r, 0, INFINITY, closest)){
+            EXPECT_TRUE(floatIsEqual(closest.getTime(), xs.at(hit(xs)).getTime()));
+        }
+    }
+    EXPECT_GT(hits, 4);
+}
+
+TEST(WorldTest, ChangesAfterCommitAreCommittedAgain){
+    Sphere* s;
+    CSG* c;
+    Group* g = nestedGroups(s, c);
+    World w;
+    w.appendObject(g);
+    w.commit();
+
+    Ray r(Point(0, 10, 5), Vector(0, -1, 0));
+    EXPECT_EQ(w.RayIntersection(r).size(), 0);
+
+    // Moves the sphere back to the origin of the inner group
+    s->setTransform(Matrix4());
+    EXPECT_FALSE(w.isCommitted());
+    EXPECT_FALSE(s->isCommitted());
+    w.commit();
+    EXPECT_EQ(w.RayIntersection(r).size(), 2);
+    EXPECT_TRUE(w.isCommitted());
+
+    Sphere* other = new Sphere;
+    other->setTransform(translationMatrix(0, 20, 5));
+    g->appendShape(other);
+    EXPECT_FALSE(w.isCommitted());
+    w.commit();
+    EXPECT_EQ(w.RayIntersection(Ray(Point(0, 30, 25), Vector(0, -1, 0))).size(), 2);
+}
+
+// Each world keeps track of its own objects, committing one world does not change whether another is committed
+TEST(WorldTest, WorldsAreCommittedSeparately){
+    Sphere* shared = new Sphere;
+    Sphere* other = new Sphere;
+    World a, b;
+    a.appendObject(shared);
+    b.appendObject(shared);
+    b.appendObject(other);
+    a.commit();
+    b.commit();
+
+    other->setTransform(translationMatrix(0, 5, 0));
+    EXPECT_TRUE(a.isCommitted());
+    EXPECT_FALSE(b.isCommitted());
+    b.commit();
+    EXPECT_TRUE(a.isCommitted());
+    EXPECT_TRUE(b.isCommitted());
+
+    shared->setTransform(translationMatrix(0, -5, 0));
+    EXPECT_FALSE(a.isCommitted());
+    EXPECT_FALSE(b.isCommitted());
+    delete shared;
+    delete other;
+}